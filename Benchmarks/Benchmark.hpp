@@ -0,0 +1,75 @@
+#ifndef BENCHMARK_HPP
+#define BENCHMARK_HPP
+
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * Tiny benchmark registry.
+ *
+ * Benchmarks register themselves with a static Benchmark object, similar to
+ * the go_bandit macro of the unit tests. Every benchmark measures what it
+ * needs with measure() and prints its results with report().
+ */
+class Benchmark final
+{
+public:
+    using Function = std::function<void()>;
+
+    Benchmark(const std::string &name, const Function &fn)
+    {
+        registry().push_back({name, fn});
+    }
+
+    // runs all benchmarks whose name contains the filter
+    static int run(const std::string &filter = {})
+    {
+        for (auto&& entry : registry())
+        {
+            if (!filter.empty() && entry.name.find(filter) == std::string::npos)
+            {
+                continue;
+            }
+
+            std::cout << entry.name << std::endl;
+            entry.fn();
+            std::cout << std::endl;
+        }
+        return 0;
+    }
+
+    // wall clock time of fn in seconds
+    template<typename Function>
+    static double measure(const Function &fn)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double>(end - start).count();
+    }
+
+    static void report(const std::string &what, const double &value, const std::string &unit)
+    {
+        std::cout << "    " << std::left << std::setw(40) << what
+                  << std::right << std::setw(14) << std::fixed << std::setprecision(3) << value
+                  << " " << unit << std::endl;
+    }
+
+private:
+    struct Entry {
+        std::string name;
+        Function fn;
+    };
+
+    static std::vector<Entry> &registry()
+    {
+        static std::vector<Entry> entries;
+        return entries;
+    }
+};
+
+#endif // BENCHMARK_HPP
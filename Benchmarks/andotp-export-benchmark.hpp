@@ -0,0 +1,54 @@
+#ifndef ANDOTPEXPORTBENCHMARK_HPP
+#define ANDOTPEXPORTBENCHMARK_HPP
+
+#include "Benchmark.hpp"
+
+#include <AppSupport.hpp>
+#include <TokenDatabase.hpp>
+
+#include <cstdio>
+
+static Benchmark andOTPExportBenchmark("andOTP: encrypted export", []{
+    const std::string path = "tokens.benchmark.db";
+    const std::string file = "andotp.benchmark.json.aes";
+    TokenDatabase::setPassword("benchmark");
+    TokenDatabase::setTokenDatabase(path);
+    TokenDatabase::initializeTokens();
+
+    const std::size_t count = 50000;
+    TokenDatabase::OTPTokenList tokens;
+    tokens.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        tokens.emplace_back(OTPToken::TOTP, "token " + std::to_string(i), OTPToken::Icon(), "HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ");
+    }
+    TokenDatabase::insertTokens(tokens);
+    tokens.clear();
+    tokens.shrink_to_fit();
+
+    // token list in memory, serialized at once
+    const auto list = Benchmark::measure([&]{
+        const auto selected = TokenDatabase::selectTokens();
+        std::vector<OTPToken*> pointers;
+        for (auto&& token : selected)
+        {
+            pointers.push_back(const_cast<OTPToken*>(&token));
+        }
+        AppSupport::andOTP::exportTokens(file, pointers, AppSupport::andOTP::Encrypted, "secret");
+    });
+
+    // database cursor streamed into the cipher
+    const auto streamed = Benchmark::measure([&]{
+        AppSupport::andOTP::exportDatabase(file, AppSupport::andOTP::Encrypted, "secret");
+    });
+
+    Benchmark::report("selectTokens() + exportTokens(), 50k", list * 1000.0, "ms");
+    Benchmark::report("exportDatabase(), 50k", streamed * 1000.0, "ms");
+    Benchmark::report("exportDatabase() throughput", count / streamed, "tokens/s");
+
+    TokenDatabase::closeDatabase();
+    std::remove(file.c_str());
+    std::remove(path.c_str());
+});
+
+#endif // ANDOTPEXPORTBENCHMARK_HPP
@@ -0,0 +1,112 @@
+#ifndef CODEPUBLISHERBENCHMARK_HPP
+#define CODEPUBLISHERBENCHMARK_HPP
+
+#include "Benchmark.hpp"
+
+#include <CodePublisher.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// runs reader threads for the given time while a writer republishes every
+// millisecond, returns the total number of reads per second
+template<typename Read, typename Write>
+static double codeReaderThroughput(const unsigned &readers, const Read &read, const Write &write)
+{
+    std::atomic<bool> running{true};
+    std::atomic<std::uint64_t> reads{0};
+    std::atomic<std::size_t> checksums{0}; // keeps the reads from being optimized out
+
+    std::thread writer([&]{
+        std::time_t time = 1536573862;
+        while (running.load(std::memory_order_relaxed))
+        {
+            write(++time);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (auto i = 0U; i < readers; ++i)
+    {
+        threads.emplace_back([&, i]{
+            std::uint64_t count = 0;
+            std::size_t checksum = 0;
+            while (running.load(std::memory_order_relaxed))
+            {
+                checksum += read(i + count);
+                ++count;
+            }
+            reads.fetch_add(count);
+            checksums.fetch_add(checksum);
+        });
+    }
+
+    const auto duration = std::chrono::milliseconds(250);
+    std::this_thread::sleep_for(duration);
+    running = false;
+
+    for (auto&& t : threads)
+    {
+        t.join();
+    }
+    writer.join();
+
+    return static_cast<double>(reads.load()) / std::chrono::duration<double>(duration).count();
+}
+
+static Benchmark codePublisherBenchmark("CodePublisher: reader contention", []{
+    TokenTable table;
+    for (auto i = 0; i < 200; ++i)
+    {
+        table.append(OTPToken(OTPToken::TOTP, "publisher benchmark token " + std::to_string(i), {}, "JBSWY3DPEHPK3PXP"));
+    }
+    const auto shared = std::make_shared<const TokenTable>(std::move(table));
+
+    CodePublisher publisher([]{ return std::time_t(1536573862); });
+    publisher.setTable(shared);
+
+    // baseline: snapshot behind a plain mutex, readers copy the shared_ptr;
+    // the writer computes the snapshots with its own publisher, so both
+    // writers take the same share of the CPU
+    std::mutex mutex;
+    CodePublisher baseline([]{ return std::time_t(1536573862); });
+    baseline.setTable(shared);
+    auto locked = baseline.read();
+
+    for (auto&& readers : {1U, 2U, 4U, 8U, 16U})
+    {
+        const auto rcu = codeReaderThroughput(readers, [&](const std::size_t &n) {
+            const auto snapshot = publisher.read();
+            return snapshot->codes[n % snapshot->size()].size();
+        }, [&](const std::time_t &time) {
+            publisher.update(time);
+        });
+
+        const auto mutexed = codeReaderThroughput(readers, [&](const std::size_t &n) {
+            std::shared_ptr<const CodeSnapshot> snapshot;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                snapshot = locked;
+            }
+            return snapshot->codes[n % snapshot->size()].size();
+        }, [&](const std::time_t &time) {
+            baseline.update(time);
+            auto next = baseline.read();
+            std::lock_guard<std::mutex> lock(mutex);
+            locked = std::move(next);
+        });
+
+        const auto threads = std::to_string(readers) + (readers == 1 ? " reader" : " readers");
+        Benchmark::report("read(), " + threads, rcu / 1e6, "M reads/s");
+        Benchmark::report("mutex + shared_ptr, " + threads, mutexed / 1e6, "M reads/s");
+    }
+
+    Benchmark::report("retired snapshots left", publisher.pendingReclamation(), "");
+});
+
+#endif // CODEPUBLISHERBENCHMARK_HPP
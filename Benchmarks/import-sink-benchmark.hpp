@@ -0,0 +1,87 @@
+#ifndef IMPORTSINKBENCHMARK_HPP
+#define IMPORTSINKBENCHMARK_HPP
+
+#include "Benchmark.hpp"
+
+#include <ImportSink.hpp>
+#include <TokenDatabase.hpp>
+
+#include <cstdio>
+#include <fstream>
+
+// synthetic andOTP backup with unique labels
+static void writeSyntheticAndOTPBackup(const std::string &file, const std::size_t &count)
+{
+    static const char *secrets[] = {"HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ", "JBSWY3DPEHPK3PXP", "GEZDGNBVGY3TQOJQ"};
+
+    std::ofstream out(file);
+    out << "[";
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        out << (i == 0 ? "" : ",")
+            << R"({"secret":")" << secrets[i % 3] << R"(","label":"token )" << i
+            << R"(","period":30,"digits":6,"type":"TOTP","algorithm":"SHA1",)"
+            << R"("thumbnail":"Default","last_used":0,"tags":[]})";
+    }
+    out << "]";
+}
+
+static Benchmark importSinkBenchmark("ImportSink: andOTP backup", []{
+    const std::string backup = "andotp.benchmark.json";
+    const std::string path = "tokens.benchmark.db";
+    TokenDatabase::setPassword("benchmark");
+    TokenDatabase::setTokenDatabase(path);
+
+    // one insertToken() per token, every insert rewrites the display order
+    {
+        const std::size_t count = 5000;
+        writeSyntheticAndOTPBackup(backup, count);
+        TokenDatabase::initializeTokens();
+
+        const auto seconds = Benchmark::measure([&]{
+            std::vector<OTPToken*> tokens;
+            AppSupport::andOTP::importTokens(backup, tokens);
+            for (auto&& token : tokens)
+            {
+                if (token->isValid())
+                {
+                    TokenDatabase::insertToken(*token);
+                }
+                delete token;
+            }
+            TokenDatabase::saveTokens();
+        });
+
+        Benchmark::report("insertToken() loop, 5k tokens", seconds * 1000.0, "ms");
+        Benchmark::report("insertToken() loop throughput", count / seconds, "tokens/s");
+        TokenDatabase::closeDatabase();
+    }
+
+    // ImportSink pipeline
+    {
+        const std::size_t count = 50000;
+        writeSyntheticAndOTPBackup(backup, count);
+        TokenDatabase::initializeTokens();
+
+        ImportSink sink;
+        sink.reserve(count);
+
+        const auto parse = Benchmark::measure([&]{
+            AppSupport::andOTP::importTokens(backup, sink);
+        });
+        const auto commit = Benchmark::measure([&]{
+            sink.commit();
+        });
+
+        Benchmark::report("ImportSink parse, 50k tokens", parse * 1000.0, "ms");
+        Benchmark::report("ImportSink commit, 50k tokens", commit * 1000.0, "ms");
+        Benchmark::report("ImportSink throughput", count / (parse + commit), "tokens/s");
+        Benchmark::report("imported tokens", sink.statistics().imported, "");
+        TokenDatabase::closeDatabase();
+    }
+
+    std::remove(backup.c_str());
+    std::remove(path.c_str());
+});
+
+#endif // IMPORTSINKBENCHMARK_HPP
@@ -0,0 +1,26 @@
+#include "Benchmark.hpp"
+
+#include <iostream>
+
+#include "import-sink-benchmark.hpp"
+#include "andotp-export-benchmark.hpp"
+#include "otpauth-benchmark.hpp"
+#include "token-allocation-benchmark.hpp"
+#include "token-table-benchmark.hpp"
+#include "code-publisher-benchmark.hpp"
+
+#ifdef OTPGEN_WITH_QR_CODES
+#include "qrcode-export-benchmark.hpp"
+#endif
+
+#ifdef OTPGEN_WITH_MIGRATION_TOOL
+#include "migration-benchmark.hpp"
+#endif
+
+int main(int argc, char **argv)
+{
+    std::cout << "OTPGen Benchmarks" << std::endl << std::endl;
+
+    // optional name filter as first argument
+    return Benchmark::run(argc > 1 ? argv[1] : std::string());
+}
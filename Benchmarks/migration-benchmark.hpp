@@ -0,0 +1,113 @@
+#ifndef MIGRATIONBENCHMARK_HPP
+#define MIGRATIONBENCHMARK_HPP
+
+#include "Benchmark.hpp"
+
+#include <Migration.hpp>
+#include <OldFormat/TokenDatabase_Old.hpp>
+
+#include <cstdio>
+#include <memory>
+
+// synthetic old format store with unique labels, every 10th token has an icon
+static void fillSyntheticOldStore(const std::size_t &count)
+{
+    static const char *secrets[] = {"HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ", "JBSWY3DPEHPK3PXP", "GEZDGNBVGY3TQOJQ"};
+    const OTPToken_Old::Icon icon(2048, '\x7f');
+
+    auto &tokens = TokenStore_Old::i()->tokens();
+    tokens.clear();
+    tokens.reserve(count);
+
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        const auto label = "token " + std::to_string(i);
+        const auto &tokenIcon = i % 10 == 0 ? icon : OTPToken_Old::Icon();
+        const auto secret = secrets[i % 3];
+
+        // added directly, addToken() searches the whole store for every token
+        switch (i % 4)
+        {
+            case 0: tokens.emplace_back(std::make_shared<TOTPToken_Old>(label, tokenIcon, secret, 6, 30, 0, OTPToken_Old::SHA1)); break;
+            case 1: tokens.emplace_back(std::make_shared<HOTPToken_Old>(label, tokenIcon, secret, 6, 0, i, OTPToken_Old::SHA256)); break;
+            case 2: tokens.emplace_back(std::make_shared<SteamToken_Old>(label, tokenIcon, secret, 5, 30, 0, OTPToken_Old::SHA1)); break;
+            case 3: tokens.emplace_back(std::make_shared<AuthyToken_Old>(label, tokenIcon, secret, 7, 10, 0, OTPToken_Old::SHA1)); break;
+        }
+    }
+}
+
+static Benchmark migrationBenchmark("Migration: old format store", []{
+    const std::string oldPath = "tokens.benchmark.old";
+    const std::string path = "tokens.benchmark.db";
+    const std::size_t count = 100000;
+
+    TokenDatabase_Old::setPassword("benchmark");
+    TokenDatabase_Old::setTokenFile(oldPath);
+    TokenDatabase::setPassword("benchmark");
+    TokenDatabase::setTokenDatabase(path);
+
+    // one insertToken() per token, every insert rewrites the display order
+    {
+        const std::size_t legacyCount = 5000;
+        fillSyntheticOldStore(legacyCount);
+        TokenDatabase::initializeTokens();
+
+        const auto seconds = Benchmark::measure([&]{
+            for (auto&& token : TokenStore_Old::i()->tokens())
+            {
+                TokenDatabase::insertToken(Migration::convert(*token));
+            }
+            TokenDatabase::saveTokens();
+        });
+
+        Benchmark::report("insertToken() loop, 5k tokens", seconds * 1000.0, "ms");
+        Benchmark::report("insertToken() loop throughput", legacyCount / seconds, "tokens/s");
+        TokenDatabase::closeDatabase();
+    }
+
+    // old store written to disk, loading it is part of every migration;
+    // the old store allowed labels which only differ in case, this one is skipped
+    fillSyntheticOldStore(count);
+    TokenStore_Old::i()->tokens().emplace_back(std::make_shared<TOTPToken_Old>("TOKEN 0", OTPToken_Old::Icon(), "JBSWY3DPEHPK3PXP", 6, 30, 0, OTPToken_Old::SHA1));
+    TokenDatabase_Old::saveTokens();
+    TokenStore_Old::i()->clear();
+
+    const auto load = Benchmark::measure([&]{
+        TokenDatabase_Old::loadTokens();
+    });
+    Benchmark::report("old format load, 100k tokens", load * 1000.0, "ms");
+
+    // bulk migration
+    TokenDatabase::initializeTokens();
+    Migration::ReferenceList reference;
+    auto status = TokenDatabase::Success;
+
+    const auto migrate = Benchmark::measure([&]{
+        status = Migration::migrate(std::cerr, &reference);
+    });
+    const auto save = Benchmark::measure([&]{
+        TokenDatabase::saveTokens();
+    });
+
+    Benchmark::report("bulk migration, 100k tokens", migrate * 1000.0, "ms");
+    Benchmark::report("bulk migration throughput", count / migrate, "tokens/s");
+    Benchmark::report("save, 100k tokens", save * 1000.0, "ms");
+    Benchmark::report("migrated tokens", status == TokenDatabase::Success ? TokenDatabase::tokenCount() : 0, "");
+
+    // verify against the written file
+    TokenDatabase::closeDatabase();
+    std::size_t mismatches = 0;
+    const auto verify = Benchmark::measure([&]{
+        TokenDatabase::loadTokens();
+        mismatches = Migration::verify(reference, 1536573862, std::cerr);
+    });
+
+    Benchmark::report("reload and verify, 100k tokens", verify * 1000.0, "ms");
+    Benchmark::report("mismatches", mismatches, "");
+    TokenDatabase::closeDatabase();
+
+    std::remove(oldPath.c_str());
+    std::remove(path.c_str());
+});
+
+#endif // MIGRATIONBENCHMARK_HPP
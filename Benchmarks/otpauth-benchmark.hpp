@@ -0,0 +1,102 @@
+#ifndef OTPAUTHBENCHMARK_HPP
+#define OTPAUTHBENCHMARK_HPP
+
+#include "Benchmark.hpp"
+
+#include <otpauthURI.hpp>
+#include <otpauthURIView.hpp>
+
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+
+// the former substr + std::regex parameter split, kept for comparison
+static std::size_t legacyParseOtpauth(const std::string &input)
+{
+    static const std::string prefix = "otpauth://";
+    if (input.compare(0, prefix.size(), prefix) != 0)
+    {
+        return 0;
+    }
+
+    const auto uri = input.substr(prefix.size());
+    auto delim = uri.find_first_of('/');
+    const auto type = uri.substr(0, delim);
+    ++delim;
+    const auto delim2 = uri.find_first_of('?', delim);
+    const auto label = uri.substr(delim, delim2 - delim);
+    const auto params_str = uri.substr(delim2 + 1);
+
+    std::regex re(R"(\&)");
+    std::sregex_token_iterator first{
+        params_str.begin(), params_str.end(), re, -1
+    }, last;
+    std::vector<std::string> params_vec = {first, last};
+
+    std::map<std::string, std::string> params;
+    for (auto&& p : params_vec)
+    {
+        const auto eq = p.find('=');
+        if (eq != std::string::npos)
+        {
+            params.insert({p.substr(0, eq), p.substr(eq + 1)});
+        }
+    }
+    return params.size() + type.size() + label.size();
+}
+
+static Benchmark otpauthParseBenchmark("otpauth URI: parsing", []{
+    const std::size_t count = 100000;
+
+    std::string lines;
+    std::vector<std::string> uris;
+    uris.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        uris.emplace_back("otpauth://totp/ACME%20Co:user" + std::to_string(i) +
+                          "@example.com?secret=HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ&issuer=ACME%20Co&algorithm=SHA256&digits=6&period=30");
+        lines.append(uris.back()).push_back('\n');
+    }
+
+    std::size_t sink = 0;
+    const auto legacy = Benchmark::measure([&]{
+        for (auto&& uri : uris)
+        {
+            sink += legacyParseOtpauth(uri);
+        }
+    });
+
+    const auto view = Benchmark::measure([&]{
+        otpauthURIView parser;
+        for (auto&& uri : uris)
+        {
+            parser.parse(uri);
+            sink += parser.paramCount();
+        }
+    });
+
+    const auto wrapper = Benchmark::measure([&]{
+        for (auto&& uri : uris)
+        {
+            sink += otpauthURI(uri).valid();
+        }
+    });
+
+    const auto single = Benchmark::measure([&]{
+        sink += otpauthURI::parseMany(lines, 1).size();
+    });
+
+    const auto many = Benchmark::measure([&]{
+        sink += otpauthURI::parseMany(lines).size();
+    });
+
+    Benchmark::report("regex split, 100k", legacy * 1000.0, "ms");
+    Benchmark::report("otpauthURIView::parse(), 100k", view * 1000.0, "ms");
+    Benchmark::report("otpauthURI(), 100k", wrapper * 1000.0, "ms");
+    Benchmark::report("parseMany(), 1 thread, 100k", single * 1000.0, "ms");
+    Benchmark::report("parseMany(), all threads, 100k", many * 1000.0, "ms");
+    Benchmark::report("checksum", static_cast<double>(sink % 1000), "");
+});
+
+#endif // OTPAUTHBENCHMARK_HPP
@@ -0,0 +1,60 @@
+#ifndef QRCODEEXPORTBENCHMARK_HPP
+#define QRCODEEXPORTBENCHMARK_HPP
+
+#include "Benchmark.hpp"
+
+#include <QRCode.hpp>
+#include <TokenDatabase.hpp>
+#include <otpauthURI.hpp>
+
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+static Benchmark qrCodeExportBenchmark("QRCode: bulk export", []{
+    const std::string path = "tokens.benchmark.db";
+    const std::string directory = "qrcode-export.benchmark";
+    std::filesystem::create_directory(directory);
+    TokenDatabase::setPassword("benchmark");
+    TokenDatabase::setTokenDatabase(path);
+    TokenDatabase::initializeTokens();
+
+    const std::size_t count = 5000;
+    TokenDatabase::OTPTokenList tokens;
+    tokens.reserve(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        tokens.emplace_back(OTPToken::TOTP, "ACME Co:user" + std::to_string(i) + "@example.com", OTPToken::Icon(), "HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ");
+    }
+    TokenDatabase::insertTokens(tokens);
+
+    std::vector<QRCode::ExportItem> items;
+    items.reserve(count);
+    const auto collect = Benchmark::measure([&]{
+        TokenDatabase::forEachToken([&](const OTPToken &token) {
+            std::string uri;
+            if (otpauthURI::write(token, uri))
+            {
+                items.push_back({token.id(), token.label(), uri});
+            }
+        });
+    });
+
+    const auto png = Benchmark::measure([&]{
+        QRCode::exportTokens(directory, QRCode::PNG, items);
+    });
+    const auto svg = Benchmark::measure([&]{
+        QRCode::exportTokens(directory, QRCode::SVG, items);
+    });
+
+    Benchmark::report("collect otpauth URIs, 5k", collect * 1000.0, "ms");
+    Benchmark::report("exportTokens() PNG, 5k", png * 1000.0, "ms");
+    Benchmark::report("exportTokens() SVG, 5k", svg * 1000.0, "ms");
+    Benchmark::report("PNG throughput", count / png, "tokens/s");
+
+    TokenDatabase::closeDatabase();
+    std::filesystem::remove_all(directory);
+    std::remove(path.c_str());
+});
+
+#endif // QRCODEEXPORTBENCHMARK_HPP
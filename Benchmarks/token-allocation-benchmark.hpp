@@ -0,0 +1,115 @@
+#ifndef TOKENALLOCATIONBENCHMARK_HPP
+#define TOKENALLOCATIONBENCHMARK_HPP
+
+#include "Benchmark.hpp"
+
+#include <ImportSink.hpp>
+#include <TokenDatabase.hpp>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+// counts every heap allocation of the process, this header must only be
+// included once (from main.cpp)
+// secrets are allocated from the SecureArena and aren't counted
+static std::atomic<std::size_t> heap_allocations{0};
+
+void *operator new(std::size_t size)
+{
+    heap_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (auto ptr = std::malloc(size == 0 ? 1 : size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+template<typename Function>
+static std::size_t countAllocations(const Function &fn)
+{
+    const auto before = heap_allocations.load(std::memory_order_relaxed);
+    fn();
+    return heap_allocations.load(std::memory_order_relaxed) - before;
+}
+
+static Benchmark tokenAllocationBenchmark("TokenDatabase: token list allocations", []{
+    const std::string path = "tokens.allocations.db";
+    const std::size_t count = 10000;
+    TokenDatabase::setPassword("benchmark");
+    TokenDatabase::setTokenDatabase(path);
+    TokenDatabase::initializeTokens();
+
+    // labels longer than the small string buffer and a 2 KiB icon per token
+    {
+        const OTPToken::Icon icon(2048, 0x5a);
+        ImportSink sink;
+        sink.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            OTPToken token(OTPToken::TOTP, "allocation benchmark token " + std::to_string(i), icon, "JBSWY3DPEHPK3PXP");
+            sink.add(std::move(token));
+        }
+        sink.commit();
+    }
+
+    TokenDatabase::OTPTokenList tokens;
+    std::size_t allocations = 0;
+
+    const auto select = Benchmark::measure([&]{
+        allocations = countAllocations([&]{
+            tokens = TokenDatabase::selectTokens();
+        });
+    });
+    Benchmark::report("selectTokens(), 10k tokens", select * 1000.0, "ms");
+    Benchmark::report("selectTokens() allocations per token", double(allocations) / count, "");
+
+    std::size_t visited = 0;
+    const auto each = Benchmark::measure([&]{
+        allocations = countAllocations([&]{
+            TokenDatabase::forEachToken([&](const OTPToken &) { ++visited; });
+        });
+    });
+    Benchmark::report("forEachToken(), 10k tokens", each * 1000.0, "ms");
+    Benchmark::report("forEachToken() allocations per token", double(allocations) / count, "");
+
+    // copies share the icon buffer
+    const auto copy = Benchmark::measure([&]{
+        allocations = countAllocations([&]{
+            TokenDatabase::OTPTokenList copied = tokens;
+            visited += copied.size();
+        });
+    });
+    Benchmark::report("list copy, 10k tokens", copy * 1000.0, "ms");
+    Benchmark::report("list copy allocations per token", double(allocations) / count, "");
+
+    // growing a list only moves the tokens
+    const auto move = Benchmark::measure([&]{
+        allocations = countAllocations([&]{
+            TokenDatabase::OTPTokenList moved;
+            for (auto&& token : tokens)
+            {
+                moved.emplace_back(std::move(token));
+            }
+            visited += moved.size();
+        });
+    });
+    Benchmark::report("list growth by move, 10k tokens", move * 1000.0, "ms");
+    Benchmark::report("list growth allocations per token", double(allocations) / count, "");
+
+    TokenDatabase::closeDatabase();
+    std::remove(path.c_str());
+});
+
+#endif // TOKENALLOCATIONBENCHMARK_HPP
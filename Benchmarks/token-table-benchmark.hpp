@@ -0,0 +1,119 @@
+#ifndef TOKENTABLEBENCHMARK_HPP
+#define TOKENTABLEBENCHMARK_HPP
+
+#include "Benchmark.hpp"
+
+#include <ImportSink.hpp>
+#include <TokenDatabase.hpp>
+#include <TokenTable.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+
+static Benchmark tokenTableBenchmark("TokenTable: bulk code generation", []{
+    const std::string path = "tokens.table.db";
+    const std::size_t count = 10000;
+    TokenDatabase::setPassword("benchmark");
+    TokenDatabase::setTokenDatabase(path);
+    TokenDatabase::initializeTokens();
+
+    {
+        static const char *secrets[] = {"HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ", "JBSWY3DPEHPK3PXP", "GEZDGNBVGY3TQOJQ"};
+        const OTPToken::Icon icon(2048, 0x5a);
+        ImportSink sink;
+        sink.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            sink.add(OTPToken(OTPToken::TOTP, "table benchmark token " + std::to_string(i), icon, secrets[i % 3]));
+        }
+        sink.commit();
+    }
+
+    const auto now = std::time(nullptr);
+    std::size_t generated = 0;
+
+    // per token objects, the secret is normalized and decoded for every code
+    TokenDatabase::OTPTokenList tokens;
+    TokenDatabase::forEachToken([&](const OTPToken &token) { tokens.emplace_back(token); });
+    const auto objects = Benchmark::measure([&]{
+        for (auto&& token : tokens)
+        {
+            generated += token.generateToken().size();
+        }
+    });
+    Benchmark::report("OTPToken::generateToken(), 10k tokens", objects * 1000.0, "ms");
+
+    TokenTable table;
+    const auto build = Benchmark::measure([&]{
+        TokenDatabase::selectTokenTable(table);
+    });
+    Benchmark::report("selectTokenTable(), 10k tokens", build * 1000.0, "ms");
+
+    TokenTable::CodeList codes;
+    const auto sweep = Benchmark::measure([&]{
+        table.generate(now, codes);
+    });
+    Benchmark::report("TokenTable::generate(), 10k tokens", sweep * 1000.0, "ms");
+    Benchmark::report("speedup over generateToken()", objects / sweep, "x");
+
+    const auto parallel = Benchmark::measure([&]{
+        table.generate(now, codes, 0);
+    });
+    Benchmark::report("TokenTable::generate(), all threads", parallel * 1000.0, "ms");
+
+    for (auto&& code : codes)
+    {
+        generated += code.size();
+    }
+    Benchmark::report("generated digits", generated, "");
+
+    TokenDatabase::closeDatabase();
+    std::remove(path.c_str());
+});
+
+// a filter keystroke of the GUI token list
+static Benchmark tokenFilterBenchmark("TokenTable: label filter", []{
+    const std::string path = "tokens.filter.db";
+    const std::size_t count = 50000;
+    TokenDatabase::setPassword("benchmark");
+    TokenDatabase::setTokenDatabase(path);
+    TokenDatabase::initializeTokens();
+
+    {
+        ImportSink sink;
+        sink.reserve(count);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            sink.add(OTPToken(OTPToken::TOTP, "filter benchmark token " + std::to_string(i), {}, "JBSWY3DPEHPK3PXP"));
+        }
+        sink.commit();
+    }
+
+    // all rows fetched into a table, filtered in memory afterwards
+    const auto fetchAll = Benchmark::measure([&]{
+        TokenTable table;
+        table.reserve(count);
+        TokenDatabase::forEachToken([&](const OTPToken &token) { table.append(token); });
+    });
+    Benchmark::report("fetch all rows, 50k tokens", fetchAll * 1000.0, "ms");
+
+    // matching ids selected by the database, the first page fetched
+    std::size_t matches = 0;
+    const auto selectIds = Benchmark::measure([&]{
+        TokenDatabase::DisplayOrder ids;
+        TokenDatabase::selectTokenIds(ids, "token 1");
+        TokenTable table;
+        TokenDatabase::forEachToken([&](const OTPToken &token) {
+            table.append(token);
+        }, TokenDatabase::DisplayOrder(ids.cbegin(), ids.cbegin() + static_cast<std::ptrdiff_t>(std::min<std::size_t>(256U, ids.size()))));
+        matches = ids.size();
+    });
+    Benchmark::report("selectTokenIds() + first page, 50k tokens", selectIds * 1000.0, "ms");
+    Benchmark::report("matching tokens", matches, "");
+
+    TokenDatabase::closeDatabase();
+    std::remove(path.c_str());
+});
+
+#endif // TOKENTABLEBENCHMARK_HPP
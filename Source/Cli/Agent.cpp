@@ -0,0 +1,662 @@
+#include "Agent.hpp"
+
+#if !defined(OS_WINDOWS)
+
+#include <TokenDatabase.hpp>
+#include <CodePublisher.hpp>
+#include <OTPGenErrorCodes.hpp>
+
+#include <algorithm>
+#include <climits>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#if defined(OS_LINUX)
+#include <sys/prctl.h>
+#endif
+
+const unsigned Agent::DefaultIdleTimeout = 900U;
+
+namespace {
+    // current codes for the codes command, the table is reloaded when the order changes
+    // the serving agent keeps them current on a worker thread
+    static CodePublisher code_publisher;
+    static bool code_table_valid = false;
+
+    // requests are single lines, anything larger is not a valid request
+    static const std::size_t MAX_REQUEST_SIZE = 65536U;
+
+    // state of the database file when the agent last loaded or wrote it
+    struct FileState {
+        bool known = false;
+        ino_t inode = 0;
+        off_t size = 0;
+        // nanoseconds, a same-size write within the same second must be noticed
+        struct timespec modified = {};
+    };
+    static FileState file_state;
+
+    static bool read_file_state(FileState &state)
+    {
+        struct stat info;
+        if (::stat(TokenDatabase::tokenDatabase().c_str(), &info) != 0)
+        {
+            return false;
+        }
+        state.known = true;
+        state.inode = info.st_ino;
+        state.size = info.st_size;
+#ifdef OS_MACOS
+        state.modified = info.st_mtimespec;
+#else
+        state.modified = info.st_mtim;
+#endif
+        return true;
+    }
+
+    // call after the agent loaded or wrote the database
+    static void remember_file_state()
+    {
+        if (!read_file_state(file_state))
+        {
+            file_state.known = false;
+        }
+    }
+
+    // reloads the database when another process (GUI, CLI) changed the file,
+    // force always reloads, required before writing so no change is overwritten
+    static TokenDatabase::Error refresh(const bool &force)
+    {
+        FileState current;
+        const auto exists = read_file_state(current);
+
+        // the database was loaded right before the first request
+        if (!force && !file_state.known)
+        {
+            file_state = current;
+            return TokenDatabase::Success;
+        }
+
+        if (!force && exists && current.inode == file_state.inode &&
+            current.size == file_state.size && current.modified.tv_sec == file_state.modified.tv_sec &&
+            current.modified.tv_nsec == file_state.modified.tv_nsec)
+        {
+            return TokenDatabase::Success;
+        }
+
+        const auto status = TokenDatabase::loadTokens();
+        if (status == TokenDatabase::Success)
+        {
+            code_table_valid = false;
+            file_state = current;
+        }
+        return status;
+    }
+
+    // writes the database and keeps track of the written file
+    static TokenDatabase::Error save()
+    {
+        const auto status = TokenDatabase::saveTokens();
+        remember_file_state();
+        return status;
+    }
+
+    static std::string refresh_error(const TokenDatabase::Error &status)
+    {
+        return "Unable to reload the token database, restart the agent: " + TokenDatabase::getErrorMessage(status) + "\n";
+    }
+
+    static volatile std::sig_atomic_t terminate_requested = 0;
+
+    static void request_termination(int)
+    {
+        terminate_requested = 1;
+    }
+
+    static bool make_address(const std::string &socket, sockaddr_un &address)
+    {
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (socket.empty() || socket.size() >= sizeof(address.sun_path))
+        {
+            return false;
+        }
+        std::memcpy(address.sun_path, socket.c_str(), socket.size());
+        return true;
+    }
+
+    static int connect_socket(const std::string &socket)
+    {
+        sockaddr_un address;
+        if (!make_address(socket, address))
+        {
+            return -1;
+        }
+
+        const auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd == -1)
+        {
+            return -1;
+        }
+
+        if (::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            ::close(fd);
+            return -1;
+        }
+
+        return fd;
+    }
+
+    static bool write_all(const int &fd, const std::string &data)
+    {
+        std::size_t written = 0;
+        while (written < data.size())
+        {
+            const auto res = ::send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+            if (res <= 0)
+            {
+                return false;
+            }
+            written += static_cast<std::size_t>(res);
+        }
+        return true;
+    }
+
+    // reads until EOF, or until the first newline when line is true
+    static bool read_all(const int &fd, std::string &data, const bool &line)
+    {
+        char buffer[4096];
+        for (;;)
+        {
+            const auto res = ::recv(fd, buffer, sizeof(buffer), 0);
+            if (res < 0)
+            {
+                return false;
+            }
+            if (res == 0)
+            {
+                return true;
+            }
+
+            data.append(buffer, static_cast<std::size_t>(res));
+            if (data.size() > MAX_REQUEST_SIZE && line)
+            {
+                return false;
+            }
+            if (line && data.find('\n') != std::string::npos)
+            {
+                return true;
+            }
+        }
+    }
+
+    static Agent::Command split(const std::string &line)
+    {
+        Agent::Command fields;
+        std::size_t pos = 0;
+        for (;;)
+        {
+            const auto end = line.find('\t', pos);
+            fields.emplace_back(line.substr(pos, end - pos));
+            if (end == std::string::npos)
+            {
+                break;
+            }
+            pos = end + 1;
+        }
+        return fields;
+    }
+}
+
+std::string Agent::socketPath(const std::string &configDirectory)
+{
+    const auto env = std::getenv("OTPGEN_AGENT_SOCKET");
+    if (env && env[0] != '\0')
+    {
+        return env;
+    }
+
+    const auto runtime = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime && runtime[0] != '\0')
+    {
+        return std::string(runtime) + "/otpgen-agent.socket";
+    }
+
+    return configDirectory + "/agent.socket";
+}
+
+bool Agent::commandFromArguments(const std::vector<std::string> &args, Command &command)
+{
+    if (args.size() < 2)
+    {
+        return false;
+    }
+
+    const auto &op = args.at(1);
+    if (op == "--list" && args.size() == 2)
+    {
+        command = {"list"};
+    }
+    else if (op == "--code" && args.size() == 3)
+    {
+        command = {"code", args.at(2)};
+    }
+    else if (op == "--codes" && args.size() == 2)
+    {
+        command = {"codes"};
+    }
+    else if (op == "--swap" && args.size() == 4)
+    {
+        command = {"swap", args.at(2), args.at(3)};
+    }
+    else if (op == "--move" && args.size() == 4)
+    {
+        command = {"move", args.at(2), args.at(3)};
+    }
+    else if (op == "--stop-agent" && args.size() == 2)
+    {
+        command = {"stop"};
+    }
+    else
+    {
+        return false;
+    }
+
+    return true;
+}
+
+Agent::Response Agent::execute(const Command &command)
+{
+    Response response;
+
+    if (command.empty())
+    {
+        response.output = "Empty request.\n";
+        return response;
+    }
+
+    const auto &op = command.at(0);
+
+    // stopping must work even when the database can't be reloaded anymore
+    // (deleted or re-keyed by a password change)
+    if (op == "stop" && command.size() == 1)
+    {
+        response.success = true;
+        response.output = "Agent stopped.\n";
+        return response;
+    }
+
+    // other processes may have changed the database since it was loaded,
+    // writing commands reload it unconditionally
+    const auto writes = op == "swap" || op == "move";
+    const auto status = refresh(writes);
+    if (status != TokenDatabase::Success)
+    {
+        response.output = refresh_error(status);
+        return response;
+    }
+
+    if (op == "list" && command.size() == 1)
+    {
+        const auto status = TokenDatabase::forEachToken([&](const OTPToken &token) {
+            response.output.append(token.label());
+            response.output.push_back('\n');
+        });
+        response.success = status == TokenDatabase::Success;
+        if (!response.success)
+        {
+            response.output = TokenDatabase::getErrorMessage(status) + "\n";
+        }
+    }
+    else if (op == "code" && command.size() == 2)
+    {
+        auto token = TokenDatabase::selectToken(command.at(1));
+        if (token.label().empty())
+        {
+            response.output = "No token with the label \"" + command.at(1) + "\" found.\n";
+            return response;
+        }
+
+        // HOTP codes are only valid once, the counter is advanced and stored
+        const auto hotp = token.type() == OTPToken::HOTP;
+        if (hotp)
+        {
+            const auto reloaded = refresh(true);
+            if (reloaded != TokenDatabase::Success)
+            {
+                response.output = refresh_error(reloaded);
+                return response;
+            }
+            token = TokenDatabase::selectToken(command.at(1));
+        }
+
+        auto error = OTPGenErrorCode::Valid;
+        const auto code = token.generateToken(&error);
+        response.success = !code.empty() && error == OTPGenErrorCode::Valid;
+        response.output = response.success ? code + "\n" : "Failed to generate a code for \"" + command.at(1) + "\".\n";
+
+        if (response.success && hotp)
+        {
+            code_table_valid = false;
+            token.increaseCounter();
+            auto res = TokenDatabase::updateToken(token.id(), token);
+            if (res == TokenDatabase::Success)
+            {
+                res = save();
+            }
+            if (res != TokenDatabase::Success)
+            {
+                response.success = false;
+                response.output = "Error: unable to store the HOTP counter: " + TokenDatabase::getErrorMessage(res) + "\n";
+            }
+        }
+    }
+    else if (op == "codes" && command.size() == 1)
+    {
+        if (!code_table_valid)
+        {
+            TokenTable table;
+            const auto status = TokenDatabase::selectTokenTable(table);
+            if (status != TokenDatabase::Success)
+            {
+                response.output = TokenDatabase::getErrorMessage(status) + "\n";
+                return response;
+            }
+            code_publisher.setTable(std::move(table));
+            code_table_valid = true;
+        }
+
+        const auto now = std::time(nullptr);
+        if (!code_publisher.running())
+        {
+            code_publisher.update(now);
+        }
+
+        // code, remaining seconds and label per line
+        const auto current = code_publisher.read();
+        for (TokenTable::Index row = 0; row < current->size(); ++row)
+        {
+            response.output.append(current->codes[row].empty() ? "-" : current->codes[row]);
+            response.output.push_back('\t');
+            response.output.append(std::to_string(current->remaining(row, now)));
+            response.output.push_back('\t');
+            response.output.append(current->table->label(row));
+            response.output.push_back('\n');
+        }
+        response.success = true;
+    }
+    else if (op == "swap" && command.size() == 3)
+    {
+        code_table_valid = false;
+        auto res = TokenDatabase::swapTokens(command.at(1), command.at(2));
+        if (res == TokenDatabase::Success)
+        {
+            res = save();
+        }
+        response.success = res == TokenDatabase::Success;
+        response.output = response.success
+            ? "Swapped \"" + command.at(1) + "\" with \"" + command.at(2) + "\".\n"
+            : "Error: " + TokenDatabase::getErrorMessage(res) + "\n";
+    }
+    else if (op == "move" && command.size() == 3)
+    {
+        code_table_valid = false;
+        auto res = TokenDatabase::UnknownFailure;
+        try {
+            res = TokenDatabase::moveToken(command.at(1), std::stoul(command.at(2)));
+        } catch (...) {
+            res = TokenDatabase::moveTokenBelow(command.at(1), command.at(2));
+        }
+        if (res == TokenDatabase::Success)
+        {
+            res = save();
+        }
+        response.success = res == TokenDatabase::Success;
+        response.output = response.success
+            ? "Move operation successful.\n"
+            : "Error: " + TokenDatabase::getErrorMessage(res) + "\n";
+    }
+    else
+    {
+        response.output = "Unknown request.\n";
+    }
+
+    return response;
+}
+
+bool Agent::request(const std::string &socket, const Command &command, Response &response)
+{
+    std::string line;
+    for (std::size_t i = 0; i < command.size(); ++i)
+    {
+        // fields can't contain the separators of the protocol
+        if (command[i].find_first_of("\t\n") != std::string::npos)
+        {
+            return false;
+        }
+        if (i != 0)
+        {
+            line.push_back('\t');
+        }
+        line.append(command[i]);
+    }
+    line.push_back('\n');
+
+    const auto fd = connect_socket(socket);
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    std::string data;
+    const auto ok = write_all(fd, line) && ::shutdown(fd, SHUT_WR) == 0 && read_all(fd, data, false);
+    ::close(fd);
+
+    const auto newline = data.find('\n');
+    if (!ok || newline == std::string::npos)
+    {
+        return false;
+    }
+
+    response.success = data.compare(0, newline, "OK") == 0;
+    response.output = data.substr(newline + 1);
+    return true;
+}
+
+int Agent::start(const std::string &socket, const unsigned &idleTimeout)
+{
+    sockaddr_un address;
+    if (!make_address(socket, address))
+    {
+        std::cerr << "Invalid agent socket path: " << socket << std::endl;
+        return 1;
+    }
+
+    // refuse to replace a running agent, remove stale sockets
+    const auto running = connect_socket(socket);
+    if (running != -1)
+    {
+        ::close(running);
+        std::cerr << "An agent is already running on " << socket << std::endl;
+        return 1;
+    }
+    ::unlink(socket.c_str());
+
+    // the database was loaded by the caller
+    remember_file_state();
+
+    const auto server = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server == -1)
+    {
+        std::perror("socket");
+        return 1;
+    }
+
+    // the socket is only accessible by the current user
+    const auto mask = ::umask(0077);
+    const auto bound = ::bind(server, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    ::umask(mask);
+    if (!bound || ::listen(server, 16) != 0)
+    {
+        std::perror("bind");
+        ::close(server);
+        return 1;
+    }
+
+    const auto pid = ::fork();
+    if (pid == -1)
+    {
+        std::perror("fork");
+        ::close(server);
+        ::unlink(socket.c_str());
+        return 1;
+    }
+
+    if (pid != 0)
+    {
+        ::close(server);
+        std::printf("Agent started (pid %d), listening on %s\n", static_cast<int>(pid), socket.c_str());
+        return 0;
+    }
+
+    ::setsid();
+    std::exit(serve(server, socket, idleTimeout));
+}
+
+int Agent::serve(const int &server, const std::string &socket, const unsigned &idleTimeout)
+{
+#if defined(OS_LINUX)
+    // no core dumps and no ptrace attach by other processes of the user
+    ::prctl(PR_SET_DUMPABLE, 0);
+#endif
+
+    // memory locks aren't inherited across fork(), lock after forking
+    if (::mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+    {
+        std::fprintf(stderr, "[warning] agent: unable to lock memory, the vault may be swapped to disk\n");
+    }
+
+    // detach from the terminal
+    const auto null = ::open("/dev/null", O_RDWR);
+    if (null != -1)
+    {
+        ::dup2(null, STDIN_FILENO);
+        ::dup2(null, STDOUT_FILENO);
+        ::dup2(null, STDERR_FILENO);
+        ::close(null);
+    }
+    ::chdir("/");
+
+    for (auto&& sig : {SIGINT, SIGTERM, SIGHUP})
+    {
+        std::signal(sig, &request_termination);
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+
+    pollfd fds;
+    fds.fd = server;
+    fds.events = POLLIN;
+
+    // milliseconds, clamped to the range of poll()
+    const auto timeout = idleTimeout == 0 ? -1 :
+        static_cast<int>(std::min<unsigned long long>(idleTimeout * 1000ULL, INT_MAX));
+    bool stop = false;
+
+    code_publisher.start();
+
+    while (!stop && !terminate_requested)
+    {
+        fds.revents = 0;
+        const auto res = ::poll(&fds, 1, timeout);
+        if (res == 0)
+        {
+            // idle timeout
+            break;
+        }
+        if (res < 0)
+        {
+            continue; // interrupted by a signal
+        }
+
+        const auto client = ::accept(server, nullptr, nullptr);
+        if (client == -1)
+        {
+            continue;
+        }
+
+        if (trustedPeer(client))
+        {
+            // a client which doesn't send its request can't block the agent
+            timeval receiveTimeout{1, 0};
+            ::setsockopt(client, SOL_SOCKET, SO_RCVTIMEO, &receiveTimeout, sizeof(receiveTimeout));
+            handle(client, stop);
+        }
+        ::close(client);
+    }
+
+    code_publisher.stop();
+
+    ::close(server);
+    ::unlink(socket.c_str());
+    TokenDatabase::closeDatabase();
+    return 0;
+}
+
+void Agent::handle(const int &client, bool &stop)
+{
+    std::string line;
+    const auto newline = read_all(client, line, true) ? line.find('\n') : std::string::npos;
+
+    Response response;
+    if (newline == std::string::npos)
+    {
+        response.output = "Malformed request.\n";
+    }
+    else
+    {
+        const auto command = split(line.substr(0, newline));
+        response = execute(command);
+        stop = response.success && command.at(0) == "stop";
+    }
+
+    write_all(client, (response.success ? "OK\n" : "ERR\n") + response.output);
+}
+
+bool Agent::trustedPeer(const int &client)
+{
+    uid_t uid = static_cast<uid_t>(-1);
+
+#if defined(OS_LINUX)
+    ucred credentials;
+    socklen_t length = sizeof(credentials);
+    if (::getsockopt(client, SOL_SOCKET, SO_PEERCRED, &credentials, &length) != 0)
+    {
+        return false;
+    }
+    uid = credentials.uid;
+#else
+    gid_t gid;
+    if (::getpeereid(client, &uid, &gid) != 0)
+    {
+        return false;
+    }
+#endif
+
+    return uid == ::geteuid();
+}
+
+#endif // !OS_WINDOWS
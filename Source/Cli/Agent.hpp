@@ -0,0 +1,69 @@
+#ifndef AGENT_HPP
+#define AGENT_HPP
+
+#include <string>
+#include <vector>
+
+/**
+ * Unlocked vault agent, similar to ssh-agent.
+ *
+ * The agent keeps the decrypted token database in locked memory and serves
+ * requests on a Unix domain socket, so that repeated CLI invocations don't
+ * need to prompt for the password and decrypt the vault every time.
+ * Only processes of the same user are served (peer credentials), and the
+ * agent exits after the idle timeout. The database is reloaded when another
+ * process changed the file, and always before it is written.
+ *
+ * Protocol: one request per connection, a single line of tab-separated
+ * fields. The response is either "OK" or "ERR", a newline and the output
+ * of the command. The connection is closed afterwards.
+ *
+ * Commands:
+ *  => list
+ *  => code  <label>     (advances and stores the counter of HOTP tokens)
+ *  => codes
+ *  => swap  <label> <label>
+ *  => move  <label> <position or label>
+ *  => stop
+ */
+class Agent final
+{
+    Agent() = delete;
+
+public:
+    using Command = std::vector<std::string>;
+
+    struct Response {
+        bool success = false;
+        std::string output;
+    };
+
+    // $OTPGEN_AGENT_SOCKET, or a socket in $XDG_RUNTIME_DIR or the config directory
+    static std::string socketPath(const std::string &configDirectory);
+
+    // maps command line arguments (--list, --code, ...) to an agent command,
+    // returns false when the arguments don't describe an agent command
+    static bool commandFromArguments(const std::vector<std::string> &args, Command &command);
+
+    // executes the command against the loaded token database
+    static Response execute(const Command &command);
+
+    // sends the command to a running agent, returns false when no agent is reachable
+    static bool request(const std::string &socket, const Command &command, Response &response);
+
+    // binds the socket, forks into the background and serves requests until the
+    // idle timeout (in seconds) expires or a stop command is received;
+    // returns in the parent process only, with the exit code of the CLI
+    static int start(const std::string &socket, const unsigned &idleTimeout);
+
+    static const unsigned DefaultIdleTimeout;
+
+    // the peer of the connected Unix socket runs as the current user
+    static bool trustedPeer(const int &client);
+
+private:
+    static int serve(const int &server, const std::string &socket, const unsigned &idleTimeout);
+    static void handle(const int &client, bool &stop);
+};
+
+#endif // AGENT_HPP
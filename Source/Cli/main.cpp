@@ -8,9 +8,12 @@
 #include <CommandLineOperation.hpp>
 
 #include <TokenDatabase.hpp>
+#include <Profiler.hpp>
 
 #include <StdinEchoMode.hpp>
 
+#include "Agent.hpp"
+
 #include <sago/platform_folders.h>
 
 #include <boost/filesystem.hpp>
@@ -67,6 +70,29 @@ int main(int argc, char **argv)
         }
     }
 
+    const std::vector<std::string> args(argv, argv + argc);
+
+#if !defined(OS_WINDOWS)
+    // a running agent answers without unlocking the vault again
+    const auto agent_socket = Agent::socketPath(app_cfg);
+    Agent::Command agent_command;
+    const auto is_agent_command = Agent::commandFromArguments(args, agent_command);
+    if (is_agent_command)
+    {
+        Agent::Response response;
+        if (Agent::request(agent_socket, agent_command, response))
+        {
+            (response.success ? std::cout : std::cerr) << response.output;
+            return response.success ? 0 : 3;
+        }
+        if (agent_command.at(0) == "stop")
+        {
+            std::cerr << "No agent is running." << std::endl;
+            return 1;
+        }
+    }
+#endif
+
 #ifdef OTPGEN_DEBUG
     TokenDatabase::setPassword("pwd123");
 #else
@@ -94,6 +120,10 @@ int main(int argc, char **argv)
     TokenDatabase::setTokenDatabase(app_cfg + "/tokens.db");
 #endif
 
+    // --profile [trace.json]: time the unlock phases
+    const auto profile = args.size() > 1 && args.at(1) == "--profile";
+    Profiler::setEnabled(profile);
+
     auto status = TokenDatabase::loadTokens();
     if (status == TokenDatabase::FileReadFailure)
     {
@@ -112,10 +142,62 @@ int main(int argc, char **argv)
         return 1;
     }
 
+    if (profile)
+    {
+        // the first query after unlocking, as done when listing tokens
+        TokenDatabase::selectTokens();
+        Profiler::setEnabled(false);
+
+        std::cout << Profiler::report();
+        if (args.size() > 2)
+        {
+            if (!Profiler::writeChromeTrace(args.at(2)))
+            {
+                std::cerr << "Unable to write the trace file: " << args.at(2) << std::endl;
+                TokenDatabase::closeDatabase();
+                return 1;
+            }
+            std::cout << "Chrome trace written to " << args.at(2) << std::endl;
+        }
+
+        TokenDatabase::closeDatabase();
+        return 0;
+    }
+
+#if !defined(OS_WINDOWS)
+    // keep the unlocked vault in a background agent
+    if (args.size() > 1 && args.at(1) == "--agent")
+    {
+        auto timeout = Agent::DefaultIdleTimeout;
+        if (args.size() > 2)
+        {
+            try {
+                timeout = static_cast<unsigned>(std::stoul(args.at(2)));
+            } catch (...) {
+                std::cerr << "The agent idle timeout must be a number of seconds!" << std::endl;
+                TokenDatabase::closeDatabase();
+                return 2;
+            }
+        }
+
+        const auto res = Agent::start(agent_socket, timeout);
+        TokenDatabase::closeDatabase();
+        return res;
+    }
+
+    // no agent running, execute the command directly
+    if (is_agent_command)
+    {
+        const auto response = Agent::execute(agent_command);
+        (response.success ? std::cout : std::cerr) << response.output;
+        TokenDatabase::closeDatabase();
+        return response.success ? 0 : 3;
+    }
+#endif
+
     // run command line operation if any
     // FIXME: refactor how command line options are parsed and handled
     //        <remove this function>
-    const std::vector<std::string> args(argv, argv + argc);
     exec_commandline_operation(args);
 
     // TODO: cli application code goes here
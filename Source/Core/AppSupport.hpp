@@ -4,5 +4,6 @@
 #include "AppSupport/andOTP.hpp"
 #include "AppSupport/Authy.hpp"
 #include "AppSupport/Steam.hpp"
+#include "AppSupport/otpauthList.hpp"
 
 #endif // APPSUPPORT_HPP
@@ -1,8 +1,11 @@
 #include "Authy.hpp"
 
 #include <iostream>
+#include <string_view>
 
 #include <TokenDatabase.hpp>
+#include <ImportSink.hpp>
+#include <Internal/MappedFile.hpp>
 
 #include <cereal/external/rapidjson/document.h>
 #include <cereal/external/rapidjson/memorystream.h>
@@ -74,67 +77,61 @@ namespace AppSupport {
 
 bool Authy::importTOTP(const std::string &file, std::vector<OTPToken> &target, const Format &format)
 {
-    std::string json;
-    auto status = prepare(file, format, TOTP, json);
-    if (!status)
-    {
-        return status;
-    }
+    return parseTokens(file, format, TOTP, [&](OTPToken &&token) {
+        target.emplace_back(std::move(token));
+    });
+}
 
-    // parse json
-    try {
-        rapidjson::StringStream s(json.c_str());
-        rapidjson::Document json;
-        json.ParseStream(s);
+bool Authy::importNative(const std::string &file, std::vector<OTPToken> &target, const Format &format)
+{
+    return parseTokens(file, format, Native, [&](OTPToken &&token) {
+        target.emplace_back(std::move(token));
+    });
+}
 
-        // root element must be an array
-        if (!json.IsArray())
-        {
-            return false;
-        }
+bool Authy::importTOTP(const std::string &file, ImportSink &target, const Format &format)
+{
+    return parseTokens(file, format, TOTP, [&](OTPToken &&token) {
+        target.add(std::move(token));
+    });
+}
 
-        auto array = json.GetArray();
-        for (auto&& elem : array)
-        {
-            // check if object has all required members
-            if (!(elem.HasMember("decryptedSecret") &&
-                elem.HasMember("digits") &&
-                elem.HasMember("name")))
-            {
-                continue;
-            }
+bool Authy::importNative(const std::string &file, ImportSink &target, const Format &format)
+{
+    return parseTokens(file, format, Native, [&](OTPToken &&token) {
+        target.add(std::move(token));
+    });
+}
 
-            OTPToken token(OTPToken::TOTP);
-            token.setSecret(elem["decryptedSecret"].GetString());
-            token.setLabel(elem["name"].GetString());
-            token.setDigitLength(static_cast<OTPToken::DigitType>(elem["digits"].GetUint()));
-            target.push_back(token);
-        }
-    } catch (...) {
-        // catch all rapidjson exceptions
+bool Authy::parseTokens(const std::string &file, const Format &format, const AuthyXMLType &type, const Emitter &emit)
+{
+    // map the file, the xml and json are parsed in-situ
+    MappedFile in(file);
+    if (!in.valid())
+    {
         return false;
     }
 
-    return true;
-}
-
-bool Authy::importNative(const std::string &file, std::vector<OTPToken> &target, const Format &format)
-{
-    std::string json;
-    auto status = prepare(file, format, Native, json);
-    if (!status)
+    char *buffer = in.data();
+    if (format == XML)
     {
-        return status;
+        // json string inside the xml, points into the mapped buffer
+        if (!extractJSON(in.data(), type, buffer))
+        {
+            return false;
+        }
     }
 
+    // TOTP tokens carry the base-32 secret, native tokens a hex encoded seed
+    const auto secretMember = type == TOTP ? "decryptedSecret" : "secretSeed";
+
     // parse json
     try {
-        rapidjson::StringStream s(json.c_str());
         rapidjson::Document json;
-        json.ParseStream(s);
+        json.ParseInsitu(buffer);
 
         // root element must be an array
-        if (!json.IsArray())
+        if (json.HasParseError() || !json.IsArray())
         {
             return false;
         }
@@ -143,7 +140,7 @@ bool Authy::importNative(const std::string &file, std::vector<OTPToken> &target,
         for (auto&& elem : array)
         {
             // check if object has all required members
-            if (!(elem.HasMember("secretSeed") &&
+            if (!(elem.HasMember(secretMember) &&
                 elem.HasMember("digits") &&
                 elem.HasMember("name")))
             {
@@ -151,10 +148,17 @@ bool Authy::importNative(const std::string &file, std::vector<OTPToken> &target,
             }
 
             OTPToken token(OTPToken::TOTP);
-            token.setSecret(hexToBase32Rfc4648(elem["secretSeed"].GetString()));
+            if (type == TOTP)
+            {
+                token.setSecret(elem[secretMember].GetString());
+            }
+            else
+            {
+                token.setSecret(hexToBase32Rfc4648(elem[secretMember].GetString()));
+            }
             token.setLabel(elem["name"].GetString());
             token.setDigitLength(static_cast<OTPToken::DigitType>(elem["digits"].GetUint()));
-            target.push_back(token);
+            emit(std::move(token));
         }
     } catch (...) {
         // catch all rapidjson exceptions
@@ -164,41 +168,7 @@ bool Authy::importNative(const std::string &file, std::vector<OTPToken> &target,
     return true;
 }
 
-bool Authy::prepare(const std::string &file, const Format &format, const AuthyXMLType &type, std::string &json)
-{
-    // read file contents into memory
-    std::string out;
-    auto status = TokenDatabase::readFile(file, out);
-    if (status != TokenDatabase::Success)
-    {
-        out.clear();
-        return false;
-    }
-
-    if (out.empty())
-    {
-        return false;
-    }
-
-    if (format == XML)
-    {
-        auto status = extractJSON(out, type, json);
-        if (!status)
-        {
-            out.clear();
-            return status;
-        }
-    }
-    else
-    {
-        json = out;
-    }
-
-    out.clear();
-    return true;
-}
-
-const std::string Authy::hexToBase32Rfc4648(const std::string &hex)
+SecureString Authy::hexToBase32Rfc4648(const std::string &hex)
 {
     // create an RFC 4648 base-32 encoder
     // crypto++ uses DUDE by default which isn't TOTP compatible
@@ -210,23 +180,23 @@ const std::string Authy::hexToBase32Rfc4648(const std::string &hex)
     encoder->IsolatedInitialize(params);
 
     // raw pointers are automatically deleted by crypto++
-    std::string base32;
-    encoder->Attach(new CryptoPP::StringSink(base32));
+    SecureString base32;
+    encoder->Attach(new CryptoPP::StringSinkTemplate<SecureString>(base32));
     CryptoPP::StringSource src(hex, true,
           new CryptoPP::HexDecoder(encoder));
     return base32;
 }
 
-bool Authy::extractJSON(const std::string &xml, const AuthyXMLType &type, std::string &json)
+bool Authy::extractJSON(char *xml, const AuthyXMLType &type, char *&json)
 {
-    const std::string attr = type == TOTP ?
-        "com.authy.storage.tokens.authenticator.key" :
-        "com.authy.storage.tokens.authy.key";
+    static const std::string_view totp_attr = "com.authy.storage.tokens.authenticator.key";
+    static const std::string_view native_attr = "com.authy.storage.tokens.authy.key";
+    const auto &attr = type == TOTP ? totp_attr : native_attr;
 
     try {
+        // parsed in-place, entities are decoded and values are null-terminated inside the buffer
         cereal::rapidxml::xml_document<> doc;
-        auto buf = xml;
-        doc.parse<0>(const_cast<char*>(buf.data()));
+        doc.parse<0>(xml);
 
         auto map = doc.first_node("map", 3, false);
         if (!map) return false;
@@ -237,14 +207,12 @@ bool Authy::extractJSON(const std::string &xml, const AuthyXMLType &type, std::s
         auto name = string->first_attribute("name", 4, false);
         if (!name) return false;
 
-        const auto authy_type = std::string(name->value());
-        if (authy_type != attr)
+        if (std::string_view(name->value(), name->value_size()) != attr)
         {
             return false;
         }
 
-        const auto json_value = std::string(string->value());
-        json = json_value;
+        json = string->value();
     } catch (...) {
         return false;
     }
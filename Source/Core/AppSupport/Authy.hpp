@@ -3,8 +3,11 @@
 
 #include <OTPToken.hpp>
 
+#include <functional>
 #include <vector>
 
+class ImportSink;
+
 namespace AppSupport {
 
 class Authy
@@ -20,16 +23,22 @@ public:
     static bool importTOTP(const std::string &file, std::vector<OTPToken> &target, const Format &format);
     static bool importNative(const std::string &file, std::vector<OTPToken> &target, const Format &format);
 
+    static bool importTOTP(const std::string &file, ImportSink &target, const Format &format);
+    static bool importNative(const std::string &file, ImportSink &target, const Format &format);
+
 private:
     enum AuthyXMLType {
         TOTP,
         Native,
     };
 
-    static const std::string hexToBase32Rfc4648(const std::string &hex);
+    using Emitter = std::function<void(OTPToken &&token)>;
+    static bool parseTokens(const std::string &file, const Format &format, const AuthyXMLType &type, const Emitter &emit);
+
+    static SecureString hexToBase32Rfc4648(const std::string &hex);
 
-    static bool prepare(const std::string &file, const Format &format, const AuthyXMLType &type, std::string &json);
-    static bool extractJSON(const std::string &xml, const AuthyXMLType &type, std::string &json);
+    // locates the json string inside the xml, json points into the (modified) xml buffer
+    static bool extractJSON(char *xml, const AuthyXMLType &type, char *&json);
 };
 
 }
@@ -3,6 +3,7 @@
 #include <iostream>
 
 #include <TokenDatabase.hpp>
+#include <Internal/MappedFile.hpp>
 
 #include <cereal/external/rapidjson/document.h>
 #include <cereal/external/rapidjson/memorystream.h>
@@ -30,28 +31,20 @@ namespace AppSupport {
 
 bool Steam::importFromSteamGuard(const std::string &file, OTPToken &target)
 {
-    // read file contents into memory
-    std::string out;
-    auto status = TokenDatabase::readFile(file, out);
-    if (status != TokenDatabase::Success)
-    {
-        out.clear();
-        return false;
-    }
-
-    if (out.empty())
+    // map the file, the json is parsed in-situ
+    MappedFile in(file);
+    if (!in.valid())
     {
         return false;
     }
 
     // parse json
     try {
-        rapidjson::StringStream s(out.c_str());
         rapidjson::Document json;
-        json.ParseStream(s);
+        json.ParseInsitu(in.data());
 
         // root element must be an object
-        if (!json.IsObject())
+        if (json.HasParseError() || !json.IsObject())
         {
             return false;
         }
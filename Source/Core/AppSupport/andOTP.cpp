@@ -1,16 +1,19 @@
 #include "andOTP.hpp"
 
+#include <cstdio>
 #include <iostream>
+#include <string_view>
 
 #include <TokenDatabase.hpp>
+#include <ImportSink.hpp>
+#include <Internal/MappedFile.hpp>
 
 #include <cereal/external/rapidjson/document.h>
-#include <cereal/external/rapidjson/memorystream.h>
-#include <cereal/external/rapidjson/stringbuffer.h>
 #include <cereal/external/rapidjson/writer.h>
 
 #include <cryptopp/sha.h>
 #include <cryptopp/filters.h>
+#include <cryptopp/files.h>
 #include <cryptopp/randpool.h>
 #include <cryptopp/osrng.h>
 
@@ -39,48 +42,69 @@ namespace AppSupport {
 const uint8_t andOTP::ANDOTP_IV_SIZE = 12U;
 const uint8_t andOTP::ANDOTP_TAG_SIZE = 16U;
 
-bool andOTP::importTokens(const std::string &file, std::vector<OTPToken*> &target, const Type &type, const std::string &password)
+void andOTP::PipelineStream::Put(Ch c)
 {
-    // read file contents into memory
-    std::string out;
-    auto status = TokenDatabase::readFile(file, out);
-    if (status != TokenDatabase::Success)
+    buffer[size++] = static_cast<CryptoPP::byte>(c);
+    if (size == buffer.size())
     {
-        out.clear();
-        return false;
+        Flush();
+    }
+}
+
+void andOTP::PipelineStream::Flush()
+{
+    if (size != 0)
+    {
+        sink.Put(buffer.data(), size);
+        size = 0;
     }
+}
+
+bool andOTP::importTokens(const std::string &file, std::vector<OTPToken*> &target, const Type &type, const std::string &password)
+{
+    return parseTokens(file, type, password, [&](OTPToken &&token) {
+        target.push_back(new OTPToken(std::move(token)));
+    });
+}
+
+bool andOTP::importTokens(const std::string &file, ImportSink &target, const Type &type, const std::string &password)
+{
+    return parseTokens(file, type, password, [&](OTPToken &&token) {
+        target.add(std::move(token));
+    });
+}
 
-    if (out.empty())
+bool andOTP::parseTokens(const std::string &file, const Type &type, const std::string &password, const Emitter &emit)
+{
+    // map the file, the json is parsed in-situ
+    MappedFile in(file);
+    if (!in.valid())
     {
         return false;
     }
 
+    char *buffer = in.data();
+
     // decrypt contents first if they are encrypted
+    SecureString decrypted;
     if (type == Encrypted)
     {
-        std::string decrypted;
-        auto status = decrypt(password, out, decrypted);
-        if (status)
-        {
-            out = decrypted;
-            decrypted.clear();
-        }
-        else
+        if (!decrypt(password, in.data(), in.size(), decrypted))
         {
-            out.clear();
-            decrypted.clear();
             return false;
         }
+
+        // std::basic_string is always null-terminated
+        buffer = &decrypted[0];
     }
 
     // parse json
     try {
-        rapidjson::StringStream s(out.c_str());
         rapidjson::Document json;
-        json.ParseStream(s);
+        json.ParseInsitu(buffer);
 
         // root element must be an array
-        if (!json.IsArray())
+        if (json.HasParseError() || !json.IsArray())
         {
             return false;
         }
@@ -98,34 +122,34 @@ bool andOTP::importTokens(const std::string &file, std::vector<OTPToken*> &targe
 
             try {
 
-            const auto typeStr = std::string(elem["type"].GetString());
+            const auto typeStr = std::string_view(elem["type"].GetString(), elem["type"].GetStringLength());
 
             if (typeStr == "TOTP")
             {
-                auto token = new OTPToken(OTPToken::TOTP);
-                token->setSecret(elem["secret"].GetString());
-                token->setLabel(elem["label"].GetString());
-                token->setPeriod(elem["period"].GetUint());
-                token->setDigitLength(static_cast<OTPToken::DigitType>(elem["digits"].GetUint()));
-                token->setAlgorithm(elem["algorithm"].GetString());
-                target.push_back(token);
+                OTPToken token(OTPToken::TOTP);
+                token.setSecret(elem["secret"].GetString());
+                token.setLabel(elem["label"].GetString());
+                token.setPeriod(elem["period"].GetUint());
+                token.setDigitLength(static_cast<OTPToken::DigitType>(elem["digits"].GetUint()));
+                token.setAlgorithm(elem["algorithm"].GetString());
+                emit(std::move(token));
             }
             else if (typeStr == "HOTP")
             {
-                auto token = new OTPToken(OTPToken::HOTP);
-                token->setSecret(elem["secret"].GetString());
-                token->setLabel(elem["label"].GetString());
-                token->setCounter(elem["counter"].GetUint());
-                token->setDigitLength(static_cast<OTPToken::DigitType>(elem["digits"].GetUint()));
-                token->setAlgorithm(elem["algorithm"].GetString());
-                target.push_back(token);
+                OTPToken token(OTPToken::HOTP);
+                token.setSecret(elem["secret"].GetString());
+                token.setLabel(elem["label"].GetString());
+                token.setCounter(elem["counter"].GetUint64());
+                token.setDigitLength(static_cast<OTPToken::DigitType>(elem["digits"].GetUint()));
+                token.setAlgorithm(elem["algorithm"].GetString());
+                emit(std::move(token));
             }
             else if (typeStr == "STEAM")
             {
-                auto token = new OTPToken(OTPToken::Steam);
-                token->setSecret(elem["secret"].GetString());
-                token->setLabel(elem["label"].GetString());
-                target.push_back(token);
+                OTPToken token(OTPToken::Steam);
+                token.setSecret(elem["secret"].GetString());
+                token.setLabel(elem["label"].GetString());
+                emit(std::move(token));
             }
             else
             {
@@ -146,116 +170,187 @@ bool andOTP::importTokens(const std::string &file, std::vector<OTPToken*> &targe
 
 bool andOTP::exportTokens(const std::string &target, const std::vector<OTPToken*> &tokens, const Type &type, const std::string &password)
 {
-    try {
-        rapidjson::Document json(rapidjson::kArrayType);
-
+    return writeTokens(target, type, password, [&](const TokenWriter &write) {
         for (auto&& token : tokens)
         {
-            rapidjson::Value value(rapidjson::kObjectType);
-            value.AddMember("secret", rapidjson::Value(token->secret().c_str(), json.GetAllocator()), json.GetAllocator());
-            value.AddMember("label", rapidjson::Value(token->label().c_str(), json.GetAllocator()), json.GetAllocator());
-            value.AddMember("period", token->period(), json.GetAllocator());
-            value.AddMember("digits", token->digitLength(), json.GetAllocator());
+            write(*token);
+        }
+        return true;
+    });
+}
 
-            if (token->type() == OTPToken::HOTP)
-            {
-                value.AddMember("type", "HOTP", json.GetAllocator());
-            }
-            else if (token->type() == OTPToken::Steam)
-            {
-                value.AddMember("type", "STEAM", json.GetAllocator());
-            }
-            else
-            {
-                value.AddMember("type", "TOTP", json.GetAllocator());
-            }
+bool andOTP::exportDatabase(const std::string &target, const Type &type, const std::string &password)
+{
+    return writeTokens(target, type, password, [](const TokenWriter &write) {
+        return TokenDatabase::forEachToken(write) == TokenDatabase::Success;
+    });
+}
 
-            if (token->type() == OTPToken::Steam)
-            {
-                value.AddMember("algorithm", "SHA1", json.GetAllocator());
-                value["digits"].SetUint(5);
-            }
-            else
-            {
-                value.AddMember("algorithm", rapidjson::Value(token->algorithmName().c_str(), json.GetAllocator()), json.GetAllocator());
-            }
+bool andOTP::writeTokens(const std::string &target, const Type &type, const std::string &password, const TokenSource &source)
+{
+    bool ret = false;
 
-            value.AddMember("thumbnail", "Default", json.GetAllocator());
-            value.AddMember("last_used", 0, json.GetAllocator());
-            value.AddMember("tags", rapidjson::Value(rapidjson::kArrayType), json.GetAllocator());
-            json.PushBack(value, json.GetAllocator());
-        }
+    // written next to the target and renamed on success, an existing
+    // export is only replaced by a complete one
+    const auto temporary = target + ".tmp";
 
-        rapidjson::StringBuffer buffer;
-        rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-        json.Accept(writer);
+    try {
+        CryptoPP::FileSink file(temporary.c_str(), true);
 
         if (type == PlainText)
         {
-            const auto res = TokenDatabase::writeFile(target, buffer.GetString());
-            if (res != TokenDatabase::Success)
-            {
-                return false;
-            }
+            ret = writeJSON(file, source);
         }
         else
         {
-            std::string encrypted;
-            auto res = encrypt(password, buffer.GetString(), encrypted);
-            if (!res)
-            {
-                return false;
-            }
-            res = TokenDatabase::writeFile(target, encrypted);
-            if (res != TokenDatabase::Success)
-            {
-                return false;
-            }
+            // andOTP requires the IV to be stored before the message
+            CryptoPP::AutoSeededRandomPool prng;
+            CryptoPP::SecByteBlock iv(ANDOTP_IV_SIZE);
+            prng.GenerateBlock(iv, iv.size());
+            file.Put(iv, iv.size());
+
+            CryptoPP::GCM<CryptoPP::AES>::Encryption e;
+            const auto pwd = sha256_password(password);
+            e.SetKeyWithIV(reinterpret_cast<const unsigned char*>(pwd.c_str()), pwd.size(),
+                           iv, iv.size());
+
+            // the encrypted stream and the tag are appended to the file by the filter
+            CryptoPP::AuthenticatedEncryptionFilter filter(e, new CryptoPP::Redirector(file), false, ANDOTP_TAG_SIZE);
+            ret = writeJSON(filter, source);
         }
     } catch (...) {
+        ret = false;
+    }
+
+    if (ret)
+    {
+#ifdef OS_WINDOWS
+        // rename() doesn't replace existing files on Windows
+        std::remove(target.c_str());
+#endif
+        ret = std::rename(temporary.c_str(), target.c_str()) == 0;
+    }
+
+    // don't leave incomplete exports behind
+    if (!ret)
+    {
+        std::remove(temporary.c_str());
+    }
+
+    return ret;
+}
+
+bool andOTP::writeJSON(CryptoPP::BufferedTransformation &sink, const TokenSource &source)
+{
+    PipelineStream stream(sink);
+    rapidjson::Writer<PipelineStream> writer(stream);
+
+    writer.StartArray();
+
+    const auto ret = source([&](const OTPToken &token) {
+        writer.StartObject();
+
+        writer.Key("secret");
+        writer.String(token.secret().data(), static_cast<rapidjson::SizeType>(token.secret().size()));
+        writer.Key("label");
+        writer.String(token.label().data(), static_cast<rapidjson::SizeType>(token.label().size()));
+        writer.Key("period");
+        writer.Uint(token.period());
+        writer.Key("digits");
+        writer.Uint(token.type() == OTPToken::Steam ? 5U : token.digitLength());
+
+        writer.Key("type");
+        if (token.type() == OTPToken::HOTP)
+        {
+            writer.String("HOTP");
+            writer.Key("counter");
+            writer.Uint64(token.counter());
+        }
+        else if (token.type() == OTPToken::Steam)
+        {
+            writer.String("STEAM");
+        }
+        else
+        {
+            writer.String("TOTP");
+        }
+
+        writer.Key("algorithm");
+        if (token.type() == OTPToken::Steam)
+        {
+            writer.String("SHA1");
+        }
+        else
+        {
+            const auto algorithm = token.algorithmName();
+            writer.String(algorithm.data(), static_cast<rapidjson::SizeType>(algorithm.size()));
+        }
+
+        writer.Key("thumbnail");
+        writer.String("Default");
+        writer.Key("last_used");
+        writer.Uint(0);
+        writer.Key("tags");
+        writer.StartArray();
+        writer.EndArray();
+
+        writer.EndObject();
+    });
+
+    if (!ret)
+    {
         return false;
     }
 
-    return true;
+    writer.EndArray();
+    stream.Flush();
+
+    // finalizes the cipher and closes the file
+    sink.MessageEnd();
+    return writer.IsComplete();
 }
 
-const std::string andOTP::sha256_password(const std::string &password)
+SecureString andOTP::sha256_password(const std::string &password)
 {
     if (password.empty())
-        return password;
+        return {};
 
-    std::string hashed_password;
+    SecureString hashed_password;
 
     // don't use smart pointers here, already managed/deleted by crypto++ itself
     CryptoPP::SHA256 hash;
     CryptoPP::StringSource src(password, true,
         new CryptoPP::HashFilter(hash,
-            new CryptoPP::StringSink(hashed_password)));
+            new CryptoPP::StringSinkTemplate<SecureString>(hashed_password)));
 
     return hashed_password;
 }
 
-bool andOTP::decrypt(const std::string &password, const std::string &buffer, std::string &decrypted)
+bool andOTP::decrypt(const std::string &password, const char *buffer, const std::size_t &size, SecureString &decrypted)
 {
     // stream too small
-    if (buffer.size() <= (ANDOTP_IV_SIZE + ANDOTP_TAG_SIZE))
+    if (size <= static_cast<std::size_t>(ANDOTP_IV_SIZE + ANDOTP_TAG_SIZE))
     {
         return false;
     }
 
     try {
-        // extract IV and encrypted message from the andOTP database
-        const auto iv = buffer.substr(0, ANDOTP_IV_SIZE);
-        const auto enc_buf = buffer.substr(ANDOTP_IV_SIZE);
+        // the IV is stored before the encrypted message, both are used in-place
+        const auto iv = reinterpret_cast<const CryptoPP::byte*>(buffer);
+        const auto enc_buf = reinterpret_cast<const CryptoPP::byte*>(buffer + ANDOTP_IV_SIZE);
+        const auto enc_size = size - ANDOTP_IV_SIZE;
+
+        decrypted.clear();
+        decrypted.reserve(enc_size - ANDOTP_TAG_SIZE);
 
         CryptoPP::GCM<CryptoPP::AES>::Decryption d;
         const auto pwd = sha256_password(password);
         d.SetKeyWithIV(reinterpret_cast<const unsigned char*>(pwd.c_str()), pwd.size(),
-                       reinterpret_cast<const unsigned char*>(iv.c_str()), ANDOTP_IV_SIZE);
-        CryptoPP::AuthenticatedDecryptionFilter df(d, new CryptoPP::StringSink(decrypted),
+                       iv, ANDOTP_IV_SIZE);
+        CryptoPP::AuthenticatedDecryptionFilter df(d, new CryptoPP::StringSinkTemplate<SecureString>(decrypted),
                                                    CryptoPP::AuthenticatedDecryptionFilter::MAC_AT_END,
                                                    ANDOTP_TAG_SIZE);
-        CryptoPP::StringSource(enc_buf, true, new CryptoPP::Redirector(df));
+        CryptoPP::ArraySource(enc_buf, enc_size, true, new CryptoPP::Redirector(df));
     } catch (...) {
         decrypted.clear();
         return false;
@@ -264,42 +359,4 @@ bool andOTP::decrypt(const std::string &password, const std::string &buffer, std
     return true;
 }
 
-bool andOTP::encrypt(const std::string &password, const std::string &buffer, std::string &encrypted)
-{
-    // stream is empty
-    if (buffer.empty())
-    {
-        return false;
-    }
-
-    // generate random IV
-    CryptoPP::AutoSeededRandomPool prng;
-    CryptoPP::byte *iv = static_cast<CryptoPP::byte*>(std::malloc(ANDOTP_IV_SIZE));
-    prng.GenerateBlock(iv, ANDOTP_IV_SIZE);
-
-    try {
-        std::string enc_buf;
-
-        CryptoPP::GCM<CryptoPP::AES>::Encryption e;
-        const auto pwd = sha256_password(password);
-        e.SetKeyWithIV(reinterpret_cast<const unsigned char*>(pwd.c_str()), pwd.size(),
-                       iv, ANDOTP_IV_SIZE);
-        CryptoPP::StringSource ss(buffer, true,
-                                    new CryptoPP::AuthenticatedEncryptionFilter(e,
-                                      new CryptoPP::StringSink(enc_buf), false, ANDOTP_TAG_SIZE));
-
-        // andOTP requires the IV to be stored before the message
-        encrypted.clear();
-        encrypted.append(std::string(iv, iv + ANDOTP_IV_SIZE));
-        encrypted.append(enc_buf);
-    } catch (...) {
-        std::free(iv);
-        encrypted.clear();
-        return false;
-    }
-
-    std::free(iv);
-    return true;
-}
-
 }
@@ -3,8 +3,16 @@
 
 #include <OTPToken.hpp>
 
+#include <array>
+#include <functional>
 #include <vector>
 
+class ImportSink;
+
+namespace CryptoPP {
+    class BufferedTransformation;
+}
+
 namespace AppSupport {
 
 class andOTP
@@ -22,12 +30,40 @@ public:
     };
 
     static bool importTokens(const std::string &file, std::vector<OTPToken*> &target, const Type &type = PlainText, const std::string &password = std::string());
+    static bool importTokens(const std::string &file, ImportSink &target, const Type &type = PlainText, const std::string &password = std::string());
     static bool exportTokens(const std::string &target, const std::vector<OTPToken*> &tokens, const Type &type = PlainText, const std::string &password = std::string());
 
+    // streams all tokens of the open TokenDatabase into the file, memory use doesn't depend on the number of tokens
+    static bool exportDatabase(const std::string &target, const Type &type = PlainText, const std::string &password = std::string());
+
 private:
-    static const std::string sha256_password(const std::string &password);
-    static bool decrypt(const std::string &password, const std::string &buffer, std::string &decrypted);
-    static bool encrypt(const std::string &password, const std::string &buffer, std::string &encrypted);
+    using Emitter = std::function<void(OTPToken &&token)>;
+    static bool parseTokens(const std::string &file, const Type &type, const std::string &password, const Emitter &emit);
+
+    // key and plaintext are kept in the locked arena
+    static SecureString sha256_password(const std::string &password);
+    static bool decrypt(const std::string &password, const char *buffer, const std::size_t &size, SecureString &decrypted);
+
+    // calls the writer for every token to export
+    using TokenWriter = std::function<void(const OTPToken &token)>;
+    using TokenSource = std::function<bool(const TokenWriter &write)>;
+    static bool writeTokens(const std::string &target, const Type &type, const std::string &password, const TokenSource &source);
+    static bool writeJSON(CryptoPP::BufferedTransformation &sink, const TokenSource &source);
+
+    // rapidjson output stream which feeds a crypto++ pipeline in chunks
+    struct PipelineStream {
+        using Ch = char;
+
+        PipelineStream(CryptoPP::BufferedTransformation &sink)
+            : sink(sink) {}
+
+        void Put(Ch c);
+        void Flush();
+
+        CryptoPP::BufferedTransformation &sink;
+        std::array<unsigned char, 16384> buffer;
+        std::size_t size = 0;
+    };
 };
 
 }
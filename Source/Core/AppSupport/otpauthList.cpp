@@ -0,0 +1,115 @@
+#include "otpauthList.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string_view>
+
+#include <TokenDatabase.hpp>
+#include <ImportSink.hpp>
+#include <otpauthURI.hpp>
+#include <Internal/MappedFile.hpp>
+
+namespace AppSupport {
+
+bool otpauthList::importTokens(const std::string &file, ImportSink &target)
+{
+    MappedFile input(file);
+    if (!input.valid())
+    {
+        return false;
+    }
+
+    const auto lines = input.view();
+    std::size_t pos = 0;
+    while (pos < lines.size())
+    {
+        auto end = lines.find('\n', pos);
+        if (end == std::string_view::npos)
+        {
+            end = lines.size();
+        }
+
+        auto line = lines.substr(pos, end - pos);
+        if (!line.empty() && line.back() == '\r')
+        {
+            line.remove_suffix(1);
+        }
+        pos = end + 1;
+
+        if (line.empty())
+        {
+            continue;
+        }
+
+        // keep unparseable lines as invalid tokens for the statistics
+        OTPToken token;
+        otpauthURI::read(line, token);
+        target.add(std::move(token));
+    }
+
+    return true;
+}
+
+bool otpauthList::exportDatabase(const std::string &target, const OTPToken::sqliteTypesID &type)
+{
+    // written next to the target and renamed on success, an existing
+    // export is only replaced by a complete one
+    const auto temporary = target + ".tmp";
+
+    // unbuffered, the URIs contain the secrets and are only kept in the
+    // locked buffer below, which is written in blocks
+    std::ofstream stream;
+    stream.rdbuf()->pubsetbuf(nullptr, 0);
+    stream.open(temporary, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    if (!stream)
+    {
+        return false;
+    }
+
+    static const std::size_t blockSize = 65536U;
+    SecureString buffer;
+    buffer.reserve(blockSize + 512U);
+    bool written = true;
+
+    const auto status = TokenDatabase::forEachToken([&](const OTPToken &token) {
+        // tokens which can't be represented fail the export
+        if (!written || !otpauthURI::write(token, buffer))
+        {
+            written = false;
+            return;
+        }
+        buffer.push_back('\n');
+
+        if (buffer.size() >= blockSize)
+        {
+            written = static_cast<bool>(stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size())));
+            buffer.clear();
+        }
+    }, type);
+
+    if (status == TokenDatabase::Success && written)
+    {
+        written = static_cast<bool>(stream.write(buffer.data(), static_cast<std::streamsize>(buffer.size())));
+    }
+    stream.close();
+
+    auto ret = status == TokenDatabase::Success && written && !stream.fail();
+    if (ret)
+    {
+#ifdef OS_WINDOWS
+        // rename() doesn't replace existing files on Windows
+        std::remove(target.c_str());
+#endif
+        ret = std::rename(temporary.c_str(), target.c_str()) == 0;
+    }
+
+    // don't leave incomplete exports behind
+    if (!ret)
+    {
+        std::remove(temporary.c_str());
+    }
+
+    return ret;
+}
+
+}
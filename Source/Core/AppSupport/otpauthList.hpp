@@ -0,0 +1,29 @@
+#ifndef OTPAUTHLIST_HPP
+#define OTPAUTHLIST_HPP
+
+#include <OTPToken.hpp>
+
+#include <string>
+
+class ImportSink;
+
+namespace AppSupport {
+
+// otpauth URI lists, one URI per line
+class otpauthList
+{
+    otpauthList() = delete;
+
+public:
+    // adds every line to the sink, unparseable lines are counted as invalid on commit()
+    static bool importTokens(const std::string &file, ImportSink &target);
+
+    // streams the tokens of the open TokenDatabase in display order from a database cursor,
+    // Steam tokens are written as TOTP; fails when a token can't be represented as URI,
+    // an existing target is only replaced on success
+    static bool exportDatabase(const std::string &target, const OTPToken::sqliteTypesID &type = OTPToken::None);
+};
+
+}
+
+#endif // OTPAUTHLIST_HPP
@@ -0,0 +1,165 @@
+#include "CodePublisher.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+CodePublisher::CodePublisher(const Clock &clock)
+    : _clock(clock ? clock : [] { return std::time(nullptr); })
+{
+}
+
+CodePublisher::~CodePublisher()
+{
+    this->stop();
+}
+
+CodePublisher::Snapshot CodePublisher::read() const
+{
+    std::lock_guard<std::mutex> lock(this->_currentMutex);
+    return this->_current;
+}
+
+void CodePublisher::setTable(TokenTable &&table)
+{
+    this->setTable(std::make_shared<const TokenTable>(std::move(table)));
+}
+
+void CodePublisher::setTable(const std::shared_ptr<const TokenTable> &table)
+{
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        this->_table = table;
+        this->publish(this->_clock());
+
+        // the worker computes its next wakeup from the new table
+        this->_reschedule = true;
+    }
+    this->_wakeup.notify_all();
+}
+
+void CodePublisher::update(const std::time_t &time)
+{
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    this->publish(time);
+}
+
+void CodePublisher::start()
+{
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    if (this->_worker.joinable())
+    {
+        return;
+    }
+    this->_stopping = false;
+    this->_reschedule = false;
+    this->_worker = std::thread(&CodePublisher::run, this);
+}
+
+void CodePublisher::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->_mutex);
+        if (!this->_worker.joinable())
+        {
+            return;
+        }
+        this->_stopping = true;
+    }
+    this->_wakeup.notify_all();
+    this->_worker.join();
+}
+
+std::size_t CodePublisher::pendingReclamation() const
+{
+    std::lock_guard<std::mutex> lock(this->_mutex);
+    return static_cast<std::size_t>(std::count_if(this->_retired.cbegin(), this->_retired.cend(),
+        [](const std::weak_ptr<const CodeSnapshot> &retired) {
+            return !retired.expired();
+        }));
+}
+
+void CodePublisher::publish(const std::time_t &time)
+{
+    // only writers replace the pointer, all of them hold _mutex
+    const auto previous = this->_current;
+    const auto &table = this->_table;
+
+    auto snapshot = std::make_shared<CodeSnapshot>();
+    snapshot->table = table;
+    snapshot->time = time;
+    snapshot->version = ++this->_version;
+
+    if (table)
+    {
+        const auto rows = table->size();
+        snapshot->codes.resize(rows);
+        snapshot->expires.resize(rows);
+
+        // codes of the same table which are still valid are reused
+        const auto reuse = previous && previous->table == table && previous->time <= time;
+
+        for (TokenTable::Index row = 0; row < rows; ++row)
+        {
+            const auto remaining = table->remainingValidity(row, time);
+            snapshot->expires[row] = remaining == 0 ? 0 : time + static_cast<std::time_t>(remaining);
+
+            if (reuse && remaining != 0 && previous->expires[row] == snapshot->expires[row])
+            {
+                snapshot->codes[row] = previous->codes[row];
+            }
+            else
+            {
+                snapshot->codes[row] = table->generate(row, time);
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->_currentMutex);
+        this->_current = std::move(snapshot);
+    }
+
+    // the previous snapshot is freed here or by its last reader
+    const auto end = std::remove_if(this->_retired.begin(), this->_retired.end(),
+        [](const std::weak_ptr<const CodeSnapshot> &retired) {
+            return retired.expired();
+        });
+    this->_retired.erase(end, this->_retired.end());
+    if (previous)
+    {
+        this->_retired.emplace_back(previous);
+    }
+}
+
+void CodePublisher::run()
+{
+    std::unique_lock<std::mutex> lock(this->_mutex);
+
+    while (!this->_stopping)
+    {
+        this->_reschedule = false;
+        const auto now = this->_clock();
+        this->publish(now);
+
+        // sleep until the first code expires
+        auto next = std::numeric_limits<std::time_t>::max();
+        for (auto&& expires : this->_current->expires)
+        {
+            if (expires > now)
+            {
+                next = std::min(next, expires);
+            }
+        }
+        if (next == std::numeric_limits<std::time_t>::max())
+        {
+            // only counter based tokens or no table
+            next = now + 60;
+        }
+
+        this->_wakeup.wait_until(lock, std::chrono::system_clock::from_time_t(next), [&]{
+            return this->_stopping || this->_reschedule ||
+                   this->_clock() >= next;
+        });
+    }
+}
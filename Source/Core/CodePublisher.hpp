@@ -0,0 +1,102 @@
+#ifndef CODEPUBLISHER_HPP
+#define CODEPUBLISHER_HPP
+
+#include "TokenTable.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Immutable table of the current codes of all tokens.
+ */
+struct CodeSnapshot
+{
+    std::shared_ptr<const TokenTable> table;
+    TokenTable::CodeList codes;         // empty when a row can't generate a code
+    std::vector<std::time_t> expires;   // end of the validity, 0 for counter based tokens
+    std::time_t time = 0;               // time the codes were generated for
+    std::uint64_t version = 0;          // incremented with every published snapshot
+
+    inline std::size_t size() const
+    { return this->codes.size(); }
+
+    // seconds until the code of a row changes, 0 for counter based tokens
+    inline std::uint64_t remaining(const TokenTable::Index &row, const std::time_t &now) const
+    { return this->expires[row] > now ? static_cast<std::uint64_t>(this->expires[row] - now) : 0U; }
+};
+
+/**
+ * Publishes the current codes of a TokenTable to readers on any thread.
+ *
+ * A worker thread recomputes the codes whenever a period rolls over and
+ * publishes a new immutable CodeSnapshot. Readers never compute codes, they
+ * just take a reference to the current snapshot with read(). The snapshot
+ * pointer has its own mutex which is only held to copy or swap the pointer,
+ * never while codes are computed.
+ *
+ * Replaced snapshots are freed when the last reader drops its reference.
+ *
+ * Only rows whose period rolled over are recomputed, the other codes are
+ * copied from the previous snapshot.
+ */
+class CodePublisher final
+{
+public:
+    using Clock = std::function<std::time_t()>;
+    using Snapshot = std::shared_ptr<const CodeSnapshot>;
+
+    explicit CodePublisher(const Clock &clock = {});
+    ~CodePublisher();
+
+    CodePublisher(const CodePublisher &) = delete;
+    CodePublisher &operator= (const CodePublisher &) = delete;
+
+    // callable from any thread, nullptr before the first snapshot was published
+    Snapshot read() const;
+
+    // replaces the token table, the codes are recomputed and published
+    // before this returns
+    void setTable(TokenTable &&table);
+    void setTable(const std::shared_ptr<const TokenTable> &table);
+
+    // computes and publishes the codes for the given time on the calling thread
+    void update(const std::time_t &time);
+
+    // starts or stops the worker thread which keeps the codes current
+    void start();
+    void stop();
+    inline bool running() const
+    { return this->_worker.joinable(); }
+
+    // number of replaced snapshots which are still referenced by readers
+    std::size_t pendingReclamation() const;
+
+private:
+    void publish(const std::time_t &time);
+    void run();
+
+    Clock _clock;
+
+    // reader side
+    mutable std::mutex _currentMutex;
+    Snapshot _current;
+
+    // writer side
+    mutable std::mutex _mutex;
+    std::condition_variable _wakeup;
+    std::shared_ptr<const TokenTable> _table;
+    bool _reschedule = false;
+    bool _stopping = false;
+    std::uint64_t _version = 0;
+    std::vector<std::weak_ptr<const CodeSnapshot>> _retired;
+
+    std::thread _worker;
+};
+
+#endif // CODEPUBLISHER_HPP
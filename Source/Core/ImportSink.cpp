@@ -0,0 +1,203 @@
+#include "ImportSink.hpp"
+
+#include "Internal/ParallelFor.hpp"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+    // tokens per validation round, progress is reported between rounds
+    static const std::size_t VALIDATION_BLOCK_SIZE = 4096U;
+
+    // ASCII case folding, matches COLLATE NOCASE of the label column
+    static std::string foldLabel(const std::string &label)
+    {
+        std::string folded(label);
+        std::transform(folded.begin(), folded.end(), folded.begin(), [](unsigned char c) {
+            return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : static_cast<char>(c);
+        });
+        return folded;
+    }
+
+    static bool isSpace(unsigned char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '\f' || c == '\v';
+    }
+
+    // base-32 secrets are case-insensitive and often grouped with spaces
+    static OTPToken::TokenSecret normalizeSecret(const std::string_view &secret)
+    {
+        OTPToken::TokenSecret normalized;
+        normalized.reserve(secret.size());
+        for (unsigned char c : secret)
+        {
+            if (isSpace(c))
+            {
+                continue;
+            }
+            normalized.push_back((c >= 'a' && c <= 'z') ? static_cast<char>(c - ('a' - 'A')) : static_cast<char>(c));
+        }
+        return normalized;
+    }
+
+    static std::string trim(const std::string &str)
+    {
+        auto begin = str.begin();
+        auto end = str.end();
+        while (begin != end && isSpace(static_cast<unsigned char>(*begin))) ++begin;
+        while (end != begin && isSpace(static_cast<unsigned char>(*(end - 1)))) --end;
+        return std::string(begin, end);
+    }
+}
+
+void ImportSink::reserve(const std::size_t &count)
+{
+    this->_tokens.reserve(count);
+}
+
+void ImportSink::add(const OTPToken &token)
+{
+    this->_tokens.emplace_back(token);
+}
+
+void ImportSink::add(OTPToken &&token)
+{
+    this->_tokens.emplace_back(std::move(token));
+}
+
+void ImportSink::setProgressCallback(const ProgressCallback &callback)
+{
+    this->_progress = callback;
+}
+
+void ImportSink::setThreadCount(const unsigned &threads)
+{
+    this->_threads = threads;
+}
+
+bool ImportSink::normalize(OTPToken &token)
+{
+    token.setLabel(trim(token.label()));
+    token.setSecret(normalizeSecret(token.secret()));
+
+    // fill in defaults for values the backup format doesn't carry
+    if (token.type() == OTPToken::TOTP || token.type() == OTPToken::HOTP)
+    {
+        if (token.digitLength() == 0U)
+        {
+            token.setDigitLength(token.defaultDigitLength());
+        }
+        if (token.algorithm() == OTPToken::Invalid)
+        {
+            token.setAlgorithm(token.defaultAlgorithm());
+        }
+    }
+    if (token.type() == OTPToken::TOTP && token.period() == 0U)
+    {
+        token.setPeriod(token.defaultPeriod());
+    }
+
+    return token.isValid();
+}
+
+TokenDatabase::Error ImportSink::commit(const bool &save)
+{
+    this->_statistics = Statistics();
+    this->_statistics.received = this->_tokens.size();
+
+    // existing tokens, folded label -> secret
+    TokenDatabase::TokenKeyList keys;
+    auto status = TokenDatabase::selectTokenKeys(keys);
+    if (status != TokenDatabase::Success)
+    {
+        return status;
+    }
+
+    std::unordered_map<std::string, OTPToken::TokenSecret> known;
+    known.reserve(keys.size() + this->_tokens.size());
+    for (auto&& key : keys)
+    {
+        known.emplace(foldLabel(key.first), normalizeSecret(key.second));
+    }
+    keys.clear();
+
+    // normalize and validate in parallel, computing a code is the expensive part
+    const auto total = this->_tokens.size();
+    std::vector<std::uint8_t> valid(total, 0U);
+
+    report(Validating, 0U, total);
+    for (std::size_t offset = 0; offset < total; offset += VALIDATION_BLOCK_SIZE)
+    {
+        const auto count = std::min(VALIDATION_BLOCK_SIZE, total - offset);
+        ParallelFor::run(count, [&](const std::size_t &i) {
+            valid[offset + i] = normalize(this->_tokens[offset + i]) ? 1U : 0U;
+        }, this->_threads);
+        report(Validating, offset + count, total);
+    }
+
+    // drop invalid tokens and duplicates, keeps the import order
+    TokenDatabase::OTPTokenList accepted;
+    accepted.reserve(total);
+
+    for (std::size_t i = 0; i < total; ++i)
+    {
+        if (!valid[i])
+        {
+            ++this->_statistics.invalid;
+            continue;
+        }
+
+        auto &token = this->_tokens[i];
+        const auto res = known.emplace(foldLabel(token.label()), token.secret());
+        if (!res.second)
+        {
+            if (res.first->second == token.secret())
+            {
+                ++this->_statistics.duplicates;
+            }
+            else
+            {
+                ++this->_statistics.conflicts;
+            }
+            continue;
+        }
+
+        accepted.emplace_back(std::move(token));
+    }
+
+    this->_tokens.clear();
+    this->_tokens.shrink_to_fit();
+
+    // single transaction with a single display order update
+    const auto inserting = accepted.size();
+    report(Inserting, 0U, inserting);
+    status = TokenDatabase::insertTokens(accepted, [&](std::size_t done) {
+        report(Inserting, done, inserting);
+    });
+    if (status != TokenDatabase::Success)
+    {
+        return status;
+    }
+    this->_statistics.imported = inserting;
+
+    if (save && inserting != 0)
+    {
+        report(Saving, 0U, 1U);
+        status = TokenDatabase::saveTokens();
+        if (status != TokenDatabase::Success)
+        {
+            return status;
+        }
+        report(Saving, 1U, 1U);
+    }
+
+    return TokenDatabase::Success;
+}
+
+void ImportSink::report(const Phase &phase, const std::size_t &done, const std::size_t &total) const
+{
+    if (this->_progress)
+    {
+        this->_progress(phase, done, total);
+    }
+}
@@ -0,0 +1,81 @@
+#ifndef IMPORTSINK_HPP
+#define IMPORTSINK_HPP
+
+#include "OTPToken.hpp"
+#include "TokenDatabase.hpp"
+
+#include <cstddef>
+#include <functional>
+
+/**
+ * Bulk import pipeline for the AppSupport importers.
+ *
+ * Importers emit tokens into the sink while they parse the backup. On
+ * commit() the collected tokens are normalized and validated in parallel,
+ * checked for duplicates against the stored tokens and inserted in a
+ * single transaction, followed by one saveTokens() call.
+ *
+ * A token is a duplicate when a token with the same label (case-insensitive,
+ * like the UNIQUE constraint of the database) and the same secret already
+ * exists. A token with an existing label but a different secret is a conflict.
+ * Both are skipped, the first token of the import wins.
+ */
+class ImportSink final
+{
+public:
+    enum Phase {
+        Validating,
+        Inserting,
+        Saving,
+    };
+
+    struct Statistics {
+        std::size_t received = 0;   // tokens emitted by the importer
+        std::size_t imported = 0;   // tokens inserted into the database
+        std::size_t invalid = 0;    // tokens which don't generate a valid code
+        std::size_t duplicates = 0; // same label and secret already exists
+        std::size_t conflicts = 0;  // same label with a different secret already exists
+    };
+
+    // receives the current phase and the processed token count of this phase
+    using ProgressCallback = std::function<void(const Phase &phase, std::size_t done, std::size_t total)>;
+
+    ImportSink() = default;
+
+    // reserve space when the number of tokens is known in advance
+    void reserve(const std::size_t &count);
+
+    // called by the importers for every parsed token
+    void add(const OTPToken &token);
+    void add(OTPToken &&token);
+
+    // number of tokens waiting for commit()
+    inline std::size_t size() const
+    { return this->_tokens.size(); }
+
+    void setProgressCallback(const ProgressCallback &callback);
+
+    // number of validation threads, 0 uses one per hardware thread
+    void setThreadCount(const unsigned &threads);
+
+    // run the pipeline; the token database must be open, the sink is empty afterwards
+    // set save to false to keep the changes in memory only
+    TokenDatabase::Error commit(const bool &save = true);
+
+    // statistics of the last commit()
+    inline const Statistics &statistics() const
+    { return this->_statistics; }
+
+    // normalize the token in-place and check if it is usable
+    static bool normalize(OTPToken &token);
+
+private:
+    TokenDatabase::OTPTokenList _tokens;
+    Statistics _statistics;
+    ProgressCallback _progress;
+    unsigned _threads = 0;
+
+    void report(const Phase &phase, const std::size_t &done, const std::size_t &total) const;
+};
+
+#endif // IMPORTSINK_HPP
@@ -0,0 +1,103 @@
+#include "MappedFile.hpp"
+
+#include <fstream>
+
+#if !defined(OS_WINDOWS) && !defined(OS_WASM)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPEDFILE_HAS_MMAP
+#endif
+
+MappedFile::MappedFile(const std::string &file)
+{
+    if (!map(file))
+    {
+        read(file);
+    }
+}
+
+MappedFile::~MappedFile()
+{
+#ifdef MAPPEDFILE_HAS_MMAP
+    if (this->_mapped)
+    {
+        munmap(this->_data, this->_size);
+    }
+#endif
+}
+
+bool MappedFile::map(const std::string &file)
+{
+#ifdef MAPPEDFILE_HAS_MMAP
+    const auto fd = open(file.c_str(), O_RDONLY);
+    if (fd == -1)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size <= 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    // the remainder of the last page is zero-filled by the kernel,
+    // which terminates the buffer unless the file fills the page
+    const auto size = static_cast<std::size_t>(st.st_size);
+    const auto pagesize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    if (size % pagesize == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    auto addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        return false;
+    }
+
+    madvise(addr, size, MADV_SEQUENTIAL);
+
+    this->_data = static_cast<char*>(addr);
+    this->_size = size;
+    this->_mapped = true;
+    return true;
+#else
+    (void) file;
+    return false;
+#endif
+}
+
+bool MappedFile::read(const std::string &file)
+{
+    std::ifstream in(file, std::ios::in | std::ios::binary | std::ios::ate);
+    if (!in.is_open())
+    {
+        return false;
+    }
+
+    const auto end = in.tellg();
+    if (end <= 0)
+    {
+        return false;
+    }
+
+    const auto size = static_cast<std::size_t>(end);
+    this->_buffer.resize(size + 1, '\0');
+
+    in.seekg(0, std::ios::beg);
+    if (!in.read(this->_buffer.data(), static_cast<std::streamsize>(size)))
+    {
+        this->_buffer.clear();
+        return false;
+    }
+
+    this->_data = this->_buffer.data();
+    this->_size = size;
+    return true;
+}
@@ -0,0 +1,61 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Private, writable memory mapping of a file for in-situ parsing.
+ *
+ * The mapping is copy-on-write: in-situ parsers may modify the buffer, only
+ * the touched pages are copied by the kernel and the file itself is never
+ * changed. The buffer is always followed by a null byte, so it can be
+ * handed to rapidjson's ParseInsitu() and rapidxml directly.
+ *
+ * When the file can't be mapped, or the null byte can't be guaranteed
+ * because the file ends exactly on a page boundary, the file is read
+ * into a heap buffer instead.
+ */
+class MappedFile final
+{
+public:
+    MappedFile(const std::string &file);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator= (const MappedFile &) = delete;
+
+    // file was opened and is not empty
+    inline bool valid() const
+    { return this->_data != nullptr && this->_size != 0; }
+
+    // null-terminated buffer, size() excludes the null byte
+    inline char *data()
+    { return this->_data; }
+    inline const char *data() const
+    { return this->_data; }
+    inline std::size_t size() const
+    { return this->_size; }
+
+    inline std::string_view view() const
+    { return std::string_view(this->_data, this->_size); }
+
+    // true when the file is backed by a memory mapping
+    inline bool mapped() const
+    { return this->_mapped; }
+
+private:
+    char *_data = nullptr;
+    std::size_t _size = 0;
+    bool _mapped = false;
+
+    // fallback storage when mapping isn't possible
+    std::vector<char> _buffer;
+
+    bool map(const std::string &file);
+    bool read(const std::string &file);
+};
+
+#endif // MAPPEDFILE_HPP
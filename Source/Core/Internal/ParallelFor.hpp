@@ -0,0 +1,99 @@
+#ifndef PARALLELFOR_HPP
+#define PARALLELFOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Minimal fork-join helper for CPU bound batch work.
+ *
+ * Indices are handed out in chunks from a shared counter, so workers which
+ * finish early pick up the remaining work. The calling thread participates
+ * as one of the workers. The first exception thrown by the function is
+ * rethrown on the calling thread after all workers finished.
+ */
+class ParallelFor final
+{
+    ParallelFor() = delete;
+
+public:
+    // number of workers to use, 0 means one per hardware thread
+    static unsigned threadCount(const unsigned &requested = 0)
+    {
+        if (requested != 0)
+        {
+            return requested;
+        }
+        return std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    // calls fn(index) for every index in [0, count)
+    template<typename Function>
+    static void run(const std::size_t &count, const Function &fn,
+                    const unsigned &threads = 0, const std::size_t &chunk = 64)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        const auto step = std::max<std::size_t>(1U, chunk);
+        const auto workers = static_cast<unsigned>(
+            std::min<std::size_t>(threadCount(threads), (count + step - 1) / step));
+
+        std::atomic<std::size_t> next{0};
+        std::exception_ptr error;
+        std::mutex errorMutex;
+
+        const auto worker = [&]{
+            try {
+                for (;;)
+                {
+                    const auto begin = next.fetch_add(step);
+                    if (begin >= count)
+                    {
+                        break;
+                    }
+                    const auto end = std::min(count, begin + step);
+                    for (auto i = begin; i < end; ++i)
+                    {
+                        fn(i);
+                    }
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+                // stop handing out more work
+                next = count;
+            }
+        };
+
+        std::vector<std::thread> pool;
+        pool.reserve(workers - 1);
+        for (auto i = 1U; i < workers; ++i)
+        {
+            pool.emplace_back(worker);
+        }
+        worker();
+
+        for (auto&& t : pool)
+        {
+            t.join();
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+#endif // PARALLELFOR_HPP
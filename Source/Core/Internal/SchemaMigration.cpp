@@ -0,0 +1,226 @@
+#include "SchemaMigration.hpp"
+
+#include <algorithm>
+
+#include <sqlite/sqlite3.h>
+#include <sqlite_modern_cpp.h>
+
+#include <cryptopp/sha.h>
+
+const SchemaMigration::Version SchemaMigration::CurrentVersion = 0x0f000006;
+
+namespace {
+    // the first element of a BLOB serialized std::vector<T>, 0 when empty
+    template<typename T>
+    T blobValue(const std::vector<T> &blob)
+    {
+        return blob.empty() ? T(0) : blob.at(0);
+    }
+
+    // 0x0f000005: digits, period and counter were single-element BLOBs
+    // of uint8_t, uint32_t and uint32_t, store them as native integers
+    bool migrateIntegerColumns(sqlite::database &db)
+    {
+        db << "create table 'tokens_v6' ("
+              "'id' INTEGER PRIMARY KEY NOT NULL, "
+              "'type' int(1) NOT NULL, "
+              "'label' text NOT NULL UNIQUE COLLATE NOCASE, "
+              "'icon' blob, "
+              "'secret' text NOT NULL, "
+              "'digits' integer NOT NULL, "
+              "'period' integer NOT NULL, "
+              "'counter' integer NOT NULL, "
+              "'algorithm' int(1) NOT NULL, "
+              "FOREIGN KEY(type) REFERENCES types(id), "
+              "FOREIGN KEY(algorithm) REFERENCES algorithms(id));";
+
+        // unchanged columns are copied by sqlite, only the BLOBs pass through here
+        db << "insert into tokens_v6 (id, type, label, icon, secret, digits, period, counter, algorithm) "
+              "select id, type, label, icon, secret, 0, 0, 0, algorithm from tokens;";
+
+        auto update = db << "update tokens_v6 set digits = ?, period = ?, counter = ? where id = ?;";
+        update.used(true); // don't execute on destruction when there are no tokens
+
+        db << "select id, digits, period, counter from tokens;"
+           >> [&](const std::int64_t &id,
+                  const std::vector<std::uint8_t> &digits,
+                  const std::vector<std::uint32_t> &period,
+                  const std::vector<std::uint32_t> &counter)
+        {
+            update << blobValue(digits) << blobValue(period) << blobValue(counter) << id;
+            update++;
+        };
+
+        db << "drop table tokens;";
+        db << "alter table tokens_v6 rename to tokens;";
+        return true;
+    }
+}
+
+const SchemaMigration::StepList &SchemaMigration::steps()
+{
+    // every step upgrades the schema from one version to the next one,
+    // bootstrapDatabase() must create the schema of the last step
+    static const StepList list = {
+        {0x0f000005, 0x0f000006, "native integer columns for digits, period and counter", migrateIntegerColumns},
+    };
+    return list;
+}
+
+SchemaMigration::Result SchemaMigration::migrate(sqlite::database &db, Version &version,
+                                                 const StepList &steps, const Version &target)
+{
+    if (version == target)
+    {
+        return UpToDate;
+    }
+
+    if (version > target)
+    {
+        return TooNew;
+    }
+
+    const auto rollback = [&]{
+        try {
+            db << "rollback;";
+        } catch (sqlite::sqlite_exception &) {
+        }
+    };
+
+    try {
+        db << "begin;";
+    } catch (sqlite::sqlite_exception &) {
+        return Failed;
+    }
+
+    auto current = version;
+
+    while (current < target)
+    {
+        const auto step = std::find_if(steps.begin(), steps.end(), [&](const Step &s) {
+            return s.from == current && s.to > s.from && s.to <= target;
+        });
+
+        if (step == steps.end())
+        {
+            rollback();
+            return NoPath;
+        }
+
+        try {
+            if (!step->apply(db))
+            {
+                rollback();
+                return Failed;
+            }
+        } catch (...) {
+            rollback();
+            return Failed;
+        }
+
+        current = step->to;
+    }
+
+    // record the new version and schema in the same transaction
+    if (!writeVersion(db, current) || !writeFingerprint(db, fingerprint(db)))
+    {
+        rollback();
+        return Failed;
+    }
+
+    try {
+        db << "commit;";
+    } catch (sqlite::sqlite_exception &) {
+        rollback();
+        return Failed;
+    }
+
+    version = current;
+    return Migrated;
+}
+
+bool SchemaMigration::readVersion(sqlite::database &db, Version &version)
+{
+    std::vector<Version> data;
+
+    try {
+        db << "select data from config where id = 'database' limit 1;" >> data;
+    } catch (sqlite::sqlite_exception &) {
+        return false;
+    }
+
+    if (data.empty())
+    {
+        return false;
+    }
+
+    version = data.at(0);
+    return true;
+}
+
+bool SchemaMigration::writeVersion(sqlite::database &db, const Version &version)
+{
+    try {
+        db << "update config set data = ? where id = 'database';"
+           << std::vector<Version>{version};
+    } catch (sqlite::sqlite_exception &) {
+        return false;
+    }
+
+    return sqlite3_changes(db.connection().get()) == 1;
+}
+
+SchemaMigration::Fingerprint SchemaMigration::fingerprint(sqlite::database &db)
+{
+    CryptoPP::SHA256 hash;
+
+    try {
+        // internal objects (auto indexes) have no sql and are skipped
+        db << "select type, name, sql from sqlite_master "
+              "where sql is not null order by type, name;"
+           >> [&](const std::string &type, const std::string &name, const std::string &sql)
+        {
+            for (auto&& str : {&type, &name, &sql})
+            {
+                // include the terminating null byte as field separator
+                hash.Update(reinterpret_cast<const CryptoPP::byte*>(str->c_str()), str->size() + 1);
+            }
+        };
+    } catch (sqlite::sqlite_exception &) {
+        return {};
+    }
+
+    Fingerprint digest(CryptoPP::SHA256::DIGESTSIZE);
+    hash.Final(digest.data());
+    return digest;
+}
+
+bool SchemaMigration::readFingerprint(sqlite::database &db, Fingerprint &fingerprint)
+{
+    fingerprint.clear();
+
+    try {
+        db << "select data from config where id = 'schema' limit 1;" >> fingerprint;
+    } catch (sqlite::sqlite_exception &) {
+        // databases without a fingerprint record yet
+        return false;
+    }
+
+    return !fingerprint.empty();
+}
+
+bool SchemaMigration::writeFingerprint(sqlite::database &db, const Fingerprint &fingerprint)
+{
+    if (fingerprint.empty())
+    {
+        return false;
+    }
+
+    try {
+        db << "insert or replace into config (id, data) values ('schema', ?);" << fingerprint;
+    } catch (sqlite::sqlite_exception &) {
+        return false;
+    }
+
+    return true;
+}
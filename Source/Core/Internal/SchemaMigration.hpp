@@ -0,0 +1,71 @@
+#ifndef SCHEMAMIGRATION_HPP
+#define SCHEMAMIGRATION_HPP
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace sqlite {
+    class database;
+}
+
+/**
+ * In-place schema migrations for the token database.
+ *
+ * Databases store their version in the config table. On load every step
+ * starting at the stored version is applied in order inside a single
+ * transaction, so a failing step leaves the database untouched.
+ *
+ * The schema fingerprint is a hash over the DDL of all tables and indexes.
+ * It is stored next to the version after a successful validation and
+ * allows the TokenDatabase to skip the full schema validation when the
+ * schema didn't change since.
+ */
+class SchemaMigration final
+{
+    SchemaMigration() = delete;
+
+public:
+    using Version = std::uint32_t;
+    using Fingerprint = std::vector<std::uint8_t>;
+
+    // version of the schema created by this library
+    static const Version CurrentVersion;
+
+    struct Step {
+        Version from;
+        Version to;
+        std::string description;
+        std::function<bool(sqlite::database &db)> apply;
+    };
+    using StepList = std::vector<Step>;
+
+    enum Result {
+        UpToDate,   // database is already at the target version
+        Migrated,   // all steps were applied and committed
+        TooNew,     // database was created by a newer version
+        NoPath,     // no step found to upgrade from the stored version
+        Failed,     // a step failed, all changes were rolled back
+    };
+
+    // built-in migration steps, ordered by version
+    static const StepList &steps();
+
+    // upgrade the database from the given version to the target version,
+    // version is set to the target version on success
+    static Result migrate(sqlite::database &db, Version &version,
+                          const StepList &steps = SchemaMigration::steps(),
+                          const Version &target = CurrentVersion);
+
+    // database version record
+    static bool readVersion(sqlite::database &db, Version &version);
+    static bool writeVersion(sqlite::database &db, const Version &version);
+
+    // schema fingerprint record
+    static Fingerprint fingerprint(sqlite::database &db);
+    static bool readFingerprint(sqlite::database &db, Fingerprint &fingerprint);
+    static bool writeFingerprint(sqlite::database &db, const Fingerprint &fingerprint);
+};
+
+#endif // SCHEMAMIGRATION_HPP
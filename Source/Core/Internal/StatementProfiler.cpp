@@ -0,0 +1,392 @@
+#include "StatementProfiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+
+#include <sqlite/sqlite3.h>
+
+namespace {
+    struct Entry {
+        std::string sample;
+        std::uint64_t rows = 0;
+        std::vector<std::uint64_t> latencies;
+    };
+
+    static std::mutex profiler_mutex;
+
+    // keyed by the normalized statement
+    static std::map<std::string, Entry> entries;
+
+    // start time and rows of the currently running executions
+    struct Execution {
+        std::chrono::steady_clock::time_point start;
+        std::uint64_t rows = 0;
+    };
+    static std::unordered_map<sqlite3_stmt*, Execution> running;
+
+    // cache of the normalized text per raw statement text, the same
+    // prepared statements are executed many times
+    static std::unordered_map<std::string, std::string> normalized_cache;
+
+    // set while resolving query plans, which are traced too
+    static std::atomic<bool> suspended{false};
+
+    static int trace_callback(unsigned type, void *, void *p, void *x)
+    {
+        if (suspended)
+        {
+            return 0;
+        }
+
+        auto stmt = static_cast<sqlite3_stmt*>(p);
+        std::lock_guard<std::mutex> lock(profiler_mutex);
+
+        // the time reported by SQLITE_TRACE_PROFILE only has millisecond
+        // resolution, statements are timed from SQLITE_TRACE_STMT instead
+        if (type == SQLITE_TRACE_STMT)
+        {
+            // also invoked for trigger programs, keep the first start
+            running.emplace(stmt, Execution{std::chrono::steady_clock::now(), 0});
+            return 0;
+        }
+
+        if (type == SQLITE_TRACE_ROW)
+        {
+            ++running[stmt].rows;
+            return 0;
+        }
+
+        if (type != SQLITE_TRACE_PROFILE)
+        {
+            return 0;
+        }
+
+        auto elapsed = *static_cast<const sqlite3_uint64*>(x);
+        std::uint64_t rows = 0;
+        const auto execution = running.find(stmt);
+        if (execution != running.end())
+        {
+            rows = execution->second.rows;
+            if (execution->second.start.time_since_epoch().count() != 0)
+            {
+                elapsed = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - execution->second.start).count());
+            }
+            running.erase(execution);
+        }
+
+        const auto text = sqlite3_sql(stmt);
+        if (!text)
+        {
+            return 0;
+        }
+
+        const std::string sql(text);
+        auto cached = normalized_cache.find(sql);
+        if (cached == normalized_cache.end())
+        {
+            cached = normalized_cache.emplace(sql, StatementProfiler::normalize(sql)).first;
+        }
+
+        auto &entry = entries[cached->second];
+        if (entry.sample.empty())
+        {
+            entry.sample = sql;
+        }
+        entry.rows += rows;
+        entry.latencies.emplace_back(elapsed);
+        return 0;
+    }
+
+    // nearest-rank percentile of a sorted list
+    static std::uint64_t percentile(const std::vector<std::uint64_t> &sorted, const unsigned &p)
+    {
+        if (sorted.empty())
+        {
+            return 0;
+        }
+        const auto rank = (sorted.size() * p + 99) / 100;
+        return sorted.at(rank == 0 ? 0 : rank - 1);
+    }
+
+    static bool explainable(const std::string &sql)
+    {
+        std::string keyword;
+        for (auto&& c : sql)
+        {
+            if (std::isalpha(static_cast<unsigned char>(c)))
+            {
+                keyword.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+            }
+            else if (!keyword.empty())
+            {
+                break;
+            }
+        }
+        return keyword == "select" || keyword == "insert" || keyword == "update" ||
+               keyword == "delete" || keyword == "replace" || keyword == "with";
+    }
+
+    static std::string query_plan(sqlite3 *db, const std::string &sql)
+    {
+        sqlite3_stmt *stmt = nullptr;
+        const auto explain = "explain query plan " + sql;
+        if (sqlite3_prepare_v2(db, explain.c_str(), -1, &stmt, nullptr) != SQLITE_OK || !stmt)
+        {
+            sqlite3_finalize(stmt);
+            return "(unavailable)\n";
+        }
+
+        // columns: id, parent, notused, detail
+        std::string plan;
+        std::map<int, std::size_t> depth;
+        while (sqlite3_step(stmt) == SQLITE_ROW)
+        {
+            const auto id = sqlite3_column_int(stmt, 0);
+            const auto parent = sqlite3_column_int(stmt, 1);
+            const auto detail = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
+
+            const auto it = depth.find(parent);
+            const auto level = it == depth.end() ? 0 : it->second + 1;
+            depth[id] = level;
+
+            plan.append(level * 2, ' ');
+            plan.append(detail ? detail : "");
+            plan.push_back('\n');
+        }
+        sqlite3_finalize(stmt);
+        return plan;
+    }
+
+    static void collapse(std::string &sql, const std::string &item, const std::string &separator)
+    {
+        // "a, a, a" -> "a, ..."
+        const auto pair = item + separator + item;
+        const auto collapsed = item + separator + "...";
+        const auto tail = "..." + separator + item;
+
+        for (auto pos = sql.find(pair); pos != std::string::npos; pos = sql.find(pair, pos))
+        {
+            sql.replace(pos, pair.size(), collapsed);
+        }
+        for (auto pos = sql.find(tail); pos != std::string::npos; pos = sql.find(tail, pos))
+        {
+            sql.replace(pos, tail.size(), "...");
+        }
+    }
+}
+
+void StatementProfiler::attach(sqlite3 *db)
+{
+    if (db)
+    {
+        sqlite3_trace_v2(db, SQLITE_TRACE_STMT | SQLITE_TRACE_PROFILE | SQLITE_TRACE_ROW, &trace_callback, nullptr);
+    }
+}
+
+void StatementProfiler::detach(sqlite3 *db)
+{
+    if (db)
+    {
+        sqlite3_trace_v2(db, 0, nullptr, nullptr);
+    }
+
+    std::lock_guard<std::mutex> lock(profiler_mutex);
+    running.clear();
+}
+
+void StatementProfiler::reset()
+{
+    std::lock_guard<std::mutex> lock(profiler_mutex);
+    entries.clear();
+    running.clear();
+    normalized_cache.clear();
+}
+
+StatementProfiler::StatisticsList StatementProfiler::statistics(sqlite3 *db)
+{
+    StatisticsList list;
+
+    profiler_mutex.lock();
+    for (auto&& entry : entries)
+    {
+        auto latencies = entry.second.latencies;
+        std::sort(latencies.begin(), latencies.end());
+
+        Statistics stats;
+        stats.statement = entry.first;
+        stats.sample = entry.second.sample;
+        stats.calls = latencies.size();
+        stats.rows = entry.second.rows;
+        for (auto&& ns : latencies)
+        {
+            stats.total += ns;
+        }
+        stats.p50 = percentile(latencies, 50);
+        stats.p99 = percentile(latencies, 99);
+        list.emplace_back(std::move(stats));
+    }
+    profiler_mutex.unlock();
+
+    if (db)
+    {
+        suspended = true;
+        for (auto&& stats : list)
+        {
+            if (explainable(stats.sample))
+            {
+                stats.plan = query_plan(db, stats.sample);
+            }
+        }
+        suspended = false;
+    }
+
+    std::sort(list.begin(), list.end(), [](const Statistics &a, const Statistics &b) {
+        return a.total > b.total;
+    });
+    return list;
+}
+
+std::string StatementProfiler::report(sqlite3 *db)
+{
+    const auto list = statistics(db);
+
+    std::uint64_t calls = 0;
+    for (auto&& stats : list)
+    {
+        calls += stats.calls;
+    }
+
+    char line[128];
+    std::snprintf(line, sizeof(line), "SQL statement profile (%zu statements, %llu executions):\n",
+                  list.size(), static_cast<unsigned long long>(calls));
+    std::string out = line;
+    out += "   calls       rows   total ms     p50 us     p99 us  statement\n";
+
+    for (auto&& stats : list)
+    {
+        std::snprintf(line, sizeof(line), "%8llu %10llu %10.3f %10.1f %10.1f  ",
+                      static_cast<unsigned long long>(stats.calls),
+                      static_cast<unsigned long long>(stats.rows),
+                      static_cast<double>(stats.total) / 1e6,
+                      static_cast<double>(stats.p50) / 1e3,
+                      static_cast<double>(stats.p99) / 1e3);
+        out += line;
+        out += stats.statement;
+        out.push_back('\n');
+
+        // query plan below the statement
+        std::size_t pos = 0;
+        while (pos < stats.plan.size())
+        {
+            const auto end = stats.plan.find('\n', pos);
+            out += std::string(54, ' ') + "| ";
+            out += stats.plan.substr(pos, end - pos);
+            out.push_back('\n');
+            pos = end == std::string::npos ? stats.plan.size() : end + 1;
+        }
+    }
+
+    return out;
+}
+
+std::string StatementProfiler::normalize(const std::string &sql)
+{
+    std::string out;
+    out.reserve(sql.size());
+
+    const auto is_ident = [](const char &c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$';
+    };
+
+    for (std::size_t i = 0; i < sql.size();)
+    {
+        const auto c = sql[i];
+
+        // 'string' and x'blob' literals, quotes are escaped by doubling
+        if (c == '\'' || ((c == 'x' || c == 'X') && i + 1 < sql.size() && sql[i + 1] == '\'' &&
+                          (out.empty() || !is_ident(out.back()))))
+        {
+            i += c == '\'' ? 1 : 2;
+            for (; i < sql.size(); ++i)
+            {
+                if (sql[i] == '\'')
+                {
+                    if (i + 1 < sql.size() && sql[i + 1] == '\'')
+                    {
+                        ++i;
+                        continue;
+                    }
+                    ++i;
+                    break;
+                }
+            }
+            out.push_back('?');
+        }
+
+        // quoted identifiers are kept
+        else if (c == '"' || c == '`' || c == '[')
+        {
+            const auto close = c == '[' ? ']' : c;
+            auto end = sql.find(close, i + 1);
+            end = end == std::string::npos ? sql.size() : end + 1;
+            out.append(sql, i, end - i);
+            i = end;
+        }
+
+        // numeric literals, but not digits inside identifiers
+        else if (std::isdigit(static_cast<unsigned char>(c)) && (out.empty() || !is_ident(out.back())))
+        {
+            while (i < sql.size() && (is_ident(sql[i]) || sql[i] == '.'))
+            {
+                ++i;
+            }
+            out.push_back('?');
+        }
+
+        // numbered and named parameters
+        else if (c == '?' || ((c == ':' || c == '@') && i + 1 < sql.size() && is_ident(sql[i + 1])))
+        {
+            ++i;
+            while (i < sql.size() && is_ident(sql[i]))
+            {
+                ++i;
+            }
+            out.push_back('?');
+        }
+
+        else if (std::isspace(static_cast<unsigned char>(c)))
+        {
+            while (i < sql.size() && std::isspace(static_cast<unsigned char>(sql[i])))
+            {
+                ++i;
+            }
+            if (!out.empty() && out.back() != ' ')
+            {
+                out.push_back(' ');
+            }
+        }
+
+        else
+        {
+            out.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(c))));
+            ++i;
+        }
+    }
+
+    while (!out.empty() && (out.back() == ' ' || out.back() == ';'))
+    {
+        out.pop_back();
+    }
+
+    collapse(out, "when ? then ?", " ");
+    collapse(out, "?", ",");
+    collapse(out, "?", ", ");
+    return out;
+}
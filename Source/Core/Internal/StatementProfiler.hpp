@@ -0,0 +1,59 @@
+#ifndef STATEMENTPROFILER_HPP
+#define STATEMENTPROFILER_HPP
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct sqlite3;
+
+/**
+ * SQL statement profiler for the token database connection.
+ *
+ * Built on sqlite3_trace_v2(): every statement execution is timed from
+ * SQLITE_TRACE_STMT to SQLITE_TRACE_PROFILE, SQLITE_TRACE_ROW counts the
+ * returned rows.
+ * Executions are aggregated per normalized statement, literals are replaced
+ * by "?" and repeated "when ? then ?" and "?, ?" lists are collapsed, so the
+ * generated display order queries end up in one bucket regardless of the
+ * number of tokens.
+ *
+ * The report lists call count, rows, total, p50 and p99 latency and the
+ * EXPLAIN QUERY PLAN output of a sample of every distinct statement.
+ */
+class StatementProfiler final
+{
+    StatementProfiler() = delete;
+
+public:
+    struct Statistics {
+        std::string statement;      // normalized statement
+        std::string sample;         // first seen statement text, used for the query plan
+        std::uint64_t calls = 0;
+        std::uint64_t rows = 0;
+        std::uint64_t total = 0;    // nanoseconds
+        std::uint64_t p50 = 0;      // nanoseconds
+        std::uint64_t p99 = 0;      // nanoseconds
+        std::string plan;           // EXPLAIN QUERY PLAN, one step per line
+    };
+    using StatisticsList = std::vector<Statistics>;
+
+    // start and stop tracing the connection
+    static void attach(sqlite3 *db);
+    static void detach(sqlite3 *db);
+
+    // drop all collected statistics
+    static void reset();
+
+    // collected statistics ordered by total time, query plans are only
+    // resolved when a connection is given
+    static StatisticsList statistics(sqlite3 *db = nullptr);
+
+    // formatted report of statistics(db)
+    static std::string report(sqlite3 *db = nullptr);
+
+    // replaces literals with "?" and collapses whitespace and repeated lists
+    static std::string normalize(const std::string &sql);
+};
+
+#endif // STATEMENTPROFILER_HPP
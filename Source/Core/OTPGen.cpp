@@ -25,33 +25,29 @@ namespace {
         10000000000,
     };
 
-    static const std::string normalize_secret(const std::string &secret)
+    // secret material only lives in the locked arena
+    static SecureString normalize_secret(const std::string_view &secret)
     {
-        auto nK = static_cast<char*>(std::calloc(1, secret.size() + 1));
+        SecureString normalized;
+        normalized.reserve(secret.size());
 
-        std::size_t i = 0, j = 0;
-        while (secret[i] != '\0')
+        for (auto&& c : secret)
         {
-            if (secret[i] != ' ')
+            // stop at an embedded null byte like the C string handling before
+            if (c == '\0')
             {
-                if (secret[i] >= 'a' && secret[i] <= 'z')
-                {
-                    nK[j++] = static_cast<char>( (secret[i] - 32) );
-                }
-                else
-                {
-                    nK[j++] = secret[i];
-                }
+                break;
+            }
+            if (c != ' ')
+            {
+                normalized.push_back(c >= 'a' && c <= 'z' ? static_cast<char>(c - 32) : c);
             }
-            i++;
         }
 
-        std::string normalized(nK, nK + strlen(nK));
-        std::free(nK);
         return normalized;
     }
 
-    static const std::string base32_rfc4648_decode(const std::string &key)
+    static SecureString base32_rfc4648_decode(const SecureString &key)
     {
         if (key.empty())
         {
@@ -71,12 +67,12 @@ namespace {
         decoder->IsolatedInitialize(params);
 
         // raw pointers are automatically deleted by crypto++
-        std::string base32;
-        decoder->Attach(new CryptoPP::StringSink(base32));
+        SecureString base32;
+        decoder->Attach(new CryptoPP::StringSinkTemplate<SecureString>(base32));
 
         // result may be binary (unsigned char)
         try {
-            CryptoPP::StringSource(key, true, decoder);
+            CryptoPP::StringSource(reinterpret_cast<const CryptoPP::byte*>(key.data()), key.size(), true, decoder);
         } catch (...) {
             return {};
         }
@@ -86,7 +82,7 @@ namespace {
 
     // template helper function to compute HMAC's of different SHA algorithms
     template<class CryptoPPHMacClass>
-    static inline const std::string compute_hmac_helper(const std::string &key, unsigned char value[8])
+    static inline std::string compute_hmac_helper(const SecureString &key, unsigned char value[8])
     {
         CryptoPPHMacClass cryptoHmac(reinterpret_cast<const unsigned char*>(key.data()), key.size());
 
@@ -97,7 +93,7 @@ namespace {
         return hmac;
     }
 
-    static const std::string compute_hmac(const std::string &key, long C, const OTPToken::ShaAlgorithm &algo)
+    static std::string compute_hmac(const std::string_view &key, long C, const OTPToken::ShaAlgorithm &algo)
     {
         // normalize and decode secret
         const auto normalized_key = normalize_secret(key);
@@ -135,7 +131,7 @@ namespace {
         return hmac;
     }
 
-    static const std::string finalize(const OTPToken::DigitType &digits_length, int tk)
+    static std::string finalize(const OTPToken::DigitType &digits_length, int tk)
     {
         auto token = static_cast<char*>(std::malloc(digits_length + 1));
 
@@ -163,6 +159,33 @@ namespace {
             ((hmac[offset + 3] & 0xff));
     }
 
+    // compute_bin_code() on a raw digest
+    static std::uint32_t digest_bin_code(const unsigned char *digest, const std::size_t &size)
+    {
+        const auto offset = digest[size - 1] & 0x0f;
+        return
+            ((static_cast<std::uint32_t>(digest[offset]) & 0x7f) << 24) |
+            ((static_cast<std::uint32_t>(digest[offset + 1]) & 0xff) << 16) |
+            ((static_cast<std::uint32_t>(digest[offset + 2]) & 0xff) << 8) |
+            ((static_cast<std::uint32_t>(digest[offset + 3]) & 0xff));
+    }
+
+    // HMAC of the big endian counter into a stack buffer, avoids the
+    // string sinks of compute_hmac()
+    template<class CryptoPPHMacClass>
+    static std::size_t digest_helper(const std::string_view &key, const std::uint64_t &counter, unsigned char *digest)
+    {
+        unsigned char message[8];
+        for (auto i = 0; i < 8; ++i)
+        {
+            message[7 - i] = static_cast<unsigned char>(counter >> (i * 8));
+        }
+
+        CryptoPPHMacClass cryptoHmac(reinterpret_cast<const unsigned char*>(key.data()), key.size());
+        cryptoHmac.CalculateDigest(digest, message, sizeof(message));
+        return CryptoPPHMacClass::DIGESTSIZE;
+    }
+
     static int truncate(const std::string &hmac,
                         const OTPToken::DigitType &digits_length,
                         const OTPToken::ShaAlgorithm algo)
@@ -187,11 +210,11 @@ namespace {
         return token;
     }
 
-    static const OTPToken::TokenString hotp_helper(const OTPToken::TokenSecret &base32_secret,
-                                                   const std::time_t &counter,
-                                                   const OTPToken::DigitType &digits,
-                                                   const OTPToken::ShaAlgorithm &sha_algo,
-                                                   OTPGenErrorCode *error)
+    static OTPToken::TokenString hotp_helper(const std::string_view &base32_secret,
+                                             const std::time_t &counter,
+                                             const OTPToken::DigitType &digits,
+                                             const OTPToken::ShaAlgorithm &sha_algo,
+                                             OTPGenErrorCode *error)
     {
         const auto hmac = compute_hmac(base32_secret, counter, sha_algo);
         if (hmac.empty())
@@ -229,22 +252,22 @@ namespace {
 }
 
 // compute totp at current time
-const OTPToken::TokenString OTPGen::computeTOTP(const OTPToken::TokenSecret &base32_secret,
-                                                const OTPToken::DigitType &digits,
-                                                const OTPToken::PeriodType &period,
-                                                const OTPToken::ShaAlgorithm &sha_algo,
-                                                OTPGenErrorCode *error)
+OTPToken::TokenString OTPGen::computeTOTP(const std::string_view &base32_secret,
+                                          const OTPToken::DigitType &digits,
+                                          const OTPToken::PeriodType &period,
+                                          const OTPToken::ShaAlgorithm &sha_algo,
+                                          OTPGenErrorCode *error)
 {
     return computeTOTP(time(nullptr), base32_secret, digits, period, sha_algo, error);
 }
 
 // compute totp at a given time
-const OTPToken::TokenString OTPGen::computeTOTP(const std::time_t &time,
-                                                const OTPToken::TokenSecret &base32_secret,
-                                                const OTPToken::DigitType &digits,
-                                                const OTPToken::PeriodType &period,
-                                                const OTPToken::ShaAlgorithm &sha_algo,
-                                                OTPGenErrorCode *error)
+OTPToken::TokenString OTPGen::computeTOTP(const std::time_t &time,
+                                          const std::string_view &base32_secret,
+                                          const OTPToken::DigitType &digits,
+                                          const OTPToken::PeriodType &period,
+                                          const OTPToken::ShaAlgorithm &sha_algo,
+                                          OTPGenErrorCode *error)
 {
     if (!check_otp_length(digits))
     {
@@ -264,11 +287,11 @@ const OTPToken::TokenString OTPGen::computeTOTP(const std::time_t &time,
 }
 
 // compute hotp
-const OTPToken::TokenString OTPGen::computeHOTP(const OTPToken::TokenSecret &base32_secret,
-                                                const OTPToken::CounterType &counter,
-                                                const OTPToken::DigitType &digits,
-                                                const OTPToken::ShaAlgorithm &sha_algo,
-                                                OTPGenErrorCode *error)
+OTPToken::TokenString OTPGen::computeHOTP(const std::string_view &base32_secret,
+                                          const OTPToken::CounterType &counter,
+                                          const OTPToken::DigitType &digits,
+                                          const OTPToken::ShaAlgorithm &sha_algo,
+                                          OTPGenErrorCode *error)
 {
     if (!check_algo(sha_algo))
     {
@@ -286,16 +309,16 @@ const OTPToken::TokenString OTPGen::computeHOTP(const OTPToken::TokenSecret &bas
 }
 
 // compute steam token at current time
-const OTPToken::TokenString OTPGen::computeSteam(const OTPToken::TokenSecret &base32_secret,
-                                                 OTPGenErrorCode *error)
+OTPToken::TokenString OTPGen::computeSteam(const std::string_view &base32_secret,
+                                           OTPGenErrorCode *error)
 {
     return computeSteam(time(nullptr), base32_secret, error);
 }
 
 // compute steam token at a given time
-const OTPToken::TokenString OTPGen::computeSteam(const std::time_t &time,
-                                                 const OTPToken::TokenSecret &base32_secret,
-                                                 OTPGenErrorCode *error)
+OTPToken::TokenString OTPGen::computeSteam(const std::time_t &time,
+                                           const std::string_view &base32_secret,
+                                           OTPGenErrorCode *error)
 {
     static const std::string steam_alphabet = "23456789BCDFGHJKMNPQRTVWXY";
 
@@ -323,3 +346,63 @@ const OTPToken::TokenString OTPGen::computeSteam(const std::time_t &time,
     std::string codeStr(code, code + strlen(code));
     return codeStr;
 }
+
+SecureString OTPGen::decodeSecret(const std::string_view &base32_secret)
+{
+    return base32_rfc4648_decode(normalize_secret(base32_secret));
+}
+
+bool OTPGen::computeFromKey(const std::string_view &key,
+                            const OTPToken::TokenType &type,
+                            const std::uint64_t &counter,
+                            const OTPToken::DigitType &digits,
+                            const OTPToken::ShaAlgorithm &sha_algo,
+                            OTPToken::TokenString &code)
+{
+    code.clear();
+
+    if (key.empty())
+    {
+        return false;
+    }
+
+    unsigned char digest[SHA512_DIGEST_SIZE];
+    std::size_t size = 0;
+
+    if (type == OTPToken::Steam)
+    {
+        size = digest_helper<CryptoPP::HMAC<CryptoPP::SHA1>>(key, counter, digest);
+
+        static const char steam_alphabet[] = "23456789BCDFGHJKMNPQRTVWXY";
+        auto bin_code = digest_bin_code(digest, size);
+        for (auto i = 0; i < 5; i++)
+        {
+            code.push_back(steam_alphabet[bin_code % 26]);
+            bin_code /= 26;
+        }
+        return true;
+    }
+
+    if ((type != OTPToken::TOTP && type != OTPToken::HOTP) || !check_otp_length(digits))
+    {
+        return false;
+    }
+
+    switch (sha_algo)
+    {
+        case OTPToken::SHA1:   size = digest_helper<CryptoPP::HMAC<CryptoPP::SHA1>>(key, counter, digest); break;
+        case OTPToken::SHA256: size = digest_helper<CryptoPP::HMAC<CryptoPP::SHA256>>(key, counter, digest); break;
+        case OTPToken::SHA512: size = digest_helper<CryptoPP::HMAC<CryptoPP::SHA512>>(key, counter, digest); break;
+        default: return false;
+    }
+
+    // zero padded decimal, same as finalize()
+    auto value = digest_bin_code(digest, size) % DIGITS_POWER[digits];
+    code.assign(digits, '0');
+    for (auto i = digits; i > 0 && value != 0; --i)
+    {
+        code[i - 1] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+    return true;
+}
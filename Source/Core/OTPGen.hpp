@@ -36,35 +36,48 @@ public:
     inline static OTPToken::CounterType maxCounter() { return std::numeric_limits<OTPToken::CounterType>::max(); }
 
     // compute totp at current time
-    static const OTPToken::TokenString computeTOTP(const OTPToken::TokenSecret &base32_secret,
-                                                   const OTPToken::DigitType &digits,
-                                                   const OTPToken::PeriodType &period,
-                                                   const OTPToken::ShaAlgorithm &sha_algo,
-                                                   OTPGenErrorCode *error = nullptr);
+    static OTPToken::TokenString computeTOTP(const std::string_view &base32_secret,
+                                             const OTPToken::DigitType &digits,
+                                             const OTPToken::PeriodType &period,
+                                             const OTPToken::ShaAlgorithm &sha_algo,
+                                             OTPGenErrorCode *error = nullptr);
 
     // compute totp at a given time
-    static const OTPToken::TokenString computeTOTP(const std::time_t &time,
-                                                   const OTPToken::TokenSecret &base32_secret,
-                                                   const OTPToken::DigitType &digits,
-                                                   const OTPToken::PeriodType &period,
-                                                   const OTPToken::ShaAlgorithm &sha_algo,
-                                                   OTPGenErrorCode *error = nullptr);
+    static OTPToken::TokenString computeTOTP(const std::time_t &time,
+                                             const std::string_view &base32_secret,
+                                             const OTPToken::DigitType &digits,
+                                             const OTPToken::PeriodType &period,
+                                             const OTPToken::ShaAlgorithm &sha_algo,
+                                             OTPGenErrorCode *error = nullptr);
 
     // compute hotp
-    static const OTPToken::TokenString computeHOTP(const OTPToken::TokenSecret &base32_secret,
-                                                   const OTPToken::CounterType &counter,
-                                                   const OTPToken::DigitType &digits,
-                                                   const OTPToken::ShaAlgorithm &sha_algo,
-                                                   OTPGenErrorCode *error = nullptr);
+    static OTPToken::TokenString computeHOTP(const std::string_view &base32_secret,
+                                             const OTPToken::CounterType &counter,
+                                             const OTPToken::DigitType &digits,
+                                             const OTPToken::ShaAlgorithm &sha_algo,
+                                             OTPGenErrorCode *error = nullptr);
 
     // compute steam token at current time
-    static const OTPToken::TokenString computeSteam(const OTPToken::TokenSecret &base32_secret,
-                                                    OTPGenErrorCode *error = nullptr);
+    static OTPToken::TokenString computeSteam(const std::string_view &base32_secret,
+                                              OTPGenErrorCode *error = nullptr);
 
     // compute steam token at a given time
-    static const OTPToken::TokenString computeSteam(const std::time_t &time,
-                                                    const OTPToken::TokenSecret &base32_secret,
-                                                    OTPGenErrorCode *error = nullptr);
+    static OTPToken::TokenString computeSteam(const std::time_t &time,
+                                              const std::string_view &base32_secret,
+                                              OTPGenErrorCode *error = nullptr);
+
+    // decode a base-32 secret into the raw HMAC key, empty on error
+    static SecureString decodeSecret(const std::string_view &base32_secret);
+
+    // compute a code from an already decoded key, used for bulk generation
+    // the counter is the hotp counter or the time step of totp and steam tokens
+    // the code is assigned to the given string to reuse its storage
+    static bool computeFromKey(const std::string_view &key,
+                               const OTPToken::TokenType &type,
+                               const std::uint64_t &counter,
+                               const OTPToken::DigitType &digits,
+                               const OTPToken::ShaAlgorithm &sha_algo,
+                               OTPToken::TokenString &code);
 };
 
 #endif // OTPGEN_HPP
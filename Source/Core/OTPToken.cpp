@@ -1,7 +1,7 @@
 #include "OTPToken.hpp"
 #include "OTPGen.hpp"
 
-#include "TokenDatabase.hpp"
+#include "TokenCatalog.hpp"
 
 #include <cryptopp/base64.h>
 #include <cryptopp/base32.h>
@@ -26,7 +26,7 @@ OTPToken::OTPToken(const TokenType &type)
 OTPToken::OTPToken(const TokenType &type,
                    const Label &label,
                    const Icon &icon,
-                   const TokenSecret &secret,
+                   const std::string_view &secret,
                    const DigitType &digits,
                    const PeriodType &period,
                    const CounterType &counter,
@@ -34,8 +34,8 @@ OTPToken::OTPToken(const TokenType &type,
 {
     this->_type = type;
     this->_label = label;
-    this->_icon = icon;
-    this->_secret = secret;
+    this->setIcon(icon);
+    this->_secret.assign(secret.data(), secret.size());
     this->_digits = digits;
     this->_period = period;
     this->_counter = counter;
@@ -45,12 +45,12 @@ OTPToken::OTPToken(const TokenType &type,
 OTPToken::OTPToken(const TokenType &type,
                    const Label &label,
                    const Icon &icon,
-                   const TokenSecret &secret)
+                   const std::string_view &secret)
     : OTPToken(type)
 {
     this->_label = label;
-    this->_icon = icon;
-    this->_secret = secret;
+    this->setIcon(icon);
+    this->_secret.assign(secret.data(), secret.size());
 }
 
 OTPToken::OTPToken(const TokenType &type,
@@ -60,33 +60,42 @@ OTPToken::OTPToken(const TokenType &type,
     this->_label = label;
 }
 
-OTPToken::OTPToken(const OTPToken &other)
-    : OTPToken()
+void OTPToken::setIcon(const Icon &icon)
 {
-    this->_type = other._type;
-    this->_label = other._label;
-    this->_icon = other._icon;
-    this->_secret = other._secret;
-    this->_digits = other._digits;
-    this->_period = other._period;
-    this->_counter = other._counter;
-    this->_algorithm = other._algorithm;
-
-    this->_id = other._id;
+    this->setIcon(Icon(icon));
 }
 
-OTPToken::~OTPToken()
+void OTPToken::setIcon(Icon &&icon)
 {
-    this->_type = None;
-    this->_label.clear();
-    this->_icon.clear();
-    this->_secret.clear();
-    this->_digits = 0U;
-    this->_period = 0U;
-    this->_counter = 0U;
-    this->_algorithm = Invalid;
-
-    this->_id = 0U;
+    if (icon.empty())
+    {
+        this->_icon.reset();
+    }
+    else
+    {
+        this->_icon = std::make_shared<const Icon>(std::move(icon));
+    }
+}
+
+void OTPToken::setIcon(const unsigned char *icon, const std::size_t &size)
+{
+    this->setIcon(Icon(icon, icon + size));
+}
+
+const OTPToken::Icon &OTPToken::icon() const
+{
+    static const Icon empty;
+    return this->_icon ? *this->_icon : empty;
+}
+
+bool OTPToken::iconEquals(const OTPToken &other) const
+{
+    // copies share the same buffer
+    if (this->_icon == other._icon)
+    {
+        return true;
+    }
+    return this->icon() == other.icon();
 }
 
 bool OTPToken::importBase64Secret(const std::string &base64_str)
@@ -108,7 +117,7 @@ bool OTPToken::importBase64Secret(const std::string &base64_str)
                                                             static_cast<const CryptoPP::byte*>(ALPHABET));
         encoder->IsolatedInitialize(params);
 
-        encoder->Attach(new CryptoPP::StringSink(_secret));
+        encoder->Attach(new CryptoPP::StringSinkTemplate<TokenSecret>(_secret));
 
         // decode and reencode base-64 data into base-32
         CryptoPP::StringSource src(base64_str, true,
@@ -127,28 +136,16 @@ bool OTPToken::importBase64Secret(const std::string &base64_str)
     return true;
 }
 
-const OTPToken::TokenString OTPToken::convertBase64Secret(const std::string &base64_str)
+OTPToken::TokenString OTPToken::convertBase64Secret(const std::string &base64_str)
 {
     OTPToken token;
     token.importBase64Secret(base64_str);
-    return token.secret();
+    return TokenString(token.secret());
 }
 
-const std::string OTPToken::typeName() const
+std::string OTPToken::typeName() const
 {
-    const auto name = TokenDatabase::selectTokenTypeName(static_cast<sqliteTypesID>(this->_type));
-    // fallback when database is not connected
-    if (name.empty())
-    {
-        switch (this->_type)
-        {
-            case None:  return {};
-            case TOTP:  return "TOTP";
-            case HOTP:  return "HOTP";
-            case Steam: return "Steam";
-        }
-    }
-    return name;
+    return TokenCatalog::typeName(static_cast<sqliteTypesID>(this->_type));
 }
 
 void OTPToken::setAlgorithm(const std::string &algorithm_name)
@@ -176,21 +173,9 @@ void OTPToken::setAlgorithm(const std::string &algorithm_name)
     }
 }
 
-const std::string OTPToken::algorithmName() const
+std::string OTPToken::algorithmName() const
 {
-    const auto name = TokenDatabase::selectAlgorithmName(static_cast<sqliteAlgorithmsID>(this->_algorithm));
-    // fallback when database is not connected
-    if (name.empty())
-    {
-        switch (this->_algorithm)
-        {
-            case Invalid: return {};
-            case SHA1:    return "SHA1";
-            case SHA256:  return "SHA256";
-            case SHA512:  return "SHA512";
-        }
-    }
-    return name;
+    return TokenCatalog::algorithmName(static_cast<sqliteAlgorithmsID>(this->_algorithm));
 }
 
 OTPToken::DigitType OTPToken::defaultDigitLength(const TokenType &type)
@@ -322,7 +307,7 @@ bool OTPToken::isValid() const
     return !(token.empty() || error != OTPGenErrorCode::Valid);
 }
 
-const OTPToken::TokenString OTPToken::generateToken(OTPGenErrorCode *error) const
+OTPToken::TokenString OTPToken::generateToken(OTPGenErrorCode *error) const
 {
     if (error)
     {
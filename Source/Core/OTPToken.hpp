@@ -2,10 +2,14 @@
 #define OTPTOKEN_HPP
 
 #include <iostream>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cinttypes>
 
+#include "SecureAllocator.hpp"
+
 enum class OTPGenErrorCode;
 
 class OTPToken
@@ -13,12 +17,12 @@ class OTPToken
 public:
     using TokenType = std::uint8_t;
     using TokenString = std::string;
-    using TokenSecret = std::string;
+    using TokenSecret = SecureString; // zeroed on free, see SecureAllocator.hpp
     using Label = std::string;
     using Icon = std::vector<unsigned char>;
     using DigitType = std::uint8_t;
     using PeriodType = std::uint32_t;
-    using CounterType = std::uint32_t;
+    using CounterType = std::uint64_t;
     using ShaAlgorithm = std::uint8_t;
 
     // sqlite database mapping
@@ -63,7 +67,7 @@ public:
     OTPToken(const TokenType &type,
              const Label &label,
              const Icon &icon,
-             const TokenSecret &secret,
+             const std::string_view &secret,
              const DigitType &digits,
              const PeriodType &period,
              const CounterType &counter,
@@ -76,7 +80,7 @@ public:
     OTPToken(const TokenType &type,
              const Label &label,
              const Icon &icon,
-             const TokenSecret &secret);
+             const std::string_view &secret);
 
     /**
      * construct an invalid token of the given type and a label
@@ -85,14 +89,14 @@ public:
              const Label &label);
 
     /**
-     * copy constructor
+     * copy and move
+     * copies share the icon buffer, the secret is zeroed when freed
      */
-    OTPToken(const OTPToken &other);
-
-    /**
-     * destroy token object
-     */
-    ~OTPToken();
+    OTPToken(const OTPToken &other) = default;
+    OTPToken(OTPToken &&other) noexcept = default;
+    OTPToken &operator= (const OTPToken &other) = default;
+    OTPToken &operator= (OTPToken &&other) noexcept = default;
+    ~OTPToken() = default;
 
     // Steam tokens are stored in base-64 (RFC 3548, RFC 4648) on the device,
     // but the library libcotp only supports base-32 (RFC 4648) input.
@@ -103,14 +107,14 @@ public:
     // Static wrapper function for the above method.
     // Converts the base-64 Steam token to base-32 and returns it.
     // On error an empty string is returned.
-    static const TokenString convertBase64Secret(const std::string &base64_str);
+    static TokenString convertBase64Secret(const std::string &base64_str);
 
     // Type
     inline void setType(const TokenType &type)
     { this->_type = type; }
     inline const TokenType &type() const
     { return this->_type; }
-    const std::string typeName() const;
+    std::string typeName() const;
 
     // Label
     inline void setLabel(const Label &label)
@@ -119,21 +123,23 @@ public:
     { return this->_label; }
 
     // Icon
-    // images are stored as std::strings for easier management
-    inline void setIcon(const Icon &icon)
+    // images are immutable and shared between copies of the token
+    void setIcon(const Icon &icon);
+    void setIcon(Icon &&icon);
+    void setIcon(const unsigned char *icon, const std::size_t &size);
+    inline void setIcon(const std::shared_ptr<const Icon> &icon)
     { this->_icon = icon; }
-    inline void setIcon(const unsigned char *icon, const std::size_t &size)
-    { this->_icon = Icon(icon, icon + size); }
-    inline const Icon &icon() const
+    const Icon &icon() const;
+    inline const std::shared_ptr<const Icon> &sharedIcon() const
     { return this->_icon; }
     inline const unsigned char *iconBuffer() const
-    { return this->_icon.data(); }
+    { return this->_icon ? this->_icon->data() : nullptr; }
     inline std::size_t iconBufferSize() const
-    { return this->_icon.size(); }
+    { return this->_icon ? this->_icon->size() : 0U; }
 
     // Secret
-    inline void setSecret(const TokenSecret &secret)
-    { this->_secret = secret; }
+    inline void setSecret(const std::string_view &secret)
+    { this->_secret.assign(secret.data(), secret.size()); }
     inline const TokenSecret &secret() const
     { return this->_secret; }
 
@@ -165,7 +171,7 @@ public:
     inline const ShaAlgorithm &algorithm() const
     { return this->_algorithm; }
     void setAlgorithm(const std::string &algorithm_name);
-    const std::string algorithmName() const;
+    std::string algorithmName() const;
 
     // ID
     inline const sqliteTokenID &id() const
@@ -222,7 +228,7 @@ public:
     /**
      * tries to generate a one-time password token
      */
-    const TokenString generateToken(OTPGenErrorCode *error = nullptr) const;
+    TokenString generateToken(OTPGenErrorCode *error = nullptr) const;
 
     /**
      * calculates the remaining token validity from the current system time
@@ -237,7 +243,7 @@ public:
         return (
             this->_type == other._type &&
             this->_label == other._label &&
-            this->_icon == other._icon &&
+            this->iconEquals(other) &&
             this->_secret == other._secret &&
             this->_digits == other._digits &&
             this->_period == other._period &&
@@ -258,7 +264,7 @@ private:
 
     TokenType _type = 0U;
     Label _label;
-    Icon _icon;
+    std::shared_ptr<const Icon> _icon; // nullptr when empty
     TokenSecret _secret;
     DigitType _digits = 0U;
     PeriodType _period = 0U;
@@ -267,6 +273,8 @@ private:
 
     sqliteTokenID _id = 0U;
 
+    bool iconEquals(const OTPToken &other) const;
+
     static bool validateSecret(const TokenSecret &secret, OTPGenErrorCode *error);
 };
 
@@ -0,0 +1,208 @@
+#include "Profiler.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+
+namespace {
+    static std::atomic<bool> profiling_enabled{false};
+
+    static std::mutex phases_mutex;
+    static Profiler::Phases recorded_phases;
+    static Profiler::Clock::time_point origin = Profiler::Clock::now();
+    static std::uint32_t thread_count = 0;
+
+    // per-thread nesting level and sequential thread number
+    static thread_local std::uint32_t current_depth = 0;
+    static thread_local std::uint32_t thread_number = UINT32_MAX;
+
+    static std::uint64_t microseconds(const Profiler::Clock::duration &duration)
+    {
+        const auto us = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+        return us < 0 ? 0 : static_cast<std::uint64_t>(us);
+    }
+
+    static void escapeJson(const std::string &in, std::string &out)
+    {
+        for (auto&& c : in)
+        {
+            if (c == '"' || c == '\\')
+            {
+                out.push_back('\\');
+                out.push_back(c);
+            }
+            else if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char buffer[8];
+                std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned>(c));
+                out.append(buffer);
+            }
+            else
+            {
+                out.push_back(c);
+            }
+        }
+    }
+}
+
+void Profiler::setEnabled(const bool &enabled)
+{
+    std::lock_guard<std::mutex> lock(phases_mutex);
+    if (enabled)
+    {
+        recorded_phases.clear();
+        origin = Clock::now();
+    }
+    profiling_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool Profiler::enabled()
+{
+    return profiling_enabled.load(std::memory_order_relaxed);
+}
+
+void Profiler::clear()
+{
+    std::lock_guard<std::mutex> lock(phases_mutex);
+    recorded_phases.clear();
+}
+
+Profiler::Phases Profiler::phases()
+{
+    Phases phases;
+    {
+        std::lock_guard<std::mutex> lock(phases_mutex);
+        phases = recorded_phases;
+    }
+
+    // phases are recorded when they end, nested phases end before their parent
+    std::stable_sort(phases.begin(), phases.end(), [](const Phase &a, const Phase &b) {
+        return a.start != b.start ? a.start < b.start : a.depth < b.depth;
+    });
+    return phases;
+}
+
+std::string Profiler::report()
+{
+    const auto list = phases();
+
+    std::string out = "Startup profile:\n";
+    if (list.empty())
+    {
+        out += "  (no phases recorded)\n";
+        return out;
+    }
+
+    char line[160];
+    for (auto&& phase : list)
+    {
+        const auto indent = static_cast<int>(2 + phase.depth * 2);
+        const auto width = std::max(1, 34 - indent);
+        const auto ms = static_cast<double>(phase.duration) / 1000.0;
+
+        if (phase.bytes != 0)
+        {
+            std::snprintf(line, sizeof(line), "%*s%-*s %10.3f ms %12.1f KiB\n",
+                          indent, "", width, phase.name.c_str(), ms, static_cast<double>(phase.bytes) / 1024.0);
+        }
+        else
+        {
+            std::snprintf(line, sizeof(line), "%*s%-*s %10.3f ms\n",
+                          indent, "", width, phase.name.c_str(), ms);
+        }
+        out += line;
+    }
+
+    return out;
+}
+
+bool Profiler::writeChromeTrace(const std::string &file)
+{
+    const auto list = phases();
+
+    // complete events ("X"), timestamps and durations in microseconds
+    std::string out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    for (std::size_t i = 0; i < list.size(); ++i)
+    {
+        const auto &phase = list[i];
+        if (i != 0)
+        {
+            out.push_back(',');
+        }
+        out += "\n{\"name\":\"";
+        escapeJson(phase.name, out);
+        out += "\",\"cat\":\"startup\",\"ph\":\"X\",\"pid\":1,\"tid\":";
+        out += std::to_string(phase.thread + 1);
+        out += ",\"ts\":";
+        out += std::to_string(phase.start);
+        out += ",\"dur\":";
+        out += std::to_string(phase.duration);
+        if (phase.bytes != 0)
+        {
+            out += ",\"args\":{\"bytes\":";
+            out += std::to_string(phase.bytes);
+            out += "}";
+        }
+        out += "}";
+    }
+    out += "\n]}\n";
+
+    std::ofstream stream(file, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+    return static_cast<bool>(stream.write(out.data(), static_cast<std::streamsize>(out.size())));
+}
+
+Profiler::Scope::Scope(const char *name, const bool &firstOnly)
+    : _name(name),
+      _active(Profiler::enabled()),
+      _firstOnly(firstOnly)
+{
+    if (this->_active)
+    {
+        ++current_depth;
+        this->_start = Clock::now();
+    }
+}
+
+Profiler::Scope::~Scope()
+{
+    if (this->_active)
+    {
+        const auto end = Clock::now();
+        --current_depth;
+        Profiler::record(this->_name, this->_start, end, this->_bytes, this->_firstOnly);
+    }
+}
+
+void Profiler::record(const char *name, const Clock::time_point &start, const Clock::time_point &end,
+                      const std::uint64_t &bytes, const bool &firstOnly)
+{
+    std::lock_guard<std::mutex> lock(phases_mutex);
+
+    // profiling was disabled while the scope was open
+    if (!profiling_enabled.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    if (firstOnly && std::any_of(recorded_phases.begin(), recorded_phases.end(), [&](const Phase &phase) {
+        return phase.name == name;
+    })) {
+        return;
+    }
+
+    if (thread_number == UINT32_MAX)
+    {
+        thread_number = thread_count++;
+    }
+
+    Phase phase;
+    phase.name = name;
+    phase.start = start < origin ? 0 : microseconds(start - origin);
+    phase.duration = microseconds(end - start);
+    phase.bytes = bytes;
+    phase.thread = thread_number;
+    phase.depth = current_depth;
+    recorded_phases.emplace_back(std::move(phase));
+}
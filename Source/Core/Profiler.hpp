@@ -0,0 +1,80 @@
+#ifndef PROFILER_HPP
+#define PROFILER_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Lightweight phase profiler for the startup path.
+ *
+ * Phases are recorded with scoped timers, which are a single relaxed atomic
+ * load when profiling is disabled. Recorded phases can be printed as a
+ * breakdown or written as a Chrome trace (chrome://tracing, Perfetto,
+ * speedscope) for flame views.
+ *
+ * Usage:
+ *   Profiler::Scope scope("readFile");
+ *   ...
+ *   scope.setBytes(buffer.size());
+ */
+class Profiler final
+{
+    Profiler() = delete;
+
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Phase {
+        std::string name;
+        std::uint64_t start = 0;    // microseconds since profiling was enabled
+        std::uint64_t duration = 0; // microseconds
+        std::uint64_t bytes = 0;    // processed bytes, 0 when not applicable
+        std::uint32_t thread = 0;   // sequential thread number, 0 is the first recording thread
+        std::uint32_t depth = 0;    // nesting level on the recording thread
+    };
+    using Phases = std::vector<Phase>;
+
+    // enabling resets the recorded phases and the time origin
+    static void setEnabled(const bool &enabled);
+    static bool enabled();
+    static void clear();
+
+    // recorded phases, ordered by start time
+    static Phases phases();
+
+    // human-readable breakdown of the recorded phases
+    static std::string report();
+
+    // writes the recorded phases in the Chrome trace event format
+    static bool writeChromeTrace(const std::string &file);
+
+    class Scope final
+    {
+    public:
+        // firstOnly: only the first completed occurrence of the phase is recorded,
+        // used for phases which are only interesting when they are cold
+        Scope(const char *name, const bool &firstOnly = false);
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator= (const Scope &) = delete;
+
+        inline void setBytes(const std::uint64_t &bytes)
+        { this->_bytes = bytes; }
+
+    private:
+        const char *_name;
+        Clock::time_point _start;
+        std::uint64_t _bytes = 0;
+        bool _active;
+        bool _firstOnly;
+    };
+
+private:
+    static void record(const char *name, const Clock::time_point &start, const Clock::time_point &end,
+                       const std::uint64_t &bytes, const bool &firstOnly);
+};
+
+#endif // PROFILER_HPP
@@ -0,0 +1,235 @@
+#include "SecureAllocator.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#if defined(OS_WINDOWS)
+#include <windows.h>
+#define SECUREARENA_HAS_VIRTUALLOCK
+#elif !defined(OS_WASM)
+#include <sys/mman.h>
+#include <unistd.h>
+#define SECUREARENA_HAS_MLOCK
+#endif
+
+const std::size_t SecureArena::SlabSize = 64U * 1024U;
+
+namespace {
+    // size classes 16, 32, ..., 4096 bytes, larger allocations are mapped separately
+    static const std::size_t MIN_CLASS_SHIFT = 4U;
+    static const std::size_t CLASS_COUNT = 9U;
+    static const std::size_t MAX_CLASS_SIZE = std::size_t(1) << (MIN_CLASS_SHIFT + CLASS_COUNT - 1);
+
+    struct FreeBlock {
+        FreeBlock *next;
+    };
+
+    static std::mutex arena_mutex;
+    static FreeBlock *free_lists[CLASS_COUNT] = {};
+
+    // bump allocation in the current slab
+    static char *slab_cursor = nullptr;
+    static std::size_t slab_left = 0;
+
+    static SecureArena::Statistics stats;
+
+    static std::size_t class_of(const std::size_t &size)
+    {
+        std::size_t index = 0;
+        while ((std::size_t(1) << (MIN_CLASS_SHIFT + index)) < size)
+        {
+            ++index;
+        }
+        return index;
+    }
+
+    static std::size_t page_rounded(const std::size_t &size)
+    {
+        static const std::size_t page = [] {
+#if defined(SECUREARENA_HAS_MLOCK)
+            const auto res = ::sysconf(_SC_PAGESIZE);
+            return res > 0 ? static_cast<std::size_t>(res) : std::size_t(4096);
+#elif defined(SECUREARENA_HAS_VIRTUALLOCK)
+            SYSTEM_INFO info;
+            ::GetSystemInfo(&info);
+            return static_cast<std::size_t>(info.dwPageSize);
+#else
+            return std::size_t(4096);
+#endif
+        }();
+        return (size + page - 1) / page * page;
+    }
+
+    // maps and locks zeroed memory, size must be page rounded;
+    // locked is cleared when the memory couldn't be locked, the caller
+    // records it in the statistics under the arena mutex
+    static void *map_locked(const std::size_t &size, bool &locked)
+    {
+        locked = true;
+#if defined(SECUREARENA_HAS_MLOCK)
+        auto ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (ptr == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        if (::mlock(ptr, size) != 0)
+        {
+            locked = false;
+        }
+#if defined(MADV_DONTDUMP)
+        // keep secrets out of core dumps
+        ::madvise(ptr, size, MADV_DONTDUMP);
+#endif
+        return ptr;
+#elif defined(SECUREARENA_HAS_VIRTUALLOCK)
+        auto ptr = ::VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        if (!ptr)
+        {
+            return nullptr;
+        }
+        if (!::VirtualLock(ptr, size))
+        {
+            locked = false;
+        }
+        return ptr;
+#else
+        locked = false;
+        return std::calloc(1, size);
+#endif
+    }
+
+    static void unmap_locked(void *ptr, const std::size_t &size)
+    {
+#if defined(SECUREARENA_HAS_MLOCK)
+        ::munlock(ptr, size);
+        ::munmap(ptr, size);
+#elif defined(SECUREARENA_HAS_VIRTUALLOCK)
+        ::VirtualUnlock(ptr, size);
+        ::VirtualFree(ptr, 0, MEM_RELEASE);
+#else
+        (void) size;
+        std::free(ptr);
+#endif
+    }
+}
+
+void *SecureArena::allocate(const std::size_t &size)
+{
+    const auto bytes = size == 0 ? std::size_t(1) : size;
+
+    // large buffers (decrypted databases) get their own mapping
+    if (bytes > MAX_CLASS_SIZE)
+    {
+        const auto mapped = page_rounded(bytes);
+        auto locked = true;
+        auto ptr = map_locked(mapped, locked);
+        if (!ptr)
+        {
+            throw std::bad_alloc();
+        }
+
+        std::lock_guard<std::mutex> lock(arena_mutex);
+        stats.locked = stats.locked && locked;
+        stats.capacity += mapped;
+        stats.used += mapped;
+        return ptr;
+    }
+
+    const auto index = class_of(bytes);
+    const auto block_size = std::size_t(1) << (MIN_CLASS_SHIFT + index);
+
+    std::lock_guard<std::mutex> lock(arena_mutex);
+
+    if (free_lists[index])
+    {
+        auto block = free_lists[index];
+        free_lists[index] = block->next;
+        block->next = nullptr;
+        stats.used += block_size;
+        return block;
+    }
+
+    if (slab_left < block_size)
+    {
+        // the rest of the current slab is split into smaller blocks
+        for (auto i = index; i-- > 0;)
+        {
+            const auto size_i = std::size_t(1) << (MIN_CLASS_SHIFT + i);
+            if (slab_left >= size_i)
+            {
+                auto block = reinterpret_cast<FreeBlock*>(slab_cursor);
+                block->next = free_lists[i];
+                free_lists[i] = block;
+                slab_cursor += size_i;
+                slab_left -= size_i;
+            }
+        }
+
+        auto locked = true;
+        auto slab = static_cast<char*>(map_locked(SlabSize, locked));
+        if (!slab)
+        {
+            throw std::bad_alloc();
+        }
+        stats.locked = stats.locked && locked;
+        slab_cursor = slab;
+        slab_left = SlabSize;
+        ++stats.slabs;
+        stats.capacity += SlabSize;
+    }
+
+    auto ptr = slab_cursor;
+    slab_cursor += block_size;
+    slab_left -= block_size;
+    stats.used += block_size;
+    return ptr;
+}
+
+void SecureArena::deallocate(void *ptr, const std::size_t &size) noexcept
+{
+    if (!ptr)
+    {
+        return;
+    }
+
+    const auto bytes = size == 0 ? std::size_t(1) : size;
+
+    if (bytes > MAX_CLASS_SIZE)
+    {
+        const auto mapped = page_rounded(bytes);
+        wipe(ptr, mapped);
+        unmap_locked(ptr, mapped);
+
+        std::lock_guard<std::mutex> lock(arena_mutex);
+        stats.capacity -= mapped;
+        stats.used -= mapped;
+        return;
+    }
+
+    const auto index = class_of(bytes);
+    const auto block_size = std::size_t(1) << (MIN_CLASS_SHIFT + index);
+    wipe(ptr, block_size);
+
+    std::lock_guard<std::mutex> lock(arena_mutex);
+    auto block = static_cast<FreeBlock*>(ptr);
+    block->next = free_lists[index];
+    free_lists[index] = block;
+    stats.used -= block_size;
+}
+
+void SecureArena::wipe(void *ptr, const std::size_t &size) noexcept
+{
+    // writes through a volatile pointer can't be elided
+    auto p = static_cast<volatile unsigned char*>(ptr);
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        p[i] = 0U;
+    }
+}
+
+SecureArena::Statistics SecureArena::statistics()
+{
+    std::lock_guard<std::mutex> lock(arena_mutex);
+    return stats;
+}
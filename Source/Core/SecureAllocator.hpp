@@ -0,0 +1,97 @@
+#ifndef SECUREALLOCATOR_HPP
+#define SECUREALLOCATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Locked memory arena for secrets, keys and decrypted buffers.
+ *
+ * Small allocations are carved from slabs which are locked into memory
+ * (mlock/VirtualLock) when they are mapped, so they never end up in the
+ * swap file. Freed blocks are zeroed and reused through per-size free lists.
+ * Allocations larger than the biggest size class get their own locked
+ * mapping, which is zeroed and unmapped on free.
+ *
+ * Locking is best effort: when the memory lock limit (RLIMIT_MEMLOCK) is
+ * exceeded, the memory is still used and zeroed on free, but may be
+ * swapped; see statistics().
+ *
+ * Note: short strings are stored inside the std::basic_string object itself
+ * (small string optimization) and don't reach the allocator.
+ */
+class SecureArena final
+{
+    SecureArena() = delete;
+
+public:
+    static void *allocate(const std::size_t &size);
+    static void deallocate(void *ptr, const std::size_t &size) noexcept;
+
+    // zero memory, not optimized away by the compiler
+    static void wipe(void *ptr, const std::size_t &size) noexcept;
+
+    struct Statistics {
+        std::size_t slabs = 0;     // number of slabs
+        std::size_t capacity = 0;  // bytes mapped for slabs and large allocations
+        std::size_t used = 0;      // bytes handed out
+        bool locked = true;        // all mappings are locked into memory
+    };
+    static Statistics statistics();
+
+    // size of a slab, the first slab is mapped and locked on the first allocation
+    static const std::size_t SlabSize;
+};
+
+template<typename T>
+class SecureAllocator
+{
+public:
+    using value_type = T;
+
+    SecureAllocator() noexcept = default;
+    template<typename U>
+    SecureAllocator(const SecureAllocator<U> &) noexcept
+    {}
+
+    T *allocate(const std::size_t n)
+    {
+        if (n > static_cast<std::size_t>(-1) / sizeof(T))
+        {
+            throw std::bad_array_new_length();
+        }
+        return static_cast<T*>(SecureArena::allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *ptr, const std::size_t n) noexcept
+    {
+        SecureArena::deallocate(ptr, n * sizeof(T));
+    }
+
+    // the arena is global, memory can be freed by any instance
+    template<typename U>
+    inline bool operator== (const SecureAllocator<U> &) const noexcept
+    { return true; }
+    template<typename U>
+    inline bool operator!= (const SecureAllocator<U> &) const noexcept
+    { return false; }
+};
+
+using SecureString = std::basic_string<char, std::char_traits<char>, SecureAllocator<char>>;
+using SecureBuffer = std::vector<std::uint8_t, SecureAllocator<std::uint8_t>>;
+
+// comparison with regular strings, found through the allocator (ADL)
+inline bool operator== (const SecureString &a, const std::string &b)
+{ return std::string_view(a) == std::string_view(b); }
+inline bool operator== (const std::string &a, const SecureString &b)
+{ return std::string_view(a) == std::string_view(b); }
+inline bool operator!= (const SecureString &a, const std::string &b)
+{ return !(a == b); }
+inline bool operator!= (const std::string &a, const SecureString &b)
+{ return !(a == b); }
+
+#endif // SECUREALLOCATOR_HPP
@@ -0,0 +1,136 @@
+#include "TokenCatalog.hpp"
+
+#include <mutex>
+
+const TokenCatalog::StaticValueList &TokenCatalog::defaultTypes()
+{
+    static const StaticValueList values = {
+        {OTPToken::TOTP,  "TOTP"},
+        {OTPToken::HOTP,  "HOTP"},
+        {OTPToken::Steam, "Steam"},
+    };
+    return values;
+}
+
+const TokenCatalog::StaticValueList &TokenCatalog::defaultAlgorithms()
+{
+    static const StaticValueList values = {
+        {OTPToken::SHA1,   "SHA1"},
+        {OTPToken::SHA256, "SHA256"},
+        {OTPToken::SHA512, "SHA512"},
+    };
+    return values;
+}
+
+std::string TokenCatalog::typeName(const OTPToken::sqliteTypesID &id)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex());
+    return std::string(types().name(id));
+}
+
+std::string TokenCatalog::algorithmName(const OTPToken::sqliteAlgorithmsID &id)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex());
+    return std::string(algorithms().name(id));
+}
+
+OTPToken::sqliteTypesID TokenCatalog::typeId(const std::string_view &name)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex());
+    return types().id(name);
+}
+
+OTPToken::sqliteAlgorithmsID TokenCatalog::algorithmId(const std::string_view &name)
+{
+    std::shared_lock<std::shared_mutex> lock(mutex());
+    return algorithms().id(name);
+}
+
+TokenCatalog::Table &TokenCatalog::types()
+{
+    static Table table = []{
+        Table t;
+        t.assign(defaultTypes());
+        return t;
+    }();
+    return table;
+}
+
+TokenCatalog::Table &TokenCatalog::algorithms()
+{
+    static Table table = []{
+        Table t;
+        t.assign(defaultAlgorithms());
+        return t;
+    }();
+    return table;
+}
+
+std::shared_mutex &TokenCatalog::mutex()
+{
+    static std::shared_mutex mutex;
+    return mutex;
+}
+
+void TokenCatalog::assign(const StaticValueList &types, const StaticValueList &algorithms)
+{
+    std::unique_lock<std::shared_mutex> lock(mutex());
+    TokenCatalog::types().assign(types);
+    TokenCatalog::algorithms().assign(algorithms);
+}
+
+void TokenCatalog::reset()
+{
+    assign(defaultTypes(), defaultAlgorithms());
+}
+
+void TokenCatalog::Table::assign(const StaticValueList &values)
+{
+    ids.clear();
+    names.clear();
+
+    for (auto&& v : values)
+    {
+        // negative ids are never used by the schema
+        if (v.id < 0)
+        {
+            continue;
+        }
+
+        const auto index = static_cast<std::size_t>(v.id);
+        if (index >= names.size())
+        {
+            names.resize(index + 1);
+        }
+        names[index] = v.name;
+    }
+
+    // build the reverse map only after all strings are in place,
+    // growing the vector would invalidate the views
+    for (auto i = 0U; i < names.size(); ++i)
+    {
+        if (!names[i].empty())
+        {
+            ids.emplace(names[i], static_cast<OTPToken::sqliteShortID>(i));
+        }
+    }
+}
+
+std::string_view TokenCatalog::Table::name(const OTPToken::sqliteShortID &id) const
+{
+    if (id < 0 || static_cast<std::size_t>(id) >= names.size())
+    {
+        return {};
+    }
+    return names[static_cast<std::size_t>(id)];
+}
+
+OTPToken::sqliteShortID TokenCatalog::Table::id(const std::string_view &name) const
+{
+    const auto it = ids.find(name);
+    if (it == ids.end())
+    {
+        return 0;
+    }
+    return it->second;
+}
@@ -0,0 +1,76 @@
+#ifndef TOKENCATALOG_HPP
+#define TOKENCATALOG_HPP
+
+#include "OTPToken.hpp"
+
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+
+/**
+ * In-memory catalog of the static "types" and "algorithms" tables.
+ *
+ * Lookups don't touch the database, the catalog is filled once by the
+ * TokenDatabase when a database is opened and only refreshed after schema
+ * changes. When no database is connected the compile-time defaults are used.
+ *
+ * The catalog may be reloaded on another thread (the database loader), names
+ * are returned by value and all access is guarded by a shared mutex. The names
+ * are short enough for the small string buffer, copying them doesn't allocate.
+ */
+class TokenCatalog final
+{
+    TokenCatalog() = delete;
+
+    // for assign() and reset()
+    friend class TokenDatabase;
+
+public:
+    struct StaticValue {
+        OTPToken::sqliteShortID id;
+        std::string name;
+    };
+    using StaticValueList = std::vector<StaticValue>;
+
+    // built-in values, used to bootstrap new databases
+    static const StaticValueList &defaultTypes();
+    static const StaticValueList &defaultAlgorithms();
+
+    // id -> name, empty string when the id is unknown
+    static std::string typeName(const OTPToken::sqliteTypesID &id);
+    static std::string algorithmName(const OTPToken::sqliteAlgorithmsID &id);
+
+    // name -> id, None/Invalid (0) when the name is unknown
+    static OTPToken::sqliteTypesID typeId(const std::string_view &name);
+    static OTPToken::sqliteAlgorithmsID algorithmId(const std::string_view &name);
+
+private:
+    class Table
+    {
+    public:
+        void assign(const StaticValueList &values);
+
+        std::string_view name(const OTPToken::sqliteShortID &id) const;
+        OTPToken::sqliteShortID id(const std::string_view &name) const;
+
+    private:
+        // indexed by id, gaps are empty strings
+        std::vector<std::string> names;
+        // views into names
+        std::unordered_map<std::string_view, OTPToken::sqliteShortID> ids;
+    };
+
+    static Table &types();
+    static Table &algorithms();
+    static std::shared_mutex &mutex();
+
+    // replace the catalog with values read from the database
+    static void assign(const StaticValueList &types, const StaticValueList &algorithms);
+
+    // restore the compile-time defaults
+    static void reset();
+};
+
+#endif // TOKENCATALOG_HPP
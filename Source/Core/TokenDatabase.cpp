@@ -1,9 +1,17 @@
 #include "TokenDatabase.hpp"
 
+#include "Profiler.hpp"
+#include "Internal/SchemaMigration.hpp"
+#include "Internal/StatementProfiler.hpp"
+
+#include <algorithm>
 #include <fstream>
 #include <ostream>
 #include <sstream>
 #include <memory>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
 
 #include <sqlite/sqlite3.h>
 #include <sqlite_modern_cpp.h>
@@ -13,6 +21,7 @@
 #include <cryptopp/aes.h>
 #include <cryptopp/sha.h>
 #include <cryptopp/base64.h>
+#include <cryptopp/hex.h>
 #include <cryptopp/hkdf.h>
 #include <cryptopp/modes.h>
 #include <cryptopp/filters.h>
@@ -22,13 +31,74 @@
 #include <cereal/archives/portable_binary.hpp>
 
 namespace {
-    // database version, used for possible migrations
-    static const std::uint32_t DATABASE_VERSION = 0x0f000005;
+    // format of exported keys: <tag><version>:<fingerprint>:<hex encoded AES key and IV>,
+    // version 1 stored the hashed password and is rejected by importKey()
+    static const std::string EXPORTED_KEY_TAG = "otpgen-key:";
+    static const std::string EXPORTED_KEY_PREFIX = EXPORTED_KEY_TAG + "2:";
+
+    // AES key followed by the CBC IV
+    static const std::size_t DATABASE_KEY_SIZE = CryptoPP::AES::DEFAULT_KEYLENGTH + CryptoPP::AES::BLOCKSIZE;
+
+    // database version, used for migrations
+    static const std::uint32_t DATABASE_VERSION = SchemaMigration::CurrentVersion;
 
     // SQLite3 connection handle
     static std::shared_ptr<sqlite::database> db;
     static bool db_status;
-    static std::string db_data;
+
+    // sql statement profiling, see OTPGEN_SQL_PROFILE
+    static const char *sql_profile_env = std::getenv("OTPGEN_SQL_PROFILE");
+    static bool sql_profiling = sql_profile_env && sql_profile_env[0] != '\0' && std::strcmp(sql_profile_env, "0") != 0;
+
+    // sqlite_modern_cpp only binds and reads std::string, secrets pass through
+    // a temporary std::string which is wiped as soon as sqlite copied it
+    class BoundSecret final
+    {
+    public:
+        BoundSecret(const OTPToken::TokenSecret &secret)
+            : value(secret.begin(), secret.end())
+        {}
+        ~BoundSecret()
+        { SecureArena::wipe(&value[0], value.size()); }
+
+        std::string value;
+    };
+
+    static void wipe(std::string &column)
+    {
+        SecureArena::wipe(&column[0], column.size());
+    }
+
+    // restricts the display order to the given sorted ids, drops duplicates
+    // and appends the ids missing from the order in insertion order
+    static void mergeDisplayOrder(std::vector<OTPToken::sqliteSortOrder> &order, const std::vector<OTPToken::sqliteTokenID> &ids)
+    {
+        // seen[i] is set when ids[i] is in the order
+        std::vector<bool> seen(ids.size(), false);
+
+        order.erase(std::remove_if(order.begin(), order.end(), [&](const OTPToken::sqliteSortOrder &id) {
+            const auto it = std::lower_bound(ids.cbegin(), ids.cend(), id);
+            if (it == ids.cend() || *it != id)
+            {
+                return true;
+            }
+            const auto index = static_cast<std::size_t>(it - ids.cbegin());
+            if (seen[index])
+            {
+                return true;
+            }
+            seen[index] = true;
+            return false;
+        }), order.end());
+
+        for (std::size_t i = 0; i < ids.size(); ++i)
+        {
+            if (!seen[i])
+            {
+                order.emplace_back(ids[i]);
+            }
+        }
+    }
 }
 
 template<typename T, class L = std::vector<T>>
@@ -53,10 +123,10 @@ static void moveRange(POSITION start, LENGTH length, POSITION dst, LIST &list)
     list.insert(list.begin() + final_dst, tmp.begin(), tmp.end());
 }
 
-std::string TokenDatabase::databasePassword;
+SecureBuffer TokenDatabase::databaseKey;
 std::string TokenDatabase::databasePath;
 
-const std::string TokenDatabase::getErrorMessage(const Error &error)
+std::string TokenDatabase::getErrorMessage(const Error &error)
 {
     switch (error)
     {
@@ -91,6 +161,10 @@ const std::string TokenDatabase::getErrorMessage(const Error &error)
         case SqlSchemaValidationFailed:    return "Database schema is invalid / was user-modified.";
 
         case UnknownFailure: return "An unknown error occurred!";
+
+        case SqlUnsupportedVersion:        return "Database was created by a newer version of this application.";
+        case SqlMigrationFailed:           return "Failed to upgrade the database to the current version.";
+        case InvalidKey:                   return "The stored key doesn't belong to this token database.";
     }
 
     return {};
@@ -112,6 +186,10 @@ TokenDatabase::Error TokenDatabase::initDatabase()
     try {
         db = std::make_shared<sqlite::database>(":memory:");
         db_status = true;
+        if (sql_profiling)
+        {
+            StatementProfiler::attach(db->connection().get());
+        }
     } catch (sqlite::sqlite_exception &) {
         db_status = false;
         return SqlMemoryAllocationError;
@@ -124,12 +202,63 @@ void TokenDatabase::closeDatabase()
 {
     if (db_status)
     {
+        if (sql_profiling)
+        {
+            const auto report = statementProfile();
+            StatementProfiler::detach(db->connection().get());
+            StatementProfiler::reset();
+
+            if (!sql_profile_env || std::strcmp(sql_profile_env, "1") == 0)
+            {
+                std::fputs(report.c_str(), stderr);
+            }
+            else
+            {
+                std::ofstream(sql_profile_env, std::ios_base::out | std::ios_base::app) << report << std::endl;
+            }
+        }
+
         // force close database
         (void) sqlite3_close_v2(db->connection().get());
         db = nullptr;
         db_status = false;
-        db_data.clear();
     }
+
+    // fallback to the built-in names
+    TokenCatalog::reset();
+}
+
+void TokenDatabase::setStatementProfiling(const bool &enabled)
+{
+    // start with empty statistics
+    if (enabled && !sql_profiling)
+    {
+        StatementProfiler::reset();
+    }
+
+    if (db_status && enabled != sql_profiling)
+    {
+        if (enabled)
+        {
+            StatementProfiler::attach(db->connection().get());
+        }
+        else
+        {
+            StatementProfiler::detach(db->connection().get());
+        }
+    }
+
+    sql_profiling = enabled;
+}
+
+bool TokenDatabase::statementProfiling()
+{
+    return sql_profiling;
+}
+
+std::string TokenDatabase::statementProfile()
+{
+    return StatementProfiler::report(db_status ? db->connection().get() : nullptr);
 }
 
 bool TokenDatabase::setPassword(const std::string &password)
@@ -137,19 +266,100 @@ bool TokenDatabase::setPassword(const std::string &password)
     if (password.empty())
         return false;
 
-    // remove old password
-    TokenDatabase::databasePassword.clear();
-
     // don't use smart pointers here, already managed/deleted by crypto++ itself
+    SecureString hashed;
     CryptoPP::SHA256 hash;
     CryptoPP::StringSource src(password, true,
         new CryptoPP::HashFilter(hash,
             new CryptoPP::Base64Encoder(
-                new CryptoPP::StringSink(TokenDatabase::databasePassword))));
+                new CryptoPP::StringSinkTemplate<SecureString>(hashed))));
 
+    TokenDatabase::databaseKey = deriveKey(hashed);
     return true;
 }
 
+SecureString TokenDatabase::exportKey()
+{
+    std::string fingerprint;
+    if (databaseKey.empty() || keyFingerprint(fingerprint) != Success)
+    {
+        return {};
+    }
+
+    SecureString key(EXPORTED_KEY_PREFIX.begin(), EXPORTED_KEY_PREFIX.end());
+    key.append(fingerprint.begin(), fingerprint.end());
+    key.push_back(':');
+    CryptoPP::ArraySource src(databaseKey.data(), databaseKey.size(), true,
+        new CryptoPP::HexEncoder(new CryptoPP::StringSinkTemplate<SecureString>(key), false));
+    return key;
+}
+
+TokenDatabase::Error TokenDatabase::importKey(const std::string_view &key)
+{
+    if (key.substr(0, EXPORTED_KEY_PREFIX.size()) != EXPORTED_KEY_PREFIX)
+    {
+        return InvalidKey;
+    }
+
+    const auto data = key.substr(EXPORTED_KEY_PREFIX.size());
+    const auto separator = data.find(':');
+    if (separator == std::string_view::npos || separator + 1 == data.size())
+    {
+        return InvalidKey;
+    }
+
+    // the key is only valid for the file it was exported from,
+    // changing the password changes the fingerprint too
+    std::string fingerprint;
+    auto status = keyFingerprint(fingerprint);
+    if (status != Success)
+    {
+        return status;
+    }
+    if (data.substr(0, separator) != fingerprint)
+    {
+        return InvalidKey;
+    }
+
+    const auto encoded = data.substr(separator + 1);
+    SecureBuffer derived(encoded.size() / 2);
+    CryptoPP::HexDecoder decoder;
+    decoder.Put(reinterpret_cast<const unsigned char*>(encoded.data()), encoded.size());
+    decoder.MessageEnd();
+    if (encoded.size() != DATABASE_KEY_SIZE * 2 || decoder.MaxRetrievable() != DATABASE_KEY_SIZE)
+    {
+        return InvalidKey;
+    }
+    decoder.Get(derived.data(), derived.size());
+
+    databaseKey = std::move(derived);
+    return Success;
+}
+
+bool TokenDatabase::isExportedKey(const std::string_view &data)
+{
+    // any version, outdated keys must not be taken for passwords
+    return data.substr(0, EXPORTED_KEY_TAG.size()) == EXPORTED_KEY_TAG;
+}
+
+TokenDatabase::Error TokenDatabase::keyFingerprint(std::string &out)
+{
+    out.clear();
+
+    // the plaintext always starts with the sqlite header and the IV is fixed,
+    // so the first cipher block only depends on the key
+    char block[CryptoPP::AES::BLOCKSIZE];
+    std::ifstream stream(databasePath, std::ios_base::in | std::ios_base::binary);
+    if (!stream.read(block, sizeof(block)))
+    {
+        return FileReadFailure;
+    }
+
+    CryptoPP::StringSource src(reinterpret_cast<const unsigned char*>(block), sizeof(block), true,
+        new CryptoPP::HexEncoder(new CryptoPP::StringSink(out), false));
+    return Success;
+}
+
 bool TokenDatabase::setTokenDatabase(const std::string &file)
 {
     if (file.empty())
@@ -161,6 +371,11 @@ bool TokenDatabase::setTokenDatabase(const std::string &file)
     return true;
 }
 
+const std::string &TokenDatabase::tokenDatabase()
+{
+    return databasePath;
+}
+
 TokenDatabase::Error TokenDatabase::changePassword(const std::string &newPassword)
 {
     Error status = Success;
@@ -183,7 +398,7 @@ TokenDatabase::Error TokenDatabase::changePassword(const std::string &newPasswor
 namespace {
     // sanitize SQL query and return it as a managed std::string, C pointer from sqlite3_mprintf() is deleted
     template<class... Args>
-    static inline const std::string sanitizeQuery(const std::string &_template, Args&&... args)
+    static inline std::string sanitizeQuery(const std::string &_template, Args&&... args)
     {
         auto statement = sqlite3_mprintf(_template.c_str(), std::forward<Args>(args)...);
         std::string query(statement);
@@ -194,17 +409,16 @@ namespace {
 
 TokenDatabase::Error TokenDatabase::executeGenericTokenStatement(const std::string &statement, const OTPToken &token)
 {
-    // BLOB == std::vector<T> in this C++ SQL library
     // requires exactly 8 '?' placeholders
     try {
         (*db) << statement
               << token.type()
               << token.label()
-              << token.icon() // already a std::vector<>
-              << mangleTokenSecret(token.secret())
-              << std::vector<OTPToken::DigitType>{token.digitLength()}
-              << std::vector<OTPToken::PeriodType>{token.period()}
-              << std::vector<OTPToken::CounterType>{token.counter()}
+              << token.icon() // BLOB == std::vector<T> in this C++ SQL library
+              << BoundSecret(mangleTokenSecret(token.secret())).value
+              << token.digitLength()
+              << token.period()
+              << token.counter()
               << token.algorithm();
     } catch (sqlite::sqlite_exception &e) {
         if (e.get_code() == SQLITE_CONSTRAINT)
@@ -220,52 +434,105 @@ TokenDatabase::Error TokenDatabase::executeGenericTokenStatement(const std::stri
     return Success;
 }
 
-const OTPToken TokenDatabase::selectToken(const OTPToken::sqliteTokenID &id)
+// columns are read straight into the token, the statements must select
+// all columns of the tokens table in their declared order
+#define TOKEN_ROW_ARGLIST \
+    const OTPToken::sqliteLongID &id, \
+    const OTPToken::TokenType &type, \
+    OTPToken::Label label, \
+    OTPToken::Icon icon, \
+    std::string &&secret, \
+    const OTPToken::DigitType &digits, \
+    const OTPToken::PeriodType &period, \
+    const OTPToken::CounterType &counter, \
+    const OTPToken::ShaAlgorithm &algorithm
+
+#define TOKEN_ROW_ASSIGN(token) \
+    token._id = id; \
+    token._type = type; \
+    token._label = std::move(label); \
+    token.setIcon(std::move(icon)); \
+    token._secret = unmangleTokenSecret(secret); \
+    wipe(secret); \
+    token._digits = digits; \
+    token._period = period; \
+    token._counter = counter; \
+    token._algorithm = algorithm;
+
+bool TokenDatabase::selectTokenRows(const std::string &statement, OTPTokenList &tokens)
 {
-    if (!db_status)
-    {
-        return {};
+    try {
+        (*db) << statement >> [&](TOKEN_ROW_ARGLIST)
+        {
+            tokens.emplace_back();
+            auto &token = tokens.back();
+            TOKEN_ROW_ASSIGN(token)
+        };
+    } catch (sqlite::sqlite_exception &) {
+        return false;
     }
 
-    const auto statement = sanitizeQuery("select * from %Q where id = %u limit 1;", "tokens", id);
+    return true;
+}
 
+bool TokenDatabase::selectTokenRows(const std::string &statement, const TokenCallback &callback)
+{
+    // a single token object is reused for all rows
     OTPToken token;
 
-    // BLOB == std::vector<T> in this C++ SQL library
-    std::vector<OTPToken::DigitType> digits;
-    std::vector<OTPToken::PeriodType> period;
-    std::vector<OTPToken::CounterType> counter;
+    try {
+        (*db) << statement >> [&](TOKEN_ROW_ARGLIST)
+        {
+            TOKEN_ROW_ASSIGN(token)
+            callback(token);
+        };
+    } catch (sqlite::sqlite_exception &) {
+        return false;
+    }
+
+    return true;
+}
+
+TokenDatabase::Error TokenDatabase::selectTokenKeys(TokenKeyList &keys)
+{
+    if (!db_status)
+    {
+        return SqlDatabaseNotOpen;
+    }
 
     try {
-        (*db) << statement
-              >> [&](const OTPToken::sqliteLongID &id,
-                     const OTPToken::TokenType &type,
-                     const OTPToken::Label &label,
-                     const OTPToken::Icon &icon,
-                     const OTPToken::TokenSecret &secret,
-                     const std::vector<OTPToken::DigitType> &digits,
-                     const std::vector<OTPToken::PeriodType> &period,
-                     const std::vector<OTPToken::CounterType> &counter,
-                     const OTPToken::ShaAlgorithm &algorithm)
+        (*db) << "select label, secret from tokens;"
+              >> [&](OTPToken::Label label, std::string &&secret)
         {
-            token._id = id;
-            token.setType(type);
-            token.setLabel(label);
-            token.setIcon(icon);
-            token.setSecret(unmangleTokenSecret(secret));
-            token.setDigitLength(digits.empty() ? 0U : digits.at(0));
-            token.setPeriod(period.empty() ? 0U : period.at(0));
-            token.setCounter(counter.empty() ? 0U : counter.at(0));
-            token.setAlgorithm(algorithm);
+            keys.emplace_back(std::move(label), unmangleTokenSecret(secret));
+            wipe(secret);
         };
     } catch (sqlite::sqlite_exception &) {
+        return SqlExecutionFailed;
+    }
+
+    return Success;
+}
+
+OTPToken TokenDatabase::selectToken(const OTPToken::sqliteTokenID &id)
+{
+    if (!db_status)
+    {
         return {};
     }
 
-    return token;
+    const auto statement = sanitizeQuery("select * from %Q where id = %u limit 1;", "tokens", id);
+
+    OTPTokenList tokens;
+    if (!selectTokenRows(statement, tokens) || tokens.empty())
+    {
+        return {};
+    }
+
+    return std::move(tokens.front());
 }
 
-const OTPToken TokenDatabase::selectToken(const OTPToken::Label &label)
+OTPToken TokenDatabase::selectToken(const OTPToken::Label &label)
 {
     if (!db_status)
     {
@@ -280,60 +547,234 @@ const OTPToken TokenDatabase::selectToken(const OTPToken::Label &label)
         return {};
     }
 
-    return results.at(0);
+    return std::move(results.front());
 }
 
-const TokenDatabase::OTPTokenList TokenDatabase::selectTokens(const OTPToken::sqliteTypesID &type)
+TokenDatabase::OTPTokenList TokenDatabase::selectTokens(const OTPToken::sqliteTypesID &type)
 {
     if (!db_status)
     {
         return {};
     }
 
-    // prepare query
-    auto statement = sanitizeQuery("select id from %Q ", "tokens");
-    std::string order_by_query;
-    auto ret = displayOrderQuery(order_by_query);
+    // the first query after unlocking warms up the page cache
+    Profiler::Scope profile("selectTokens", true);
 
-    if (type != OTPToken::None)
+    OTPTokenList tokens;
+    if (!selectTokenRows(tokensQuery(type), tokens))
     {
-        statement += sanitizeQuery("where type = %u ", type);
+        return {};
     }
 
-    if (ret)
+    return tokens;
+}
+
+TokenDatabase::Error TokenDatabase::forEachToken(const TokenCallback &callback, const OTPToken::sqliteTypesID &type)
+{
+    if (!db_status)
     {
-        statement += order_by_query;
+        return SqlDatabaseNotOpen;
     }
-    else
+
+    DisplayOrder order;
+    if (getDisplayOrder(order) != Success || order.empty())
     {
-        statement += "order by id asc;";
+        if (!selectTokenRows(tokensQuery(type), callback))
+        {
+            return SqlExecutionFailed;
+        }
+        return Success;
+    }
+
+    const auto status = completeDisplayOrder(order);
+    if (status != Success)
+    {
+        return status;
     }
 
-    std::vector<OTPToken::sqliteLongID> ids;
+    return selectTokenRows(order.cbegin(), order.cend(), type, callback);
+}
+
+TokenDatabase::Error TokenDatabase::forEachToken(const TokenCallback &callback, const std::size_t &offset, const std::size_t &limit)
+{
+    if (!db_status)
+    {
+        return SqlDatabaseNotOpen;
+    }
 
-    // fetch all ids
+    DisplayOrder order;
+    if (getDisplayOrder(order) != Success || order.empty())
+    {
+        const auto statement = sanitizeQuery("select * from %Q order by id asc ", "tokens") +
+                               "limit " + std::to_string(limit) + " offset " + std::to_string(offset) + ";";
+        if (!selectTokenRows(statement, callback))
+        {
+            return SqlExecutionFailed;
+        }
+        return Success;
+    }
+
+    const auto status = completeDisplayOrder(order);
+    if (status != Success)
+    {
+        return status;
+    }
+
+    if (offset >= order.size())
+    {
+        return Success;
+    }
+
+    const auto first = order.cbegin() + static_cast<std::ptrdiff_t>(offset);
+    const auto count = std::min(limit, order.size() - offset);
+    return selectTokenRows(first, first + static_cast<std::ptrdiff_t>(count), OTPToken::None, callback);
+}
+
+TokenDatabase::Error TokenDatabase::forEachToken(const TokenCallback &callback, const DisplayOrder &ids)
+{
+    if (!db_status)
+    {
+        return SqlDatabaseNotOpen;
+    }
+
+    return selectTokenRows(ids.cbegin(), ids.cend(), OTPToken::None, callback);
+}
+
+TokenDatabase::Error TokenDatabase::selectTokenIds(DisplayOrder &ids, const std::string &label_contains)
+{
+    ids.clear();
+
+    if (!db_status)
+    {
+        return SqlDatabaseNotOpen;
+    }
+
+    // one scan over the labels, without decoding any token
+    std::vector<OTPToken::sqliteTokenID> matches;
     try {
-        (*db) << statement
-              >> [&](const OTPToken::sqliteLongID &id)
+        (*db) << sanitizeQuery("select id from %Q where label like ? escape '\\' order by id asc;", "tokens")
+              << "%" + escapeStringLIKE(label_contains) + "%"
+              >> [&](const OTPToken::sqliteTokenID &id)
+        {
+            matches.emplace_back(id);
+        };
+    } catch (sqlite::sqlite_exception &) {
+        return SqlExecutionFailed;
+    }
+
+    // a missing order lists the tokens in insertion order
+    if (getDisplayOrder(ids) != Success)
+    {
+        ids.clear();
+    }
+    mergeDisplayOrder(ids, matches);
+
+    return Success;
+}
+
+TokenDatabase::Error TokenDatabase::completeDisplayOrder(DisplayOrder &order)
+{
+    std::vector<OTPToken::sqliteTokenID> ids;
+    try {
+        (*db) << sanitizeQuery("select id from %Q order by id asc;", "tokens") >> [&](const OTPToken::sqliteTokenID &id)
         {
             ids.emplace_back(id);
         };
     } catch (sqlite::sqlite_exception &) {
-        return {};
+        return SqlExecutionFailed;
     }
 
-    // fetch all tokens
-    OTPTokenList tokens;
+    // ids of deleted tokens are dropped
+    mergeDisplayOrder(order, ids);
+    return Success;
+}
 
-    for (auto&& id : ids)
+TokenDatabase::Error TokenDatabase::selectTokenRows(DisplayOrder::const_iterator first, const DisplayOrder::const_iterator &last,
+                                                    const OTPToken::sqliteTypesID &type, const TokenCallback &callback)
+{
+    // walk the display order with primary key lookups, the "order by case"
+    // query of the list functions grows with the number of tokens
+    auto statement = sanitizeQuery("select * from %Q where id = ?", "tokens");
+    if (type != OTPToken::None)
     {
-        tokens.emplace_back(selectToken(id));
+        statement += sanitizeQuery(" and type = %u", type);
     }
+    statement += ";";
 
-    return tokens;
+    OTPToken token;
+
+    try {
+        auto select = (*db) << statement;
+        select.used(true); // don't execute on destruction
+
+        for (; first != last; ++first)
+        {
+            select << *first;
+            select >> [&](TOKEN_ROW_ARGLIST)
+            {
+                TOKEN_ROW_ASSIGN(token)
+                callback(token);
+            };
+        }
+    } catch (sqlite::sqlite_exception &) {
+        return SqlExecutionFailed;
+    }
+
+    return Success;
 }
 
-const TokenDatabase::OTPTokenList TokenDatabase::selectTokens(const OTPToken::Label &label_like)
+TokenDatabase::Error TokenDatabase::selectTokenTable(TokenTable &table, const OTPToken::sqliteTypesID &type)
+{
+    table.clear();
+
+    if (!db_status)
+    {
+        return SqlDatabaseNotOpen;
+    }
+
+    // size the arrays and the label arena up front
+    try {
+        (*db) << "select count(*), total(length(cast(label as blob))) from tokens;"
+              >> [&](const std::size_t &count, const double &labels)
+        {
+            table.reserve(count, static_cast<std::size_t>(labels));
+        };
+    } catch (sqlite::sqlite_exception &) {
+        return SqlExecutionFailed;
+    }
+
+    return forEachToken([&](const OTPToken &token) {
+        table.append(token);
+    }, type);
+}
+
+#undef TOKEN_ROW_ARGLIST
+#undef TOKEN_ROW_ASSIGN
+
+std::string TokenDatabase::tokensQuery(const OTPToken::sqliteTypesID &type)
+{
+    auto statement = sanitizeQuery("select * from %Q ", "tokens");
+    std::string order_by_query;
+    auto ret = displayOrderQuery(order_by_query);
+
+    if (type != OTPToken::None)
+    {
+        statement += sanitizeQuery("where type = %u ", type);
+    }
+
+    if (ret)
+    {
+        statement += order_by_query;
+    }
+    else
+    {
+        statement += "order by id asc;";
+    }
+
+    return statement;
+}
+
+TokenDatabase::OTPTokenList TokenDatabase::selectTokens(const OTPToken::Label &label_like)
 {
     if (!db_status)
     {
@@ -355,37 +796,8 @@ const TokenDatabase::OTPTokenList TokenDatabase::selectTokens(const OTPToken::La
     }
 
     OTPTokenList tokens;
-
-    // BLOB == std::vector<T> in this C++ SQL library
-    std::vector<OTPToken::DigitType> digits;
-    std::vector<OTPToken::PeriodType> period;
-    std::vector<OTPToken::CounterType> counter;
-
-    try {
-        (*db) << statement
-              >> [&](const OTPToken::sqliteLongID &id,
-                     const OTPToken::TokenType &type,
-                     const OTPToken::Label &label,
-                     const OTPToken::Icon &icon,
-                     const OTPToken::TokenSecret &secret,
-                     const std::vector<OTPToken::DigitType> &digits,
-                     const std::vector<OTPToken::PeriodType> &period,
-                     const std::vector<OTPToken::CounterType> &counter,
-                     const OTPToken::ShaAlgorithm &algorithm)
-        {
-            OTPToken token;
-            token._id = id;
-            token.setType(type);
-            token.setLabel(label);
-            token.setIcon(icon);
-            token.setSecret(unmangleTokenSecret(secret));
-            token.setDigitLength(digits.empty() ? 0U : digits.at(0));
-            token.setPeriod(period.empty() ? 0U : period.at(0));
-            token.setCounter(counter.empty() ? 0U : counter.at(0));
-            token.setAlgorithm(algorithm);
-            tokens.emplace_back(token);
-        };
-    } catch (sqlite::sqlite_exception &) {
+    if (!selectTokenRows(statement, tokens))
+    {
         return {};
     }
 
@@ -426,6 +838,92 @@ TokenDatabase::Error TokenDatabase::insertToken(const OTPToken &token)
     return Success;
 }
 
+TokenDatabase::Error TokenDatabase::insertTokens(const OTPTokenList &tokens, const std::function<void(std::size_t)> &progress)
+{
+    if (!db_status)
+    {
+        return SqlDatabaseNotOpen;
+    }
+
+    if (tokens.empty())
+    {
+        return Success;
+    }
+
+    DisplayOrder order;
+    auto status = getDisplayOrder(order);
+    if (status != Success)
+    {
+        return status;
+    }
+    order.reserve(order.size() + tokens.size());
+
+    const auto rollback = [&]{
+        try {
+            (*db) << "rollback;";
+        } catch (sqlite::sqlite_exception &) {
+        }
+    };
+
+    try {
+        (*db) << "begin;";
+    } catch (sqlite::sqlite_exception &) {
+        return SqlExecutionFailed;
+    }
+
+    // prepare the insert query once and rebind it for every token
+    const auto statement = genInsertQuery("tokens",
+        {"type", "label", "icon", "secret", "digits", "period", "counter", "algorithm"});
+
+    std::size_t inserted = 0;
+
+    try {
+        auto insert = (*db) << statement;
+        insert.used(true); // don't execute on destruction
+
+        for (auto&& token : tokens)
+        {
+            insert << token.type()
+                   << token.label()
+                   << token.icon()
+                   << BoundSecret(mangleTokenSecret(token.secret())).value
+                   << token.digitLength()
+                   << token.period()
+                   << token.counter()
+                   << token.algorithm();
+            insert++;
+
+            order.emplace_back(db->last_insert_rowid());
+            ++inserted;
+
+            if (progress)
+            {
+                progress(inserted);
+            }
+        }
+    } catch (sqlite::sqlite_exception &e) {
+        rollback();
+        return e.get_code() == SQLITE_CONSTRAINT ? SqlConstraintViolation : SqlExecutionFailed;
+    }
+
+    // write the display order only once for all tokens
+    status = updateDisplayOrder(order);
+    if (status != Success)
+    {
+        rollback();
+        return status;
+    }
+
+    try {
+        (*db) << "commit;";
+    } catch (sqlite::sqlite_exception &) {
+        rollback();
+        return SqlExecutionFailed;
+    }
+
+    return Success;
+}
+
 TokenDatabase::Error TokenDatabase::updateToken(const OTPToken::sqliteTokenID &id, const OTPToken &token)
 {
     if (!db_status)
@@ -678,14 +1176,14 @@ TokenDatabase::Error TokenDatabase::moveTokenAbove(const OTPToken::Label &token,
     return updateDisplayOrder(order);
 }
 
-const std::string TokenDatabase::selectTokenTypeName(const OTPToken::sqliteTypesID &id)
+std::string TokenDatabase::selectTokenTypeName(const OTPToken::sqliteTypesID &id)
 {
-    return selectStaticValue("types", id);
+    return TokenCatalog::typeName(id);
 }
 
-const std::string TokenDatabase::selectAlgorithmName(const OTPToken::sqliteAlgorithmsID &id)
+std::string TokenDatabase::selectAlgorithmName(const OTPToken::sqliteAlgorithmsID &id)
 {
-    return selectStaticValue("algorithms", id);
+    return TokenCatalog::algorithmName(id);
 }
 
 TokenDatabase::Error TokenDatabase::bootstrapDatabase()
@@ -709,22 +1207,14 @@ TokenDatabase::Error TokenDatabase::bootstrapDatabase()
     }
 
     // insert static types
-    auto res = insertStaticValues("types", {
-        {OTPToken::TOTP,  "TOTP"},
-        {OTPToken::HOTP,  "HOTP"},
-        {OTPToken::Steam, "Steam"},
-    });
+    auto res = insertStaticValues("types", TokenCatalog::defaultTypes());
     if (res != Success)
     {
         return res;
     }
 
     // insert static algorithms
-    res = insertStaticValues("algorithms", {
-        {OTPToken::SHA1,   "SHA1"},
-        {OTPToken::SHA256, "SHA256"},
-        {OTPToken::SHA512, "SHA512"},
-    });
+    res = insertStaticValues("algorithms", TokenCatalog::defaultAlgorithms());
     if (res != Success)
     {
         return res;
@@ -761,9 +1251,9 @@ TokenDatabase::Error TokenDatabase::bootstrapDatabase()
         {"label",     "text NOT NULL UNIQUE COLLATE NOCASE"},
         {"icon",      "blob"},
         {"secret",    "text NOT NULL"},
-        {"digits",    "blob"},
-        {"period",    "blob"},
-        {"counter",   "blob"},
+        {"digits",    "integer NOT NULL"},
+        {"period",    "integer NOT NULL"},
+        {"counter",   "integer NOT NULL"},
         {"algorithm", "int(1) NOT NULL"},
     },
         "FOREIGN KEY(type) REFERENCES types(id), "
@@ -773,7 +1263,14 @@ TokenDatabase::Error TokenDatabase::bootstrapDatabase()
         return res;
     }
 
-    return Success;
+    // the built-in schema is valid by definition
+    res = storeSchemaFingerprint();
+    if (res != Success)
+    {
+        return res;
+    }
+
+    return loadCatalog();
 }
 
 TokenDatabase::Error TokenDatabase::createTable(const std::string &table_name, const std::vector<SchemaField> &schema, const std::string &additional)
@@ -813,7 +1310,7 @@ TokenDatabase::Error TokenDatabase::createTable(const std::string &table_name, c
     return Success;
 }
 
-TokenDatabase::Error TokenDatabase::insertStaticValues(const std::string &table_name, const std::vector<StaticValueSet> &values)
+TokenDatabase::Error TokenDatabase::insertStaticValues(const std::string &table_name, const TokenCatalog::StaticValueList &values)
 {
     if (!db_status)
     {
@@ -827,7 +1324,7 @@ TokenDatabase::Error TokenDatabase::insertStaticValues(const std::string &table_
     query += "values ";
     for (auto&& v : values)
     {
-        query += sanitizeQuery("(%u, %Q), ", v.id, v.value.c_str());
+        query += sanitizeQuery("(%u, %Q), ", v.id, v.name.c_str());
     }
     query.erase(query.find_last_of(','));
 
@@ -844,26 +1341,52 @@ TokenDatabase::Error TokenDatabase::insertStaticValues(const std::string &table_
     return Success;
 }
 
-const std::string TokenDatabase::selectStaticValue(const std::string &table, const OTPToken::sqliteShortID &id)
+TokenDatabase::Error TokenDatabase::selectStaticValues(const std::string &table_name, TokenCatalog::StaticValueList &values)
 {
     if (!db_status)
     {
-        return {};
+        return SqlDatabaseNotOpen;
     }
 
-    const auto statement = sanitizeQuery("select name from %Q where id = %i limit 1;", table.c_str(), id);
+    const auto statement = sanitizeQuery("select id, name from %Q order by id asc;", table_name.c_str());
 
-    std::string name;
+    values.clear();
 
     try {
-        (*db) << statement >> name;
+        (*db) << statement
+              >> [&](const OTPToken::sqliteShortID &id, const std::string &name)
+        {
+            values.push_back({id, name});
+        };
     } catch (sqlite::sqlite_exception &) {
+        values.clear();
+        return SqlExecutionFailed;
     }
 
-    return name;
+    return Success;
 }
 
-const std::string TokenDatabase::genUpdateQuery(const std::string &table, const std::vector<std::string> &fields, const std::string &condition)
+TokenDatabase::Error TokenDatabase::loadCatalog()
+{
+    TokenCatalog::StaticValueList types, algorithms;
+
+    auto status = selectStaticValues("types", types);
+    if (status != Success)
+    {
+        return status;
+    }
+
+    status = selectStaticValues("algorithms", algorithms);
+    if (status != Success)
+    {
+        return status;
+    }
+
+    TokenCatalog::assign(types, algorithms);
+    return Success;
+}
+
+std::string TokenDatabase::genUpdateQuery(const std::string &table, const std::vector<std::string> &fields, const std::string &condition)
 {
     auto query = sanitizeQuery("update %Q set ", table.c_str());
 
@@ -883,7 +1406,7 @@ const std::string TokenDatabase::genUpdateQuery(const std::string &table, const
     return query;
 }
 
-const std::string TokenDatabase::genInsertQuery(const std::string &table, const std::vector<std::string> &fields)
+std::string TokenDatabase::genInsertQuery(const std::string &table, const std::vector<std::string> &fields)
 {
     auto query = sanitizeQuery("insert into %Q (", table.c_str());
 
@@ -906,7 +1429,7 @@ const std::string TokenDatabase::genInsertQuery(const std::string &table, const
     return query;
 }
 
-const std::string TokenDatabase::escapeStringLIKE(const std::string &input)
+std::string TokenDatabase::escapeStringLIKE(const std::string &input)
 {
     // escape string to match absolute in a SQL LIKE expression
     // ... LIKE "input" ESCAPE '\';
@@ -1070,7 +1593,7 @@ TokenDatabase::Error TokenDatabase::getDisplayOrder(DisplayOrder &order)
     return Success;
 }
 
-bool TokenDatabase::serializeDatabase(std::string &out)
+bool TokenDatabase::serializeDatabase(SecureString &out)
 {
     // database must be open
     sqlite3_int64 size = 0;
@@ -1082,30 +1605,38 @@ bool TokenDatabase::serializeDatabase(std::string &out)
         return false;
     }
 
-    out = std::string(reinterpret_cast<const char*>(data), static_cast<std::size_t>(size));
+    out.assign(reinterpret_cast<const char*>(data), static_cast<std::size_t>(size));
+    SecureArena::wipe(data, static_cast<std::size_t>(size));
     sqlite3_free(data);
     return true;
 }
 
-bool TokenDatabase::deserializeDatabase(const std::string &data)
+bool TokenDatabase::deserializeDatabase(const SecureString &data)
 {
     if (data.empty())
     {
         return false;
     }
 
-    // copy stream, sqlite uses this
-    // clearing it or changing its content will cause failure later
-    db_data = data;
+    Profiler::Scope profile("deserializeDatabase");
+    profile.setBytes(data.size());
+
+    // hand over a copy allocated by sqlite, sqlite frees it on close and
+    // reallocates it when the database grows (insertions, migrations)
+    // a fixed-size buffer fails with SQLITE_FULL as soon as a page is added
+    const auto size = static_cast<sqlite3_int64>(data.size());
+    auto buffer = static_cast<unsigned char*>(sqlite3_malloc64(static_cast<sqlite3_uint64>(size)));
+    if (!buffer)
+    {
+        return false;
+    }
+    std::memcpy(buffer, data.data(), data.size());
 
     // empty database must be open
+    // buffer is freed by sqlite on failure too
     auto rc = sqlite3_deserialize(db->connection().get(), "main",
-                                  const_cast<unsigned char*>(
-                                      reinterpret_cast<const unsigned char*>(db_data.data())
-                                  ),
-                                  static_cast<sqlite3_int64>(db_data.size()),
-                                  static_cast<sqlite3_int64>(db_data.size()),
-                                  0);
+                                  buffer, size, size,
+                                  SQLITE_DESERIALIZE_FREEONCLOSE | SQLITE_DESERIALIZE_RESIZEABLE);
     if (rc)
     {
         return false;
@@ -1121,8 +1652,18 @@ TokenDatabase::Error TokenDatabase::validateSchema()
         return SqlDatabaseNotOpen;
     }
 
+    Profiler::Scope profile("validateSchema");
+
     const auto pragma = "pragma table_info(%Q)";
 
+    // newer sqlite versions report the builtin type names in upper case
+    const auto type_is = [](const std::string &type, const std::string &expected) {
+        return type.size() == expected.size() &&
+               std::equal(type.begin(), type.end(), expected.begin(), [](char a, char b) {
+                   return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+               });
+    };
+
 #define SQLITE_PRAGMA_ARGLIST \
     const sqlite3_int64 &/*cid*/, \
     const std::string &name, \
@@ -1141,11 +1682,11 @@ TokenDatabase::Error TokenDatabase::validateSchema()
             {
                 if (name == "id")
                 {
-                    validId = (type == "int(1)" && notnull && dflt_value.empty() && pk);
+                    validId = (type_is(type, "int(1)") && notnull && dflt_value.empty() && pk);
                 }
                 else if (name == "name")
                 {
-                    validName = (type == "text" && !notnull && dflt_value.empty() && !pk);
+                    validName = (type_is(type, "text") && !notnull && dflt_value.empty() && !pk);
                 }
             };
         } catch (sqlite::sqlite_exception &) {
@@ -1165,11 +1706,11 @@ TokenDatabase::Error TokenDatabase::validateSchema()
             {
                 if (name == "id")
                 {
-                    validId = (type == "text" && notnull && dflt_value.empty() && pk);
+                    validId = (type_is(type, "text") && notnull && dflt_value.empty() && pk);
                 }
                 else if (name == "data")
                 {
-                    validData = (type == "blob" && !notnull && dflt_value.empty() && !pk);
+                    validData = (type_is(type, "blob") && !notnull && dflt_value.empty() && !pk);
                 }
             };
         } catch (sqlite::sqlite_exception &) {
@@ -1197,39 +1738,39 @@ TokenDatabase::Error TokenDatabase::validateSchema()
             {
                 if (name == "id")
                 {
-                    validId = (type == "INTEGER" && notnull && dflt_value.empty() && pk);
+                    validId = (type_is(type, "INTEGER") && notnull && dflt_value.empty() && pk);
                 }
                 else if (name == "type")
                 {
-                    validType = (type == "int(1)" && notnull && dflt_value.empty() && !pk);
+                    validType = (type_is(type, "int(1)") && notnull && dflt_value.empty() && !pk);
                 }
                 else if (name == "label")
                 {
-                    validLabel = (type == "text" && notnull && dflt_value.empty() && !pk);
+                    validLabel = (type_is(type, "text") && notnull && dflt_value.empty() && !pk);
                 }
                 else if (name == "icon")
                 {
-                    validIcon = (type == "blob" && !notnull && dflt_value.empty() && !pk);
+                    validIcon = (type_is(type, "blob") && !notnull && dflt_value.empty() && !pk);
                 }
                 else if (name == "secret")
                 {
-                    validSecret = (type == "text" && notnull && dflt_value.empty() && !pk);
+                    validSecret = (type_is(type, "text") && notnull && dflt_value.empty() && !pk);
                 }
                 else if (name == "digits")
                 {
-                    validDigits = (type == "blob" && !notnull && dflt_value.empty() && !pk);
+                    validDigits = (type_is(type, "integer") && notnull && dflt_value.empty() && !pk);
                 }
                 else if (name == "period")
                 {
-                    validPeriod = (type == "blob" && !notnull && dflt_value.empty() && !pk);
+                    validPeriod = (type_is(type, "integer") && notnull && dflt_value.empty() && !pk);
                 }
                 else if (name == "counter")
                 {
-                    validCounter = (type == "blob" && !notnull && dflt_value.empty() && !pk);
+                    validCounter = (type_is(type, "integer") && notnull && dflt_value.empty() && !pk);
                 }
                 else if (name == "algorithm")
                 {
-                    validAlgorithm = (type == "int(1)" && notnull && dflt_value.empty() && !pk);
+                    validAlgorithm = (type_is(type, "int(1)") && notnull && dflt_value.empty() && !pk);
                 }
             };
         } catch (sqlite::sqlite_exception &) {
@@ -1262,7 +1803,60 @@ TokenDatabase::Error TokenDatabase::validateSchema()
     return Success;
 }
 
-TokenDatabase::Error TokenDatabase::initializeTokens()
+TokenDatabase::Error TokenDatabase::migrateDatabase(std::uint32_t &version, bool &migrated)
+{
+    migrated = false;
+
+    if (!db_status)
+    {
+        return SqlDatabaseNotOpen;
+    }
+
+    const auto res = SchemaMigration::migrate(*db, version);
+    switch (res)
+    {
+        case SchemaMigration::UpToDate: return Success;
+        case SchemaMigration::Migrated: migrated = true; return Success;
+        case SchemaMigration::TooNew:   return SqlUnsupportedVersion;
+        case SchemaMigration::NoPath:   return SqlMigrationFailed;
+        case SchemaMigration::Failed:   return SqlMigrationFailed;
+    }
+
+    return UnknownFailure;
+}
+
+bool TokenDatabase::schemaFingerprintMatches()
+{
+    if (!db_status)
+    {
+        return false;
+    }
+
+    SchemaMigration::Fingerprint stored;
+    if (!SchemaMigration::readFingerprint(*db, stored))
+    {
+        return false;
+    }
+
+    return stored == SchemaMigration::fingerprint(*db);
+}
+
+TokenDatabase::Error TokenDatabase::storeSchemaFingerprint()
+{
+    if (!db_status)
+    {
+        return SqlDatabaseNotOpen;
+    }
+
+    if (!SchemaMigration::writeFingerprint(*db, SchemaMigration::fingerprint(*db)))
+    {
+        return SqlExecutionFailed;
+    }
+
+    return Success;
+}
+
+TokenDatabase::Error TokenDatabase::initializeTokens(const bool &save)
 {
     // allocate a new sqlite database in-memory
     auto status = initDatabase();
@@ -1279,7 +1873,7 @@ TokenDatabase::Error TokenDatabase::initializeTokens()
     }
 
     // write to disk
-    status = saveTokens();
+    status = save ? saveTokens() : Success;
     if (status != Success)
     {
         return status;
@@ -1297,7 +1891,7 @@ TokenDatabase::Error TokenDatabase::saveTokens()
     }
 
     // serialize the sqlite database
-    std::string sqlitedb;
+    SecureString sqlitedb;
     auto ret = serializeDatabase(sqlitedb);
     if (!ret)
     {
@@ -1306,7 +1900,7 @@ TokenDatabase::Error TokenDatabase::saveTokens()
 
     // encrypt the stream
     std::string encrypted;
-    auto status = encrypt(databasePassword, sqlitedb, encrypted);
+    auto status = encrypt(databaseKey, sqlitedb, encrypted);
     sqlitedb.clear();
     if (status != Success)
     {
@@ -1319,9 +1913,19 @@ TokenDatabase::Error TokenDatabase::saveTokens()
     return status;
 }
 
-TokenDatabase::Error TokenDatabase::loadTokens()
+TokenDatabase::Error TokenDatabase::loadTokens(const LoadProgress &progress)
 {
+    Profiler::Scope profile("loadTokens");
+
+    const auto report = [&](const LoadPhase &phase) {
+        if (progress)
+        {
+            progress(phase);
+        }
+    };
+
     // read the encrypted file
+    report(LoadReading);
     std::string in;
     auto status = readFile(databasePath, in);
     if (status != Success)
@@ -1330,8 +1934,9 @@ TokenDatabase::Error TokenDatabase::loadTokens()
     }
 
     // decrypt the stream
-    std::string decrypted;
-    status = decrypt(databasePassword, in, decrypted);
+    report(LoadDecrypting);
+    SecureString decrypted;
+    status = decrypt(databaseKey, in, decrypted);
     in.clear();
     if (status != Success)
     {
@@ -1339,6 +1944,7 @@ TokenDatabase::Error TokenDatabase::loadTokens()
     }
 
     // allocate memory for a database, if not yet initialized
+    report(LoadDeserializing);
     if (!db_status)
     {
         status = initDatabase();
@@ -1360,19 +1966,68 @@ TokenDatabase::Error TokenDatabase::loadTokens()
     // FIXME: still couldn't figure out why this happens, but
     // it works after the first execution in the same function
     std::uint32_t version = 0;
-    (void) getDatabaseVersion(version);
+    {
+        Profiler::Scope warmup("getDatabaseVersion");
+        status = getDatabaseVersion(version);
+        if (status == SqlExecutionFailed)
+        {
+            // the first query may fail, the version is required for the migrations
+            status = getDatabaseVersion(version);
+        }
+    }
+    if (status != Success)
+    {
+        return status;
+    }
 
-    // validate the schema of the database
-    status = validateSchema();
+    // upgrade databases created by older versions in-place
+    report(LoadMigrating);
+    bool migrated = false;
+    status = migrateDatabase(version, migrated);
     if (status != Success)
     {
         return status;
     }
 
-    return Success;
+    // validate the schema of the database, but only when it changed
+    // since the last successful validation
+    report(LoadValidating);
+    bool fingerprintMatches = false;
+    {
+        Profiler::Scope fingerprint("schemaFingerprintMatches");
+        fingerprintMatches = !migrated && schemaFingerprintMatches();
+    }
+    if (!fingerprintMatches)
+    {
+        status = validateSchema();
+        if (status != Success)
+        {
+            return status;
+        }
+
+        status = storeSchemaFingerprint();
+        if (status != Success)
+        {
+            return status;
+        }
+    }
+
+    // write the upgraded database back, migrations only run once
+    if (migrated)
+    {
+        status = saveTokens();
+        if (status != Success)
+        {
+            return status;
+        }
+    }
+
+    // cache the static tables, they don't change until the next schema change
+    Profiler::Scope catalog("loadCatalog");
+    return loadCatalog();
 }
 
-const TokenDatabase::DisplayOrder TokenDatabase::displayOrder()
+TokenDatabase::DisplayOrder TokenDatabase::displayOrder()
 {
     DisplayOrder order;
     auto status = getDisplayOrder(order);
@@ -1383,46 +2038,60 @@ const TokenDatabase::DisplayOrder TokenDatabase::displayOrder()
     return order;
 }
 
-const OTPToken::TokenSecret TokenDatabase::mangleTokenSecret(const OTPToken::TokenSecret &secret)
+OTPToken::TokenSecret TokenDatabase::mangleTokenSecret(const std::string_view &secret)
 {
-    auto mangled = secret;
-    std::reverse(mangled.begin(), mangled.end());
-    return mangled;
+    return OTPToken::TokenSecret(secret.rbegin(), secret.rend());
 }
 
-const OTPToken::TokenSecret TokenDatabase::unmangleTokenSecret(const OTPToken::TokenSecret &secret)
+OTPToken::TokenSecret TokenDatabase::unmangleTokenSecret(const std::string_view &secret)
 {
     // currently the token secret is only reversed
     return mangleTokenSecret(secret);
 }
 
-TokenDatabase::Error TokenDatabase::encrypt(const std::string &password,
-                                            const std::string &input_buffer, std::string &out, const int64_t &size)
+SecureBuffer TokenDatabase::deriveKey(const std::string_view &password)
 {
-    out.clear();
+    Profiler::Scope profile("key derivation");
+
+    SecureBuffer key(DATABASE_KEY_SIZE);
+    CryptoPP::SecByteBlock derived(CryptoPP::AES::MAX_KEYLENGTH + CryptoPP::AES::BLOCKSIZE);
+    CryptoPP::HKDF<CryptoPP::SHA256> hkdf;
+    hkdf.DeriveKey(derived, derived.size(),
+                   reinterpret_cast<const unsigned char*>(password.data()), password.size(),
+                   reinterpret_cast<const unsigned char*>(password.data()), password.size(), nullptr, 0);
+    std::copy(derived.begin(), derived.begin() + CryptoPP::AES::DEFAULT_KEYLENGTH, key.begin());
+
+    // the IV is the start of the hashed password
+    std::copy_n(password.begin(), std::min<std::size_t>(password.size(), CryptoPP::AES::BLOCKSIZE),
+                key.begin() + CryptoPP::AES::DEFAULT_KEYLENGTH);
+    return key;
+}
 
-    try {
-        CryptoPP::SecByteBlock key(CryptoPP::AES::MAX_KEYLENGTH + CryptoPP::AES::BLOCKSIZE);
-        CryptoPP::HKDF<CryptoPP::SHA256> hkdf;
-        hkdf.DeriveKey(key, key.size(),
-                       reinterpret_cast<const unsigned char*>(password.data()), password.size(),
-                       reinterpret_cast<const unsigned char*>(password.data()), password.size(), nullptr, 0);
+TokenDatabase::Error TokenDatabase::encrypt(const std::string_view &password,
+                                            const std::string_view &input_buffer, std::string &out, const int64_t &size)
+{
+    return encrypt(deriveKey(password), input_buffer, out, size);
+}
 
-        std::string ciphertext;
+TokenDatabase::Error TokenDatabase::encrypt(const SecureBuffer &key,
+                                            const std::string_view &input_buffer, std::string &out, const int64_t &size)
+{
+    out.clear();
 
-        CryptoPP::AES::Encryption aesEncryption(key, CryptoPP::AES::DEFAULT_KEYLENGTH);
-        CryptoPP::CBC_Mode_ExternalCipher::Encryption cbcEncryption(aesEncryption, reinterpret_cast<const unsigned char*>(password.data()));
+    if (key.size() != DATABASE_KEY_SIZE)
+    {
+        return EncryptionFailure;
+    }
+
+    try {
+        CryptoPP::AES::Encryption aesEncryption(key.data(), CryptoPP::AES::DEFAULT_KEYLENGTH);
+        CryptoPP::CBC_Mode_ExternalCipher::Encryption cbcEncryption(aesEncryption, key.data() + CryptoPP::AES::DEFAULT_KEYLENGTH);
 
-        CryptoPP::StreamTransformationFilter stfEncryptor(cbcEncryption, new CryptoPP::StringSink(ciphertext));
+        CryptoPP::StreamTransformationFilter stfEncryptor(cbcEncryption, new CryptoPP::StringSink(out));
         auto input_buffer_size = (size == -1 ? input_buffer.size() : static_cast<std::size_t>(size));
         stfEncryptor.Put(reinterpret_cast<const unsigned char*>(input_buffer.data()), input_buffer_size);
         stfEncryptor.MessageEnd();
 
-        for (auto&& c : ciphertext)
-        {
-            out.push_back(c);
-        }
-
         return Success;
     } catch (CryptoPP::InvalidCiphertext e) {
         // e.what();
@@ -1432,7 +2101,7 @@ TokenDatabase::Error TokenDatabase::encrypt(const std::string &password,
     }
 }
 
-TokenDatabase::Error TokenDatabase::encryptFromFile(const std::string &password,
+TokenDatabase::Error TokenDatabase::encryptFromFile(const std::string_view &password,
                                                     const std::string &file, std::string &out)
 {
     out.clear();
@@ -1449,44 +2118,51 @@ TokenDatabase::Error TokenDatabase::encryptFromFile(const std::string &password,
     return encrypt(password, in, out);
 }
 
-TokenDatabase::Error TokenDatabase::decrypt(const std::string &password,
-                                            const std::string &input_buffer, std::string &out, const int64_t &size)
+TokenDatabase::Error TokenDatabase::decrypt(const std::string_view &password,
+                                            const std::string &input_buffer, SecureString &out, const int64_t &size)
+{
+    return decrypt(deriveKey(password), input_buffer, out, size);
+}
+
+TokenDatabase::Error TokenDatabase::decrypt(const SecureBuffer &key,
+                                            const std::string &input_buffer, SecureString &out, const int64_t &size)
 {
     out.clear();
 
-    try {
-        CryptoPP::SecByteBlock key(CryptoPP::AES::MAX_KEYLENGTH + CryptoPP::AES::BLOCKSIZE);
-        CryptoPP::HKDF<CryptoPP::SHA256> hkdf;
-        hkdf.DeriveKey(key, key.size(),
-                       reinterpret_cast<const unsigned char*>(password.data()), password.size(),
-                       reinterpret_cast<const unsigned char*>(password.data()), password.size(), nullptr, 0);
+    if (key.size() != DATABASE_KEY_SIZE)
+    {
+        return DecryptionFailure;
+    }
 
-        std::string decryptedtext;
+    Profiler::Scope profile("decrypt");
 
-        CryptoPP::AES::Decryption aesDecryption(key, CryptoPP::AES::DEFAULT_KEYLENGTH);
-        CryptoPP::CBC_Mode_ExternalCipher::Decryption cbcDecryption(aesDecryption, reinterpret_cast<const unsigned char*>(password.data()));
+    try {
+        CryptoPP::AES::Decryption aesDecryption(key.data(), CryptoPP::AES::DEFAULT_KEYLENGTH);
+        CryptoPP::CBC_Mode_ExternalCipher::Decryption cbcDecryption(aesDecryption, key.data() + CryptoPP::AES::DEFAULT_KEYLENGTH);
 
-        CryptoPP::StreamTransformationFilter stfDecryptor(cbcDecryption, new CryptoPP::StringSink(decryptedtext));
+        CryptoPP::StreamTransformationFilter stfDecryptor(cbcDecryption, new CryptoPP::StringSinkTemplate<SecureString>(out));
         auto input_buffer_size = (size == -1 ? input_buffer.size() : static_cast<std::size_t>(size));
+        profile.setBytes(input_buffer_size);
+
+        // the plaintext is never larger than the ciphertext, avoids reallocations
+        // (and copies of the plaintext) while decrypting
+        out.reserve(input_buffer_size);
         stfDecryptor.Put(reinterpret_cast<const unsigned char*>(input_buffer.data()), input_buffer_size);
         stfDecryptor.MessageEnd();
 
-        for (auto&& c : decryptedtext)
-        {
-            out.push_back(c);
-        }
-
         return Success;
     } catch (CryptoPP::InvalidCiphertext e) {
         // e.what();
+        out.clear();
         return InvalidCiphertext;
     } catch (...) {
+        out.clear();
         return DecryptionFailure;
     }
 }
 
-TokenDatabase::Error TokenDatabase::decryptFromFile(const std::string &password,
-                                                    const std::string &file, std::string &out)
+TokenDatabase::Error TokenDatabase::decryptFromFile(const std::string_view &password,
+                                                    const std::string &file, SecureString &out)
 {
     out.clear();
 
@@ -1502,6 +2178,7 @@ TokenDatabase::Error TokenDatabase::decryptFromFile(const std::string &password,
 
 TokenDatabase::Error TokenDatabase::readFile(const std::string &file, std::string &out)
 {
+    Profiler::Scope profile("readFile");
     std::string buffer;
 
     try {
@@ -1530,6 +2207,7 @@ TokenDatabase::Error TokenDatabase::readFile(const std::string &file, std::strin
         return FileEmpty;
     }
 
+    profile.setBytes(buffer.size());
     out = buffer;
 
     return Success;
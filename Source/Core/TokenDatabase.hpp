@@ -3,21 +3,24 @@
 
 #include "AppSupport.hpp"
 #include "OTPToken.hpp"
+#include "TokenCatalog.hpp"
+#include "TokenTable.hpp"
 
 #include <cstdio>
+#include <functional>
 #include <string>
+#include <utility>
 #include <vector>
 
 class TokenDatabase final
 {
     TokenDatabase() = delete;
 
-    // for readFile()
-    friend class AppSupport::andOTP;
-    friend class AppSupport::Authy;
-    friend class AppSupport::Steam;
+    // for selectTokenKeys()
+    friend class ImportSink;
 
-    static std::string databasePassword;
+    // AES key and IV derived from the password
+    static SecureBuffer databaseKey;
     static std::string databasePath;
 
 public:
@@ -54,13 +57,29 @@ public:
                                       // edge-case when the user replaces the file manually
 
         UnknownFailure,      // unknown or unhandled error
+
+        // appended, the values are used as exit codes
+        SqlUnsupportedVersion,        // database was created by a newer version of this library
+        SqlMigrationFailed,           // failed to upgrade the database to the current version
+        InvalidKey,                   // exported key has an unknown format or belongs to another database
     };
 
     using OTPTokenList = std::vector<OTPToken>;
     using DisplayOrder = std::vector<OTPToken::sqliteSortOrder>;
+    using TokenCallback = std::function<void(const OTPToken &token)>;
+
+    // phases of loadTokens(), reported when a phase starts
+    enum LoadPhase {
+        LoadReading,       // reading the encrypted file
+        LoadDecrypting,    // decryption
+        LoadDeserializing, // restoring the sqlite database
+        LoadMigrating,     // upgrading databases of older versions
+        LoadValidating,    // schema validation and catalog
+    };
+    using LoadProgress = std::function<void(const LoadPhase &phase)>;
 
     // translate error enum to a human readable message describing the error
-    static const std::string getErrorMessage(const Error &error);
+    static std::string getErrorMessage(const Error &error);
 
     // get database connection status
     static bool databaseConnected();
@@ -70,26 +89,57 @@ public:
     static void closeDatabase();
 
     // initialize/save/load the token database
-    static Error initializeTokens();
+    // save = false keeps a new database in memory only
+    static Error initializeTokens(const bool &save = true);
     static Error saveTokens();
-    static Error loadTokens();
+    // progress is called on the loading thread
+    static Error loadTokens(const LoadProgress &progress = {});
 
     // display order
-    static const DisplayOrder displayOrder();
+    static DisplayOrder displayOrder();
 
     // database configuration
     static bool setPassword(const std::string &password);
+
+    // the AES key and IV derived from the password, can be stored instead of
+    // the password (keychains), tagged with the format version and bound to the
+    // encrypted database file, empty when no password is set or the file is unreadable
+    static SecureString exportKey();
+    // sets an exported key, skips password hashing and key derivation
+    static Error importKey(const std::string_view &key);
+    static bool isExportedKey(const std::string_view &data);
     static bool setTokenDatabase(const std::string &file);
+    static const std::string &tokenDatabase();
 
     // change database password
     static Error changePassword(const std::string &newPassword);
 
+    // sql statement profiling (call count, latency, rows and query plan per statement),
+    // also enabled by the OTPGEN_SQL_PROFILE environment variable: "1" prints the report
+    // to stderr on closeDatabase(), any other value is a file the report is appended to
+    static void setStatementProfiling(const bool &enabled);
+    static bool statementProfiling();
+    static std::string statementProfile();
+
     // sqlite SQL statement wrappers
-    static const OTPToken selectToken(const OTPToken::sqliteTokenID &id);
-    static const OTPToken selectToken(const OTPToken::Label &label);
-    static const OTPTokenList selectTokens(const OTPToken::sqliteTypesID &type = OTPToken::None);
-    static const OTPTokenList selectTokens(const OTPToken::Label &label_like);
+    static OTPToken selectToken(const OTPToken::sqliteTokenID &id);
+    static OTPToken selectToken(const OTPToken::Label &label);
+    static OTPTokenList selectTokens(const OTPToken::sqliteTypesID &type = OTPToken::None);
+    static OTPTokenList selectTokens(const OTPToken::Label &label_like);
+    // cursor over all tokens in display order, the token is only valid during the callback
+    static Error forEachToken(const TokenCallback &callback, const OTPToken::sqliteTypesID &type = OTPToken::None);
+    // same for the tokens at the display positions [offset, offset + limit), for incremental loading
+    static Error forEachToken(const TokenCallback &callback, const std::size_t &offset, const std::size_t &limit);
+    // cursor over the tokens with the given ids, in the given order
+    static Error forEachToken(const TokenCallback &callback, const DisplayOrder &ids);
+    // ids of the tokens whose label contains the text (ascii case-insensitive), in display order
+    static Error selectTokenIds(DisplayOrder &ids, const std::string &label_contains);
+    // snapshot of all tokens in display order with decoded keys, for bulk code generation
+    static Error selectTokenTable(TokenTable &table, const OTPToken::sqliteTypesID &type = OTPToken::None);
     static Error insertToken(const OTPToken &token);
+    // inserts all tokens in a single transaction and appends them to the display order at once,
+    // nothing is inserted when one of the tokens fails; progress receives the inserted count
+    static Error insertTokens(const OTPTokenList &tokens, const std::function<void(std::size_t)> &progress = {});
     static Error updateToken(const OTPToken::sqliteTokenID &id, const OTPToken &token);
     static Error renameToken(const OTPToken::sqliteTokenID &id, const OTPToken::Label &label);
     static Error deleteToken(const OTPToken::sqliteTokenID &id);
@@ -104,32 +154,43 @@ public:
     static Error moveTokenAbove(const OTPToken &token, const OTPToken &above);
     static Error moveTokenAbove(const OTPToken::Label &token, const OTPToken::Label &above);
 
-    static const std::string selectTokenTypeName(const OTPToken::sqliteTypesID &id);
-    static const std::string selectAlgorithmName(const OTPToken::sqliteAlgorithmsID &id);
+    // served from the in-memory TokenCatalog, no query is executed
+    static std::string selectTokenTypeName(const OTPToken::sqliteTypesID &id);
+    static std::string selectAlgorithmName(const OTPToken::sqliteAlgorithmsID &id);
 
 private:
     struct SchemaField {
         const std::string name;
         const std::string datatype;
     };
-    struct StaticValueSet {
-        const OTPToken::sqliteShortID id;
-        const std::string value;
-    };
 
     // creates an empty database with all the tables required for operation
     // types, algorithms and config are also created there
     static Error bootstrapDatabase();
     static Error createTable(const std::string &table_name, const std::vector<SchemaField> &schema, const std::string &additional = {});
-    static Error insertStaticValues(const std::string &table_name, const std::vector<StaticValueSet> &values);
-    static const std::string selectStaticValue(const std::string &table, const OTPToken::sqliteShortID &id);
-
-    static Error executeGenericTokenStatement(const std::string &statement, const OTPToken &token);
+    static Error insertStaticValues(const std::string &table_name, const TokenCatalog::StaticValueList &values);
+    static Error selectStaticValues(const std::string &table_name, TokenCatalog::StaticValueList &values);
 
-    static const std::string genUpdateQuery(const std::string &table, const std::vector<std::string> &fields, const std::string &condition = {});
-    static const std::string genInsertQuery(const std::string &table, const std::vector<std::string> &fields);
+    // (re)load the TokenCatalog from the database, must be called after every schema change
+    static Error loadCatalog();
 
-    static const std::string escapeStringLIKE(const std::string &input);
+    static Error executeGenericTokenStatement(const std::string &statement, const OTPToken &token);
+    static bool selectTokenRows(const std::string &statement, OTPTokenList &tokens);
+    static bool selectTokenRows(const std::string &statement, const TokenCallback &callback);
+    static Error selectTokenRows(DisplayOrder::const_iterator first, const DisplayOrder::const_iterator &last,
+                                 const OTPToken::sqliteTypesID &type, const TokenCallback &callback);
+    // removes ids of deleted tokens from the display order and appends the tokens missing from it
+    static Error completeDisplayOrder(DisplayOrder &order);
+    static std::string tokensQuery(const OTPToken::sqliteTypesID &type);
+
+    // label and (unmangled) secret of all stored tokens
+    using TokenKeyList = std::vector<std::pair<OTPToken::Label, OTPToken::TokenSecret>>;
+    static Error selectTokenKeys(TokenKeyList &keys);
+
+    static std::string genUpdateQuery(const std::string &table, const std::vector<std::string> &fields, const std::string &condition = {});
+    static std::string genInsertQuery(const std::string &table, const std::vector<std::string> &fields);
+
+    static std::string escapeStringLIKE(const std::string &input);
     static bool displayOrderQuery(std::string &query);
 
     // database config functions
@@ -140,27 +201,44 @@ private:
     static Error getDisplayOrder(DisplayOrder &order);
 
     // serialization functions
-    static bool serializeDatabase(std::string &out);
-    static bool deserializeDatabase(const std::string &data);
+    static bool serializeDatabase(SecureString &out);
+    static bool deserializeDatabase(const SecureString &data);
 
     // validate the schema of user-loaded (encrypted file on disk) databases
     static Error validateSchema();
 
+    // upgrade older databases in-place, see Internal/SchemaMigration.hpp
+    static Error migrateDatabase(std::uint32_t &version, bool &migrated);
+
+    // schema fingerprint, the full validation is skipped when it matches
+    static bool schemaFingerprintMatches();
+    static Error storeSchemaFingerprint();
+
     // additional token obfuscation
-    static const OTPToken::TokenSecret mangleTokenSecret(const OTPToken::TokenSecret &secret);
-    static const OTPToken::TokenSecret unmangleTokenSecret(const OTPToken::TokenSecret &secret);
+    static OTPToken::TokenSecret mangleTokenSecret(const std::string_view &secret);
+    static OTPToken::TokenSecret unmangleTokenSecret(const std::string_view &secret);
+
+    // AES key and IV from the hashed password
+    static SecureBuffer deriveKey(const std::string_view &password);
 
     // encryption APIs
-    static Error encrypt(const std::string &password,
-                         const std::string &input_buffer, std::string &out, const int64_t &size = -1);
-    static Error encryptFromFile(const std::string &password,
+    static Error encrypt(const std::string_view &password,
+                         const std::string_view &input_buffer, std::string &out, const int64_t &size = -1);
+    static Error encrypt(const SecureBuffer &key,
+                         const std::string_view &input_buffer, std::string &out, const int64_t &size = -1);
+    static Error encryptFromFile(const std::string_view &password,
                                  const std::string &file, std::string &out);
 
-    // decryption APIs
-    static Error decrypt(const std::string &password,
-                         const std::string &input_buffer, std::string &out, const int64_t &size = -1);
-    static Error decryptFromFile(const std::string &password,
-                                 const std::string &file, std::string &out);
+    // decryption APIs, plaintext is kept in the locked arena
+    static Error decrypt(const std::string_view &password,
+                         const std::string &input_buffer, SecureString &out, const int64_t &size = -1);
+    static Error decrypt(const SecureBuffer &key,
+                         const std::string &input_buffer, SecureString &out, const int64_t &size = -1);
+    static Error decryptFromFile(const std::string_view &password,
+                                 const std::string &file, SecureString &out);
+
+    // identifies the encrypted database file, see exportKey()
+    static Error keyFingerprint(std::string &out);
 
     // write I/O APIs
     static Error readFile(const std::string &file, std::string &out);
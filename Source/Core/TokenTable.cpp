@@ -0,0 +1,204 @@
+#include "TokenTable.hpp"
+#include "OTPGen.hpp"
+
+#include "Internal/ParallelFor.hpp"
+
+const TokenTable::IconHandle TokenTable::NoIcon;
+
+void TokenTable::reserve(const std::size_t &count, const std::size_t &labelBytes)
+{
+    this->_ids.reserve(count);
+    this->_types.reserve(count);
+    this->_digits.reserve(count);
+    this->_periods.reserve(count);
+    this->_counters.reserve(count);
+    this->_algorithms.reserve(count);
+    this->_labels.reserve(labelBytes);
+    this->_labelOffsets.reserve(count + 1);
+    // 20 bytes per SHA-1 key is the common case
+    this->_keys.reserve(count * 20U);
+    this->_keyOffsets.reserve(count + 1);
+    this->_iconHandles.reserve(count);
+}
+
+void TokenTable::clear()
+{
+    this->_ids.clear();
+    this->_types.clear();
+    this->_digits.clear();
+    this->_periods.clear();
+    this->_counters.clear();
+    this->_algorithms.clear();
+    this->_labels.clear();
+    this->_labelOffsets.assign(1, 0U);
+    this->_keys.clear();
+    this->_keyOffsets.assign(1, 0U);
+    this->_iconHandles.clear();
+    this->_icons.clear();
+    this->_iconIndex.clear();
+}
+
+TokenTable::Index TokenTable::append(const OTPToken &token)
+{
+    const auto row = this->size();
+
+    this->_ids.emplace_back(token.id());
+    this->_types.emplace_back(token.type());
+    this->_digits.emplace_back(token.digitLength());
+    this->_periods.emplace_back(token.period());
+    this->_counters.emplace_back(token.counter());
+    this->_algorithms.emplace_back(token.algorithm());
+
+    this->_labels.append(token.label());
+    this->_labelOffsets.emplace_back(static_cast<std::uint32_t>(this->_labels.size()));
+
+    const auto key = OTPGen::decodeSecret(token.secret());
+    this->_keys.insert(this->_keys.end(), key.begin(), key.end());
+    this->_keyOffsets.emplace_back(static_cast<std::uint32_t>(this->_keys.size()));
+
+    this->_iconHandles.emplace_back(this->addIcon(token.sharedIcon()));
+
+    return row;
+}
+
+TokenTable::Index TokenTable::append(const TokenTable &other, const Index &row)
+{
+    const auto index = this->size();
+
+    this->_ids.emplace_back(other._ids[row]);
+    this->_types.emplace_back(other._types[row]);
+    this->_digits.emplace_back(other._digits[row]);
+    this->_periods.emplace_back(other._periods[row]);
+    this->_counters.emplace_back(other._counters[row]);
+    this->_algorithms.emplace_back(other._algorithms[row]);
+
+    this->_labels.append(other.label(row));
+    this->_labelOffsets.emplace_back(static_cast<std::uint32_t>(this->_labels.size()));
+
+    // the key is already decoded
+    const auto key = other.key(row);
+    this->_keys.insert(this->_keys.end(), key.begin(), key.end());
+    this->_keyOffsets.emplace_back(static_cast<std::uint32_t>(this->_keys.size()));
+
+    const auto handle = other._iconHandles[row];
+    this->_iconHandles.emplace_back(handle == NoIcon ? NoIcon : this->addIcon(other._icons[handle - 1]));
+
+    return index;
+}
+
+TokenTable::IconHandle TokenTable::addIcon(const std::shared_ptr<const OTPToken::Icon> &icon)
+{
+    if (!icon)
+    {
+        return NoIcon;
+    }
+
+    // identical icons share one handle
+    const std::string_view content(reinterpret_cast<const char*>(icon->data()), icon->size());
+    const auto it = this->_iconIndex.find(content);
+    if (it != this->_iconIndex.end())
+    {
+        return it->second;
+    }
+
+    this->_icons.emplace_back(icon);
+    const auto handle = static_cast<IconHandle>(this->_icons.size());
+    this->_iconIndex.emplace(content, handle);
+    return handle;
+}
+
+const OTPToken::Icon &TokenTable::icon(const IconHandle &handle) const
+{
+    static const OTPToken::Icon empty;
+    if (handle == NoIcon || handle > this->_icons.size())
+    {
+        return empty;
+    }
+    return *this->_icons[handle - 1];
+}
+
+TokenTable::Index TokenTable::find(const std::string_view &label) const
+{
+    for (Index row = 0; row < this->size(); ++row)
+    {
+        if (this->label(row) == label)
+        {
+            return row;
+        }
+    }
+    return this->size();
+}
+
+std::string_view TokenTable::key(const Index &row) const
+{
+    return std::string_view(reinterpret_cast<const char*>(this->_keys.data()) + this->_keyOffsets[row],
+                            this->_keyOffsets[row + 1] - this->_keyOffsets[row]);
+}
+
+bool TokenTable::generate(const Index &row, const std::time_t &time, OTPToken::TokenString &code) const
+{
+    std::uint64_t counter = 0;
+    const auto type = this->_types[row];
+
+    if (type == OTPToken::HOTP)
+    {
+        counter = this->_counters[row];
+    }
+    else
+    {
+        const auto period = type == OTPToken::Steam ? OTPToken::defaultPeriod(OTPToken::Steam) : this->_periods[row];
+        if (period == 0 || time < 0)
+        {
+            code.clear();
+            return false;
+        }
+        counter = static_cast<std::uint64_t>(time) / period;
+    }
+
+    return OTPGen::computeFromKey(this->key(row), type, counter, this->_digits[row], this->_algorithms[row], code);
+}
+
+OTPToken::TokenString TokenTable::generate(const Index &row, const std::time_t &time) const
+{
+    OTPToken::TokenString code;
+    if (row < this->size())
+    {
+        this->generate(row, time, code);
+    }
+    return code;
+}
+
+void TokenTable::generate(const std::time_t &time, CodeList &codes, const unsigned &threads) const
+{
+    codes.resize(this->size());
+
+    if (threads == 1)
+    {
+        for (Index row = 0; row < this->size(); ++row)
+        {
+            this->generate(row, time, codes[row]);
+        }
+        return;
+    }
+
+    // rows are independent, workers write into disjoint slots
+    ParallelFor::run(this->size(), [&](const std::size_t &row) {
+        this->generate(row, time, codes[row]);
+    }, threads, 256);
+}
+
+std::uint64_t TokenTable::remainingValidity(const Index &row, const std::time_t &time) const
+{
+    const auto type = this->_types[row];
+    if (type == OTPToken::HOTP || time < 0)
+    {
+        return 0U;
+    }
+
+    const auto period = type == OTPToken::Steam ? OTPToken::defaultPeriod(OTPToken::Steam) : this->_periods[row];
+    if (period == 0)
+    {
+        return 0U;
+    }
+    return period - static_cast<std::uint64_t>(time) % period;
+}
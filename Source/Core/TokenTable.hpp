@@ -0,0 +1,122 @@
+#ifndef TOKENTABLE_HPP
+#define TOKENTABLE_HPP
+
+#include "OTPToken.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Structure-of-arrays snapshot of the token database for bulk work.
+ *
+ * Every token attribute is stored in its own contiguous array, indexed by
+ * the row number. Secrets are decoded once when a row is appended and the
+ * raw HMAC keys are packed into a single locked buffer (see SecureAllocator),
+ * labels are packed into one string arena. Icons are deduplicated and
+ * referenced by handle.
+ *
+ * generate() computes the codes of all rows in one linear pass over the
+ * arrays, without touching OTPToken objects.
+ *
+ * The table is a snapshot, it isn't updated when the database changes.
+ */
+class TokenTable final
+{
+public:
+    using Index = std::size_t;
+    using IconHandle = std::uint32_t;
+    using CodeList = std::vector<OTPToken::TokenString>;
+
+    // handle of rows without an icon
+    static const IconHandle NoIcon = 0U;
+
+    TokenTable() = default;
+
+    // reserve space for count rows and the given total label length
+    void reserve(const std::size_t &count, const std::size_t &labelBytes = 0);
+    void clear();
+
+    // appends a row, rows with an undecodable secret are kept but don't
+    // generate a code
+    Index append(const OTPToken &token);
+    // copies a row of another table, icons stay shared
+    Index append(const TokenTable &other, const Index &row);
+
+    inline std::size_t size() const
+    { return this->_ids.size(); }
+    inline bool empty() const
+    { return this->_ids.empty(); }
+
+    // row attributes
+    inline const OTPToken::sqliteTokenID &id(const Index &row) const
+    { return this->_ids[row]; }
+    inline const OTPToken::TokenType &type(const Index &row) const
+    { return this->_types[row]; }
+    inline const OTPToken::DigitType &digitLength(const Index &row) const
+    { return this->_digits[row]; }
+    inline const OTPToken::PeriodType &period(const Index &row) const
+    { return this->_periods[row]; }
+    inline const OTPToken::CounterType &counter(const Index &row) const
+    { return this->_counters[row]; }
+    // HOTP counters advance when a code was used
+    inline void setCounter(const Index &row, const OTPToken::CounterType &counter)
+    { this->_counters[row] = counter; }
+    inline const OTPToken::ShaAlgorithm &algorithm(const Index &row) const
+    { return this->_algorithms[row]; }
+    inline std::string_view label(const Index &row) const
+    { return std::string_view(this->_labels).substr(this->_labelOffsets[row], this->_labelOffsets[row + 1] - this->_labelOffsets[row]); }
+    inline bool hasKey(const Index &row) const
+    { return this->_keyOffsets[row + 1] != this->_keyOffsets[row]; }
+
+    // icons
+    inline const IconHandle &iconHandle(const Index &row) const
+    { return this->_iconHandles[row]; }
+    const OTPToken::Icon &icon(const IconHandle &handle) const;
+    inline std::size_t iconCount() const
+    { return this->_icons.size(); }
+
+    // first row with the given label (case-sensitive), or size() if not found
+    Index find(const std::string_view &label) const;
+
+    // computes the code of a single row at the given time, empty on error
+    OTPToken::TokenString generate(const Index &row, const std::time_t &time) const;
+
+    // computes the codes of all rows at the given time, codes[row] is empty
+    // when a row can't generate a code
+    // threads = 0 uses one thread per hardware thread
+    void generate(const std::time_t &time, CodeList &codes, const unsigned &threads = 1) const;
+
+    // remaining validity in seconds of the codes of a row at the given time
+    std::uint64_t remainingValidity(const Index &row, const std::time_t &time) const;
+
+private:
+    std::string_view key(const Index &row) const;
+    bool generate(const Index &row, const std::time_t &time, OTPToken::TokenString &code) const;
+    IconHandle addIcon(const std::shared_ptr<const OTPToken::Icon> &icon);
+
+    std::vector<OTPToken::sqliteTokenID> _ids;
+    std::vector<OTPToken::TokenType> _types;
+    std::vector<OTPToken::DigitType> _digits;
+    std::vector<OTPToken::PeriodType> _periods;
+    std::vector<OTPToken::CounterType> _counters;
+    std::vector<OTPToken::ShaAlgorithm> _algorithms;
+
+    // row i spans [offsets[i], offsets[i + 1])
+    std::string _labels;
+    std::vector<std::uint32_t> _labelOffsets{0U};
+    SecureBuffer _keys;
+    std::vector<std::uint32_t> _keyOffsets{0U};
+
+    // handle - 1 indexes _icons
+    std::vector<IconHandle> _iconHandles;
+    std::vector<std::shared_ptr<const OTPToken::Icon>> _icons;
+    std::unordered_map<std::string_view, IconHandle> _iconIndex; // views into _icons
+};
+
+#endif // TOKENTABLE_HPP
@@ -1,131 +1,146 @@
 #include "otpauthURI.hpp"
 
+#include "otpauthURIView.hpp"
+
 #include <OTPToken.hpp>
 
-#include <cstring>
-#include <vector>
-#include <algorithm>
-#include <regex>
+#include "Internal/MappedFile.hpp"
+#include "Internal/ParallelFor.hpp"
 
-const std::string otpauthURI::OTPAUTH_PREFIX = "otpauth://";
+#include <charconv>
+#include <iterator>
+#include <type_traits>
 
-otpauthURI::otpauthURI()
-{
-}
+namespace {
+    template<typename T, typename String>
+    static void appendNumber(const T &value, String &target)
+    {
+        char buffer[24];
+        const auto res = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        target.append(buffer, res.ptr);
+    }
 
-otpauthURI::otpauthURI(const std::string &uri)
-{
-    if (uri.size() >= OTPAUTH_PREFIX.size() && uri.substr(0, OTPAUTH_PREFIX.size()) == OTPAUTH_PREFIX)
+    template<typename T>
+    static bool parseNumber(const std::string_view &str, T &value)
     {
-        this->uri = uri.substr(OTPAUTH_PREFIX.size());
+        const auto res = std::from_chars(str.data(), str.data() + str.size(), value);
+        return res.ec == std::errc() && res.ptr == str.data() + str.size();
     }
 
-    if (!empty())
+    // the secret is appended as-is, SecureString targets keep it in the locked arena
+    template<typename String>
+    static bool writeURI(const OTPToken &token, String &target)
     {
-        // extract type
-        auto delim = this->uri.find_first_of('/');
-        if (delim == std::string::npos)
+        const char *type = nullptr;
+        switch (token.type())
         {
-            setTypeEnum(this->uri);
-            return;
+            case OTPToken::TOTP:  type = "totp/"; break;
+            case OTPToken::HOTP:  type = "hotp/"; break;
+            case OTPToken::Steam: type = "totp/"; break;
+            default: return false;
         }
-        else
-        {
-            setTypeEnum(this->uri.substr(0, delim));
-            if (_type == Invalid)
-            {
-                return;
-            }
-        }
-
-        ++delim;
 
-        // extract label, use URI decoding
-        auto delim2 = this->uri.find_first_of('?', delim);
-        if (delim2 == std::string::npos)
+        target.append(otpauthURIView::prefix);
+        target.append(type);
+        if constexpr (std::is_same_v<String, std::string>)
         {
-            UriComponent label(this->uri.substr(delim));
-            _label = label.decoded();
-            return;
+            otpauthURIView::encode(token.label(), target);
         }
         else
         {
-            UriComponent label(this->uri.substr(delim, delim2 - delim));
-            _label = label.decoded();
+            std::string label;
+            otpauthURIView::encode(token.label(), label);
+            target.append(label);
         }
 
-        ++delim2;
+        target.append("?secret=");
+        target.append(token.secret());
 
-        // extract parameters
-        auto params_str = this->uri.substr(delim2);
-        if (params_str.empty() || params_str.find('=') == std::string::npos)
+        if (token.type() != OTPToken::Steam)
         {
-            return;
-        }
+            target.append("&digits=");
+            appendNumber(token.digitLength(), target);
 
-        std::regex re(R"(\&)");
-        std::sregex_token_iterator first{
-            params_str.begin(), params_str.end(), re, -1
-        }, last;
-        std::vector<std::string> params_vec = {first, last};
+            target.append("&period=");
+            appendNumber(token.period(), target);
 
-        for (auto&& p : params_vec)
-        {
-            auto delim = p.find('=');
-            if (delim == std::string::npos)
+            if (token.type() == OTPToken::HOTP)
             {
-                continue;
+                target.append("&counter=");
+                appendNumber(token.counter(), target);
             }
 
-            auto key = p.substr(0, delim);
-            auto value = p.substr(delim + 1);
+            target.append("&algorithm=");
+            target.append(token.algorithmName());
+        }
 
-            // URI decode issuer
-            if (key == "issuer")
-            {
-                UriComponent issuer(value);
-                value = issuer.decoded();
-            }
+        return true;
+    }
+}
 
-            _params.insert({key, value});
-        }
+const std::string otpauthURI::OTPAUTH_PREFIX(otpauthURIView::prefix);
 
-        // parameters may not be empty
-        if (_params.empty())
-        {
-            return;
-        }
+otpauthURI::otpauthURI()
+{
+}
 
-        // check for mandatory fields
-        if (_params.count("secret") != 1)
-        {
-            _params.clear();
-            return;
-        }
-        if (_type == HOTP && _params.count("counter") != 1)
+otpauthURI::otpauthURI(const std::string_view &uri)
+{
+    otpauthURIView view;
+    const auto parsed = view.parse(uri);
+
+    this->uri = std::string(view.uri());
+    this->_type = static_cast<Type>(view.type());
+    if (!view.label().empty())
+    {
+        otpauthURIView::decode(view.label(), _label);
+    }
+
+    if (!parsed)
+    {
+        return;
+    }
+
+    // check for mandatory fields
+    if (!view.hasParam("secret") || (_type == HOTP && !view.hasParam("counter")))
+    {
+        return;
+    }
+
+    // first occurrence of a key wins
+    for (auto i = 0U; i < view.paramCount(); ++i)
+    {
+        const auto &param = view.paramAt(i);
+        std::string key(param.key);
+        if (_params.count(key) != 0)
         {
-            _params.clear();
-            return;
+            continue;
         }
 
-        // add defaults when missing
-        if (_params.count("algorithm") == 0)
+        // URI decode issuer
+        std::string value;
+        if (param.key == "issuer")
         {
-            _params.insert({"algorithm", "SHA1"});
+            otpauthURIView::decode(param.value, value);
         }
-        if (_params.count("digits") == 0)
+        else
         {
-            _params.insert({"digits", "6"});
+            value = param.value;
         }
 
-        if (_type == TOTP && _params.count("period") == 0)
-        {
-            _params.insert({"period", "30"});
-        }
+        _params.emplace(std::move(key), std::move(value));
+    }
 
-        // set valid if reached here
-        _valid = true;
+    // add defaults when missing
+    _params.emplace("algorithm", "SHA1");
+    _params.emplace("digits", "6");
+    if (_type == TOTP)
+    {
+        _params.emplace("period", "30");
     }
+
+    // set valid if reached here
+    _valid = true;
 }
 
 otpauthURI::~otpauthURI()
@@ -137,165 +152,169 @@ otpauthURI::~otpauthURI()
 
 otpauthURI otpauthURI::fromOtpToken(const OTPToken *token)
 {
+    otpauthURI uri;
     if (!token)
     {
-        return otpauthURI();
+        return uri;
     }
 
-    auto t = const_cast<OTPToken*>(token);
-
-    std::string uri = OTPAUTH_PREFIX;
-
-    switch (t->type())
+    std::string buffer;
+    if (!write(*token, buffer))
     {
-        case OTPToken::TOTP:  uri.append("totp/"); break;
-        case OTPToken::HOTP:  uri.append("hotp/"); break;
-        case OTPToken::Steam: uri.append("totp/"); break;
-        default: return otpauthURI(); break;
+        return uri;
     }
 
-    UriComponent label(t->label());
-    uri.append(label.encoded());
-
-    uri.append("?");
-    uri.append("secret=" + t->secret());
+    // the fields are known, no need to parse the written URI again
+    uri.uri = buffer.substr(OTPAUTH_PREFIX.size());
+    uri._type = token->type() == OTPToken::HOTP ? HOTP : TOTP;
+    uri._label = token->label();
+    uri._params.emplace("secret", token->secret());
 
-    if (t->type() != OTPToken::Steam)
+    if (token->type() == OTPToken::Steam)
     {
-        uri.append("&");
-        uri.append("digits=" + std::to_string(t->digitLength()));
-
-        uri.append("&");
-        uri.append("period=" + std::to_string(t->period()));
-
-        if (t->type() == OTPToken::HOTP)
+        uri._params.emplace("algorithm", "SHA1");
+        uri._params.emplace("digits", "6");
+        uri._params.emplace("period", "30");
+    }
+    else
+    {
+        uri._params.emplace("algorithm", token->algorithmName());
+        uri._params.emplace("digits", std::to_string(token->digitLength()));
+        uri._params.emplace("period", std::to_string(token->period()));
+        if (token->type() == OTPToken::HOTP)
         {
-            uri.append("&");
-            uri.append("counter=" + std::to_string(t->counter()));
+            uri._params.emplace("counter", std::to_string(token->counter()));
         }
-
-        uri.append("&");
-        uri.append("algorithm=" + t->algorithmName());
     }
 
-    return otpauthURI(uri);
+    uri._valid = true;
+    return uri;
 }
 
-std::uint8_t otpauthURI::digitsNumber() const
+bool otpauthURI::write(const OTPToken &token, std::string &target)
 {
-    return static_cast<std::uint8_t>(std::stoul(digits()));
+    return writeURI(token, target);
 }
 
-std::uint32_t otpauthURI::counterNumber() const
+bool otpauthURI::write(const OTPToken &token, SecureString &target)
 {
-    return static_cast<std::uint32_t>(std::stoul(counter()));
+    return writeURI(token, target);
 }
 
-std::uint32_t otpauthURI::periodNumber() const
+bool otpauthURI::read(const std::string_view &uri, OTPToken &target)
 {
-    return static_cast<std::uint32_t>(std::stoul(period()));
-}
+    otpauthURIView view;
+    if (!view.parse(uri))
+    {
+        return false;
+    }
 
-void otpauthURI::setTypeEnum(const std::string &type)
-{
-    if (type == "totp")
+    bool found = false;
+    const auto secret = view.param("secret", &found);
+    if (!found)
     {
-        _type = TOTP;
+        return false;
     }
-    else if (type == "hotp")
+
+    OTPToken::CounterType counter = 0U;
+    if (view.type() == otpauthURIView::HOTP && !parseNumber(view.param("counter"), counter))
     {
-        _type = HOTP;
+        return false;
     }
-    else
+
+    OTPToken::DigitType digits = 6U;
+    OTPToken::PeriodType period = view.type() == otpauthURIView::TOTP ? 30U : 0U;
+    if (view.hasParam("digits") && !parseNumber(view.param("digits"), digits))
     {
-        _type = Invalid;
+        return false;
+    }
+    if (view.hasParam("period") && !parseNumber(view.param("period"), period))
+    {
+        return false;
     }
-}
 
-otpauthURI::UriComponent::UriComponent(const std::string &uri, const std::string &prefix)
-    : prefix(prefix), uri(uri)
-{
-    if (uri.size() >= prefix.size() && uri.substr(0, prefix.size()) == prefix)
+    std::string label;
+    otpauthURIView::decode(view.label(), label);
+
+    target.setType(view.type() == otpauthURIView::HOTP ? OTPToken::HOTP : OTPToken::TOTP);
+    target.setLabel(label);
+    target.setSecret(std::string(secret));
+    target.setDigitLength(digits);
+    target.setPeriod(period);
+    target.setCounter(counter);
+
+    const auto algorithm = view.param("algorithm", &found);
+    if (found)
     {
-        this->uri = uri.substr(prefix.size());
+        target.setAlgorithm(std::string(algorithm));
     }
     else
     {
-        this->prefix.clear();
+        target.setAlgorithm(OTPToken::SHA1);
     }
+
+    return true;
 }
 
-otpauthURI::UriComponent::~UriComponent()
+std::uint8_t otpauthURI::digitsNumber() const
 {
-    prefix.clear();
-    uri.clear();
+    return static_cast<std::uint8_t>(std::stoul(digits()));
+}
+
+std::uint64_t otpauthURI::counterNumber() const
+{
+    return static_cast<std::uint64_t>(std::stoull(counter()));
 }
 
-const std::string otpauthURI::UriComponent::encoded() const
+std::uint32_t otpauthURI::periodNumber() const
 {
-    std::string new_str = "";
-    char c;
-    int ic;
-    const char *chars = uri.c_str();
-    char bufHex[10];
-    auto len = strlen(chars);
-
-    for (auto i = 0U; i < len; i++)
+    return static_cast<std::uint32_t>(std::stoul(period()));
+}
+
+std::vector<otpauthURI> otpauthURI::parseMany(const std::string_view &lines, const unsigned &threads)
+{
+    // index the lines first, parsing is independent per line
+    std::vector<std::string_view> views;
+    std::size_t pos = 0;
+    while (pos < lines.size())
     {
-        c = chars[i];
-        ic = c;
-//        if (c == ' ')
-//        {
-//            new_str += '+';
-//        }
-        if (isalnum(c) || c == '-' || c == '_' || c == '.' || c == '~')
+        auto end = lines.find('\n', pos);
+        if (end == std::string_view::npos)
         {
-            new_str += c;
+            end = lines.size();
         }
-        else
+
+        auto line = lines.substr(pos, end - pos);
+        if (!line.empty() && line.back() == '\r')
         {
-            std::sprintf(bufHex, "%X", c);
-            if (ic < 16)
-            {
-                new_str += "%0";
-            }
-            else
-            {
-                new_str += "%";
-            }
-            new_str += bufHex;
+            line.remove_suffix(1);
         }
+        if (!line.empty())
+        {
+            views.emplace_back(line);
+        }
+
+        pos = end + 1;
     }
-    return prefix + new_str;
+
+    std::vector<otpauthURI> uris(views.size());
+    ParallelFor::run(views.size(), [&](const std::size_t &i) {
+        uris[i] = otpauthURI(views[i]);
+    }, threads, 256);
+
+    return uris;
 }
 
-const std::string otpauthURI::UriComponent::decoded() const
+bool otpauthURI::parseFile(const std::string &file, std::vector<otpauthURI> &target, const unsigned &threads)
 {
-    std::string ret;
-    char ch;
-    unsigned int i, ii;
-    auto len = uri.length();
-
-    for (i = 0U; i < len; i++)
+    MappedFile input(file);
+    if (!input.valid())
     {
-        if (uri[i] != '%')
-        {
-            if (uri[i] == '+')
-            {
-                ret += ' ';
-            }
-            else
-            {
-                ret += uri[i];
-            }
-        }
-        else
-        {
-            std::sscanf(uri.substr(i + 1, 2).c_str(), "%x", &ii);
-            ch = static_cast<char>(ii);
-            ret += ch;
-            i = i + 2;
-        }
+        return false;
     }
-    return prefix + ret;
+
+    auto uris = parseMany(input.view(), threads);
+    target.reserve(target.size() + uris.size());
+    std::move(uris.begin(), uris.end(), std::back_inserter(target));
+    return true;
 }
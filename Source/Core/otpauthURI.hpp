@@ -3,6 +3,10 @@
 
 #include <map>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include "SecureAllocator.hpp"
 
 /**
  * otpauth URI
@@ -34,16 +38,30 @@ class OTPToken;
 
 class otpauthURI
 {
-    class UriComponent;
-
 public:
     otpauthURI();
-    otpauthURI(const std::string &uri);
+    otpauthURI(const std::string_view &uri);
     ~otpauthURI();
 
     static otpauthURI fromOtpToken(const OTPToken *token);
 
-    inline const std::string to_s() const
+    // appends the URI of the token to target, which can be reused between calls;
+    // returns false for token types which can't be represented
+    static bool write(const OTPToken &token, std::string &target);
+    static bool write(const OTPToken &token, SecureString &target);
+
+    // parses the URI straight into target without building an otpauthURI,
+    // returns false when the URI is invalid, target is unchanged in that case
+    static bool read(const std::string_view &uri, OTPToken &target);
+
+    // parses newline-separated URIs across all cores, empty lines are skipped;
+    // the result has one entry per non-empty line in input order, invalid
+    // lines are kept as invalid URIs so that callers can report them
+    static std::vector<otpauthURI> parseMany(const std::string_view &lines, const unsigned &threads = 0);
+    // same as above, reads the URIs from a file
+    static bool parseFile(const std::string &file, std::vector<otpauthURI> &target, const unsigned &threads = 0);
+
+    inline std::string to_s() const
     {
         if (this->valid())
         {
@@ -85,7 +103,7 @@ public:
             return empty;
         }
     }
-    std::uint32_t counterNumber() const;
+    std::uint64_t counterNumber() const;
 
     inline const std::string &period() const
     {
@@ -118,23 +136,6 @@ private:
     Type _type = Invalid;
     std::string _label;
     std::map<std::string, std::string> _params;
-
-    void setTypeEnum(const std::string &type);
-
-    // helper class to decode and encode URI components (percent signs)
-    class UriComponent
-    {
-    public:
-        UriComponent(const std::string &uri, const std::string &prefix = OTPAUTH_PREFIX);
-        ~UriComponent();
-
-        const std::string encoded() const;
-        const std::string decoded() const;
-
-    private:
-        std::string prefix;
-        std::string uri;
-    };
 };
 
 #endif // OTPAUTHURI_HPP
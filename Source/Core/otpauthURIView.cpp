@@ -0,0 +1,169 @@
+#include "otpauthURIView.hpp"
+
+#include <cstdint>
+
+namespace {
+    // hex digit -> value, -1 for all other characters
+    struct HexTable {
+        std::int8_t values[256];
+
+        constexpr HexTable() : values()
+        {
+            for (auto i = 0; i < 256; ++i)
+            {
+                values[i] = -1;
+            }
+            for (auto i = 0; i < 10; ++i)
+            {
+                values['0' + i] = static_cast<std::int8_t>(i);
+            }
+            for (auto i = 0; i < 6; ++i)
+            {
+                values['a' + i] = static_cast<std::int8_t>(10 + i);
+                values['A' + i] = static_cast<std::int8_t>(10 + i);
+            }
+        }
+    };
+
+    // unreserved characters of RFC 3986
+    struct UnreservedTable {
+        bool values[256];
+
+        constexpr UnreservedTable() : values()
+        {
+            for (auto i = 0; i < 256; ++i)
+            {
+                values[i] = (i >= 'a' && i <= 'z') || (i >= 'A' && i <= 'Z') || (i >= '0' && i <= '9') ||
+                            i == '-' || i == '_' || i == '.' || i == '~';
+            }
+        }
+    };
+
+    static constexpr HexTable hexTable;
+    static constexpr UnreservedTable unreservedTable;
+    static constexpr char hexDigits[] = "0123456789ABCDEF";
+}
+
+bool otpauthURIView::parse(const std::string_view &uri)
+{
+    *this = otpauthURIView();
+
+    if (uri.size() < prefix.size() || uri.compare(0, prefix.size(), prefix) != 0)
+    {
+        return false;
+    }
+
+    this->_uri = uri.substr(prefix.size());
+    const auto &str = this->_uri;
+
+    // type
+    auto delim = str.find('/');
+    const auto type = str.substr(0, delim);
+    if (type == "totp")
+    {
+        this->_type = TOTP;
+    }
+    else if (type == "hotp")
+    {
+        this->_type = HOTP;
+    }
+
+    if (delim == std::string_view::npos || this->_type == Invalid)
+    {
+        return false;
+    }
+
+    // label
+    const auto query = str.find('?', ++delim);
+    this->_label = str.substr(delim, query == std::string_view::npos ? std::string_view::npos : query - delim);
+    if (query == std::string_view::npos)
+    {
+        return false;
+    }
+
+    // parameters, key=value pairs separated by '&'
+    auto pos = query + 1;
+    while (pos < str.size())
+    {
+        auto end = str.find('&', pos);
+        if (end == std::string_view::npos)
+        {
+            end = str.size();
+        }
+
+        const auto pair = str.substr(pos, end - pos);
+        const auto eq = pair.find('=');
+        if (eq != std::string_view::npos && this->_paramCount < MaxParams)
+        {
+            this->_params[this->_paramCount++] = {pair.substr(0, eq), pair.substr(eq + 1)};
+        }
+        else if (eq != std::string_view::npos)
+        {
+            this->_overflow.push_back({pair.substr(0, eq), pair.substr(eq + 1)});
+            ++this->_paramCount;
+        }
+
+        pos = end + 1;
+    }
+
+    return this->_paramCount != 0;
+}
+
+std::string_view otpauthURIView::param(const std::string_view &key, bool *found) const
+{
+    for (auto i = 0U; i < this->_paramCount; ++i)
+    {
+        const auto &p = this->paramAt(i);
+        if (p.key == key)
+        {
+            if (found) (*found) = true;
+            return p.value;
+        }
+    }
+
+    if (found) (*found) = false;
+    return {};
+}
+
+void otpauthURIView::decode(const std::string_view &in, std::string &out)
+{
+    out.reserve(out.size() + in.size());
+
+    for (std::size_t i = 0; i < in.size(); ++i)
+    {
+        const auto c = in[i];
+        if (c == '%' && i + 2 < in.size())
+        {
+            const auto hi = hexTable.values[static_cast<unsigned char>(in[i + 1])];
+            const auto lo = hexTable.values[static_cast<unsigned char>(in[i + 2])];
+            if (hi >= 0 && lo >= 0)
+            {
+                out.push_back(static_cast<char>((hi << 4) | lo));
+                i += 2;
+                continue;
+            }
+        }
+
+        out.push_back(c == '+' ? ' ' : c);
+    }
+}
+
+void otpauthURIView::encode(const std::string_view &in, std::string &out)
+{
+    out.reserve(out.size() + in.size());
+
+    for (const auto c : in)
+    {
+        const auto uc = static_cast<unsigned char>(c);
+        if (unreservedTable.values[uc])
+        {
+            out.push_back(c);
+        }
+        else
+        {
+            out.push_back('%');
+            out.push_back(hexDigits[uc >> 4]);
+            out.push_back(hexDigits[uc & 0x0F]);
+        }
+    }
+}
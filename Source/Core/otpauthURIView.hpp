@@ -0,0 +1,90 @@
+#ifndef OTPAUTHURIVIEW_HPP
+#define OTPAUTHURIVIEW_HPP
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * Non-owning, single-pass otpauth URI parser.
+ *
+ * All members are views into the parsed string, which must outlive the view.
+ * Nothing is allocated during parsing of common URIs: the first MaxParams
+ * parameters are kept in a fixed array, only further parameters are stored
+ * in a vector.
+ *
+ * The label and parameter values are not decoded, use decode() to append
+ * the percent-decoded form to a (reused) buffer.
+ *
+ * See otpauthURI for the owning wrapper with defaults and validation.
+ */
+class otpauthURIView final
+{
+public:
+    enum Type {
+        Invalid = -1,
+        TOTP,
+        HOTP,
+    };
+
+    struct Param {
+        std::string_view key;
+        std::string_view value;
+    };
+
+    static constexpr std::size_t MaxParams = 16;
+
+    otpauthURIView() = default;
+
+    // returns false when the uri is not a syntactically valid otpauth URI;
+    // the members are still set as far as parsing succeeded
+    bool parse(const std::string_view &uri);
+
+    // uri without the "otpauth://" prefix
+    inline const std::string_view &uri() const
+    { return this->_uri; }
+
+    inline const Type &type() const
+    { return this->_type; }
+
+    // percent-encoded label
+    inline const std::string_view &label() const
+    { return this->_label; }
+
+    inline std::size_t paramCount() const
+    { return this->_paramCount; }
+    inline const Param &paramAt(const std::size_t &index) const
+    { return index < MaxParams ? this->_params[index] : this->_overflow[index - MaxParams]; }
+
+    // value of the first parameter with the given key,
+    // found is set to false when the parameter doesn't exist
+    std::string_view param(const std::string_view &key, bool *found = nullptr) const;
+    inline bool hasParam(const std::string_view &key) const
+    {
+        bool found = false;
+        param(key, &found);
+        return found;
+    }
+
+    // append the percent-decoded input to out, '+' is decoded as space,
+    // malformed escape sequences are copied as-is
+    static void decode(const std::string_view &in, std::string &out);
+
+    // append the percent-encoded input to out, only unreserved characters
+    // (RFC 3986) are kept as-is
+    static void encode(const std::string_view &in, std::string &out);
+
+    static constexpr std::string_view prefix = "otpauth://";
+
+private:
+    std::string_view _uri;
+    Type _type = Invalid;
+    std::string_view _label;
+    std::array<Param, MaxParams> _params;
+    std::vector<Param> _overflow;
+    std::size_t _paramCount = 0;
+};
+
+#endif // OTPAUTHURIVIEW_HPP
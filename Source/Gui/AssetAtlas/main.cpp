@@ -0,0 +1,136 @@
+// Build time tool: renders the GUI assets at the common icon sizes and
+// device pixel ratios into a single PNG atlas.
+//
+// usage: otpgen-assetatlas <atlas.png> <atlas.index> <asset>...
+//
+// Every line of the index describes one rendering:
+//   <asset file name> <logical size> <device pixel ratio> <x> <y> <width> <height>
+
+#include <QGuiApplication>
+#include <QFileInfo>
+#include <QImage>
+#include <QImageReader>
+#include <QPainter>
+#include <QSaveFile>
+#include <QTextStream>
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+static const int sizes[] = {16, 24, 32};
+static const int scales[] = {1, 2};
+static const int atlasWidth = 1024;
+
+struct Rendering
+{
+    QString name;
+    int size;
+    int scale;
+    QImage image;
+    QPoint pos;
+};
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        std::fprintf(stderr, "usage: %s <atlas.png> <atlas.index> <asset>...\n", argv[0]);
+        return 1;
+    }
+
+    // no display is needed for rendering into images
+    qputenv("QT_QPA_PLATFORM", "offscreen");
+    QGuiApplication app(argc, argv);
+
+    std::vector<Rendering> renderings;
+    for (auto i = 3; i < argc; ++i)
+    {
+        const auto path = QString::fromLocal8Bit(argv[i]);
+
+        for (auto&& size : sizes)
+        {
+            for (auto&& scale : scales)
+            {
+                QImageReader reader(path);
+                const auto natural = reader.size();
+                const auto target = natural.isValid() ? natural.scaled(size, size, Qt::KeepAspectRatio) : QSize(size, size);
+                reader.setScaledSize(target * scale);
+
+                const auto image = reader.read();
+                if (image.isNull())
+                {
+                    // the application falls back to the runtime renderer for missing entries
+                    std::fprintf(stderr, "warning: unable to render %s: %s\n",
+                                 argv[i], reader.errorString().toLocal8Bit().constData());
+                    continue;
+                }
+
+                renderings.push_back({QFileInfo(path).fileName(), size, scale,
+                                      image.convertToFormat(QImage::Format_ARGB32_Premultiplied), QPoint()});
+            }
+        }
+    }
+
+    // an empty atlas means the image plugins are missing (e.g. no SVG plugin in static builds)
+    if (renderings.empty() && argc > 3)
+    {
+        std::fprintf(stderr, "error: none of the assets could be rendered\n");
+        return 3;
+    }
+
+    // shelf packing, renderings of the same height share a row
+    std::stable_sort(renderings.begin(), renderings.end(), [](const Rendering &a, const Rendering &b) {
+        return a.image.height() < b.image.height();
+    });
+
+    auto x = 0, y = 0, rowHeight = 0;
+    for (auto&& rendering : renderings)
+    {
+        const auto size = rendering.image.size();
+        if (x + size.width() > atlasWidth || (rowHeight != 0 && size.height() != rowHeight))
+        {
+            x = 0;
+            y += rowHeight;
+            rowHeight = 0;
+        }
+        rendering.pos = QPoint(x, y);
+        x += size.width();
+        rowHeight = std::max(rowHeight, size.height());
+    }
+
+    QImage atlas(atlasWidth, std::max(1, y + rowHeight), QImage::Format_ARGB32_Premultiplied);
+    atlas.fill(Qt::transparent);
+
+    QString index;
+    QTextStream stream(&index);
+    {
+        QPainter painter(&atlas);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        for (auto&& rendering : renderings)
+        {
+            painter.drawImage(rendering.pos, rendering.image);
+            stream << rendering.name << ' ' << rendering.size << ' ' << rendering.scale << ' '
+                   << rendering.pos.x() << ' ' << rendering.pos.y() << ' '
+                   << rendering.image.width() << ' ' << rendering.image.height() << '\n';
+        }
+    }
+    stream.flush();
+
+    QSaveFile png(QString::fromLocal8Bit(argv[1]));
+    if (!png.open(QIODevice::WriteOnly) || !atlas.save(&png, "PNG") || !png.commit())
+    {
+        std::fprintf(stderr, "error: unable to write %s\n", argv[1]);
+        return 2;
+    }
+
+    QSaveFile text(QString::fromLocal8Bit(argv[2]));
+    if (!text.open(QIODevice::WriteOnly) || text.write(index.toUtf8()) < 0 || !text.commit())
+    {
+        std::fprintf(stderr, "error: unable to write %s\n", argv[2]);
+        return 2;
+    }
+
+    std::printf("asset atlas: %zu renderings, %dx%d\n", renderings.size(), atlas.width(), atlas.height());
+    return 0;
+}
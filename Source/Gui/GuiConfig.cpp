@@ -22,6 +22,9 @@ bool GuiConfig::startMinimizedToTray()
     }
 }
 
+bool GuiConfig::keychainStoresKey()
+{ return settings()->value(keyKeychainStoresKey(), true).toBool(); }
+
 bool GuiConfig::useTheming()
 { return settings()->value(keyUseTheming(), true).toBool(); }
 
@@ -65,6 +68,12 @@ const QString &GuiConfig::path()
     return location;
 }
 
+const QString &GuiConfig::iconCache()
+{
+    static const auto location = path() + "/icon-cache";
+    return location;
+}
+
 const std::string &GuiConfig::database()
 {
 #ifdef OTPGEN_DEBUG
@@ -81,6 +90,10 @@ void GuiConfig::initDefaultSettings()
     {
         settings()->setValue(keyStartMinimizedToTray(), false);
     }
+    if (!settingsHasKey(keyKeychainStoresKey()))
+    {
+        settings()->setValue(keyKeychainStoresKey(), true);
+    }
     if (!settingsHasKey(keyUseTheming()))
     {
         settings()->setValue(keyUseTheming(), true);
@@ -12,6 +12,9 @@ public:
 
     static bool startMinimizedToTray();
 
+    // store the derived database key in the keychain instead of the password
+    static bool keychainStoresKey();
+
     static bool useTheming();
 
     static const QString iconColor();
@@ -24,6 +27,7 @@ public:
     static QSettings *settings();
     static const QString &path();
     static const std::string &database();
+    static const QString &iconCache();
 
     // QSettings keys
     static const QString keyGeometryMainWindow()
@@ -42,6 +46,8 @@ public:
     { return "UI/MinimizeToTrayOnStart"; }
     static const QString keyUseTheming()
     { return "UI/Theming"; }
+    static const QString keyKeychainStoresKey()
+    { return "Security/KeychainStoresKey"; }
     static const QString keyIconColor()
     { return "UI/IconColor"; }
     static const QString keyTitleBarBackground()
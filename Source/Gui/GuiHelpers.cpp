@@ -2,13 +2,18 @@
 
 #include "GuiConfig.hpp"
 
-#include <Tools/zlibTool.hpp>
-#include <Tools/SvgTool.hpp>
+#include <Tools/IconCache.hpp>
 
 #include <QScreen>
+#include <QFileInfo>
 
 GuiHelpers::GuiHelpers()
 {
+    // rendered icons of another version or icon color are stale
+    IconCache::setTheme(QString("%1;%2").arg(qApp->applicationVersion(), gcfg::iconColor()));
+
+    loadAtlas();
+
     _app_icon = QIcon(":/app-icon.svgz");
     _tray_icon = QIcon(":/tray-icon.png");
 
@@ -19,14 +24,16 @@ GuiHelpers::GuiHelpers()
 
     _add_icon = loadIcon(":/add.svgz");
     _remove_icon = loadIcon(":/remove.svgz");
-    _delete_icon = QIcon(":/close.svgz");
+    _delete_icon = defaultIcon(":/close.svgz");
     _save_icon = loadIcon(":/save.svgz");
     _import_icon = loadIcon(":/import.svgz");
     _export_icon = loadIcon(":/export.svgz");
-    _qr_code_icon = QIcon(":/qr-code.svgz");
-    _copy_content_icon = QIcon(":/copy-content.svgz");
+    _qr_code_icon = defaultIcon(":/qr-code.svgz");
+    _copy_content_icon = defaultIcon(":/copy-content.svgz");
     _edit_icon = loadIcon(":/pencil-edit-button.svgz");
     _info_icon = loadIcon(":/info.svgz");
+
+    releaseAtlas();
 }
 
 const QIcon GuiHelpers::loadIcon(const QString &path)
@@ -34,24 +41,62 @@ const QIcon GuiHelpers::loadIcon(const QString &path)
     const auto color = gcfg::iconColor();
     if (color.compare("default", Qt::CaseInsensitive) == 0)
     {
-        return QIcon(path);
+        return defaultIcon(path);
     }
     else
     {
         QFile file(path);
         file.open(QIODevice::ReadOnly);
-        auto buf = file.readAll();
+        const auto buf = file.readAll();
         file.close();
 
-        auto svg = zlibTool::uncompress(buf.constData(), buf.size());
-        SvgTool::changeFillColor(svg, color.toUtf8().constData());
+        return QIcon(IconCache::pixmap(buf, QSize(), QColor(color), qApp->devicePixelRatio(), IconCache::MemoryAndDisk));
+    }
+}
+
+const QIcon GuiHelpers::defaultIcon(const QString &path)
+{
+    // every rendering of the asset from the atlas, the SVG is only
+    // rendered at runtime for sizes missing from the atlas
+    QIcon icon(path);
+    for (auto&& entry : _atlasIndex.values(QFileInfo(path).fileName()))
+    {
+        auto pixmap = QPixmap::fromImage(_atlas.copy(entry.rect));
+        pixmap.setDevicePixelRatio(entry.scale);
+        icon.addPixmap(pixmap);
+    }
+    return icon;
+}
+
+void GuiHelpers::loadAtlas()
+{
+    // lines: <name> <logical size> <pixel ratio> <x> <y> <width> <height>
+    QFile index(":/atlas.index");
+    if (!index.open(QIODevice::ReadOnly) || !_atlas.load(":/atlas.png", "PNG"))
+    {
+        return;
+    }
 
-        QPixmap pixmap;
-        pixmap.loadFromData(reinterpret_cast<const unsigned char*>(svg.data()), static_cast<uint>(svg.size()));
-        return QIcon(pixmap);
+    for (auto&& line : index.readAll().split('\n'))
+    {
+        const auto fields = line.split(' ');
+        if (fields.size() != 7)
+        {
+            continue;
+        }
+        _atlasIndex.insert(QString::fromUtf8(fields.at(0)), {
+            QRect(fields.at(3).toInt(), fields.at(4).toInt(), fields.at(5).toInt(), fields.at(6).toInt()),
+            fields.at(2).toInt()
+        });
     }
 }
 
+void GuiHelpers::releaseAtlas()
+{
+    _atlas = QImage();
+    _atlasIndex.clear();
+}
+
 GuiHelpers *GuiHelpers::i()
 {
     static const std::shared_ptr<GuiHelpers> instance(new GuiHelpers());
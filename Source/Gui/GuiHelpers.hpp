@@ -15,6 +15,9 @@
 #include <QAction>
 
 #include <QList>
+#include <QHash>
+#include <QImage>
+#include <QRect>
 
 #include <WidgetHelpers/FramelessContainer.hpp>
 #include <WidgetHelpers/TitleBar.hpp>
@@ -90,6 +93,18 @@ private:
     GuiHelpers();
 
     const QIcon loadIcon(const QString &path);
+    const QIcon defaultIcon(const QString &path);
+
+    // assets pre-rendered at build time, only kept while the icons are loaded
+    void loadAtlas();
+    void releaseAtlas();
+
+    struct AtlasEntry {
+        QRect rect;
+        int scale;
+    };
+    QImage _atlas;
+    QMultiHash<QString, AtlasEntry> _atlasIndex;
 
     QIcon _app_icon;
     QIcon _tray_icon;
@@ -0,0 +1,401 @@
+#include "TokenTableModel.hpp"
+
+#include <Tools/IconCache.hpp>
+
+#include <TokenDatabase.hpp>
+
+#include <QByteArray>
+#include <QGuiApplication>
+
+#include <algorithm>
+
+const std::size_t TokenTableModel::FetchSize;
+
+TokenTableModel::TokenTableModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+    this->now = std::time(nullptr);
+
+    // the view announces the visible rows again after every reset
+    QObject::connect(this, &QAbstractItemModel::modelAboutToBeReset, this, [this]{
+        this->windowFirst = this->windowEnd = 0;
+        this->publisher.setTable(TokenTable());
+    });
+    this->publisher.start();
+
+    this->reload();
+}
+
+void TokenTableModel::reload()
+{
+    this->beginResetModel();
+
+    this->clearRows();
+
+    // tokenCount() returns an error code when the database isn't open
+    this->total = TokenDatabase::databaseConnected() ? static_cast<std::size_t>(TokenDatabase::tokenCount()) : 0U;
+    this->table.reserve(this->total);
+
+    // views fetch the first rows when they need them
+    if (!this->filterText.isEmpty())
+    {
+        this->selectFilteredRows();
+    }
+
+    this->endResetModel();
+}
+
+void TokenTableModel::release()
+{
+    this->beginResetModel();
+    this->clearRows();
+    this->total = 0;
+    this->endResetModel();
+}
+
+void TokenTableModel::setFilter(const QString &filter)
+{
+    if (filter == this->filterText)
+    {
+        return;
+    }
+
+    this->beginResetModel();
+
+    this->filterText = filter;
+    this->filterIds.clear();
+    this->filterTable.clear();
+    if (!filter.isEmpty())
+    {
+        this->selectFilteredRows();
+    }
+
+    // icon handles belong to the table
+    this->icons.clear();
+    this->warmedIcons = this->rows().iconCount();
+    this->fetched = this->rows().size();
+
+    this->endResetModel();
+}
+
+void TokenTableModel::setTime(const std::time_t &time)
+{
+    // no dataChanged(), see class comment
+    this->now = time;
+}
+
+void TokenTableModel::setIconSize(const QSize &size)
+{
+    if (size == this->decorationSize)
+    {
+        return;
+    }
+
+    this->decorationSize = size;
+    this->icons.clear();
+
+    if (this->rowCount() > 0)
+    {
+        emit dataChanged(this->index(0, IconColumn), this->index(this->rowCount() - 1, IconColumn), {Qt::DecorationRole});
+    }
+}
+
+void TokenTableModel::setVisibleRows(const int &first, const int &last)
+{
+    const auto begin = std::max(0, first);
+    const auto end = std::max(begin, std::min(this->rowCount(), last + 1));
+    if (begin == this->windowFirst && end == this->windowEnd)
+    {
+        return;
+    }
+
+    TokenTable window;
+    window.reserve(static_cast<std::size_t>(end - begin));
+    for (auto row = begin; row < end; ++row)
+    {
+        window.append(this->rows(), static_cast<TokenTable::Index>(row));
+    }
+
+    this->windowFirst = begin;
+    this->windowEnd = end;
+    this->publisher.setTable(std::move(window));
+}
+
+OTPToken::TokenString TokenTableModel::publishedCode(const OTPToken::sqliteTokenID &id) const
+{
+    const auto snapshot = this->publisher.read();
+    if (!snapshot || !snapshot->table)
+    {
+        return {};
+    }
+
+    const auto now = std::time(nullptr);
+    for (TokenTable::Index row = 0; row < snapshot->size(); ++row)
+    {
+        // counter based codes change when they are used
+        if (snapshot->table->id(row) == id && snapshot->expires[row] > now)
+        {
+            return snapshot->codes[row];
+        }
+    }
+    return {};
+}
+
+void TokenTableModel::setCounter(const OTPToken::sqliteTokenID &id, const OTPToken::CounterType &counter)
+{
+    // the token can be fetched into both tables
+    for (auto table : {&this->table, &this->filterTable})
+    {
+        for (TokenTable::Index row = 0; row < table->size(); ++row)
+        {
+            if (table->id(row) == id)
+            {
+                table->setCounter(row, counter);
+                break;
+            }
+        }
+    }
+
+    // the published window holds a copy of the rows
+    const auto first = this->windowFirst;
+    const auto last = this->windowEnd - 1;
+    this->windowFirst = this->windowEnd = 0;
+    this->setVisibleRows(first, last);
+
+    if (this->rowCount() > 0)
+    {
+        emit dataChanged(this->index(0, CodeColumn), this->index(this->rowCount() - 1, CodeColumn), {Qt::DisplayRole});
+    }
+}
+
+OTPToken::sqliteTokenID TokenTableModel::tokenId(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.row() >= this->rowCount())
+    {
+        return 0U;
+    }
+    return this->rows().id(static_cast<TokenTable::Index>(index.row()));
+}
+
+int TokenTableModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+    return static_cast<int>(this->fetched);
+}
+
+int TokenTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant TokenTableModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= this->rowCount())
+    {
+        return QVariant();
+    }
+
+    const auto &rows = this->rows();
+    const auto row = static_cast<TokenTable::Index>(index.row());
+
+    switch (index.column())
+    {
+        case IconColumn:
+            if (role == Qt::DecorationRole && rows.iconHandle(row) != TokenTable::NoIcon)
+            {
+                return this->icon(rows.iconHandle(row));
+            }
+            break;
+
+        case LabelColumn:
+            if (role == Qt::DisplayRole || role == Qt::ToolTipRole)
+            {
+                const auto label = rows.label(row);
+                return QString::fromUtf8(label.data(), static_cast<int>(label.size()));
+            }
+            break;
+
+        case CodeColumn:
+            if (role == Qt::DisplayRole)
+            {
+                const auto code = this->code(index.row());
+                return QString::fromLatin1(code.data(), static_cast<int>(code.size()));
+            }
+            else if (role == Qt::TextAlignmentRole)
+            {
+                return static_cast<int>(Qt::AlignCenter);
+            }
+            break;
+
+        case RemainingColumn:
+            if (role == Qt::DisplayRole)
+            {
+                // counter based tokens don't expire
+                const auto remaining = rows.remainingValidity(row, this->now);
+                return remaining == 0 ? QString() : QString::number(static_cast<qulonglong>(remaining)) + "s";
+            }
+            else if (role == Qt::TextAlignmentRole)
+            {
+                return static_cast<int>(Qt::AlignRight | Qt::AlignVCenter);
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return QVariant();
+}
+
+QVariant TokenTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+    {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    switch (section)
+    {
+        case LabelColumn:     return QObject::tr("Label");
+        case CodeColumn:      return QObject::tr("Code");
+        case RemainingColumn: return QObject::tr("Remaining");
+        default:              return QVariant();
+    }
+}
+
+bool TokenTableModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && this->rows().size() < this->available();
+}
+
+void TokenTableModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid())
+    {
+        return;
+    }
+    this->fetch(FetchSize);
+}
+
+void TokenTableModel::clearRows()
+{
+    this->table.clear();
+    this->filterTable.clear();
+    this->filterIds.clear();
+    this->fetched = 0;
+    this->icons.clear();
+    this->warmedIcons = 0;
+}
+
+void TokenTableModel::selectFilteredRows()
+{
+    if (TokenDatabase::databaseConnected())
+    {
+        TokenDatabase::selectTokenIds(this->filterIds, this->filterText.toUtf8().toStdString());
+    }
+    this->filterTable.reserve(this->filterIds.size());
+}
+
+std::size_t TokenTableModel::available() const
+{
+    return this->filterText.isEmpty() ? this->total : this->filterIds.size();
+}
+
+void TokenTableModel::fetch(const std::size_t &count)
+{
+    auto &rows = this->rows();
+    const auto offset = rows.size();
+    const auto available = this->available();
+    if (count == 0 || offset >= available)
+    {
+        return;
+    }
+
+    const auto append = [&](const OTPToken &token) {
+        rows.append(token);
+    };
+
+    auto status = TokenDatabase::Success;
+    if (this->filterText.isEmpty())
+    {
+        status = TokenDatabase::forEachToken(append, offset, count);
+    }
+    else
+    {
+        const auto first = this->filterIds.cbegin() + static_cast<std::ptrdiff_t>(offset);
+        const auto last = first + static_cast<std::ptrdiff_t>(std::min(count, available - offset));
+        status = TokenDatabase::forEachToken(append, TokenDatabase::DisplayOrder(first, last));
+    }
+
+    // stop fetching when the database is shorter than announced
+    if (status != TokenDatabase::Success || rows.size() - offset < std::min(count, available - offset))
+    {
+        if (this->filterText.isEmpty())
+        {
+            this->total = rows.size();
+        }
+        else
+        {
+            this->filterIds.resize(rows.size());
+        }
+    }
+
+    // render the icons new to this page in the background, handles are sequential
+    QList<QByteArray> pending;
+    for (auto handle = static_cast<TokenTable::IconHandle>(this->warmedIcons + 1); handle <= rows.iconCount(); ++handle)
+    {
+        const auto &data = rows.icon(handle);
+        pending.append(QByteArray(reinterpret_cast<const char*>(data.data()), static_cast<int>(data.size())));
+    }
+    this->warmedIcons = rows.iconCount();
+    if (!pending.isEmpty())
+    {
+        IconCache::warm(pending, this->decorationSize, QColor(), qGuiApp->devicePixelRatio(), IconCache::MemoryOnly);
+    }
+
+    if (rows.size() > this->fetched)
+    {
+        this->beginInsertRows(QModelIndex(), static_cast<int>(this->fetched), static_cast<int>(rows.size() - 1));
+        this->fetched = rows.size();
+        this->endInsertRows();
+    }
+}
+
+OTPToken::TokenString TokenTableModel::code(const int &row) const
+{
+    const auto &rows = this->rows();
+    const auto tableRow = static_cast<TokenTable::Index>(row);
+
+    // visible rows are served from the snapshot until their code expires
+    const auto snapshot = this->publisher.read();
+    if (snapshot && snapshot->table && row >= this->windowFirst &&
+        static_cast<std::size_t>(row - this->windowFirst) < snapshot->size())
+    {
+        const auto published = static_cast<TokenTable::Index>(row - this->windowFirst);
+        if (snapshot->table->id(published) == rows.id(tableRow) &&
+            (snapshot->expires[published] == 0 || snapshot->expires[published] > this->now))
+        {
+            return snapshot->codes[published];
+        }
+    }
+
+    // rows outside of the window, or the worker didn't catch up with a rollover yet
+    return rows.generate(tableRow, this->now);
+}
+
+const QPixmap &TokenTableModel::icon(const TokenTable::IconHandle &handle) const
+{
+    // looked up once per distinct icon, the icon cache keeps rendered
+    // pixmaps across reloads and restarts
+    auto it = this->icons.find(handle);
+    if (it == this->icons.end())
+    {
+        const auto &data = this->rows().icon(handle);
+        const auto raw = QByteArray::fromRawData(reinterpret_cast<const char*>(data.data()), static_cast<int>(data.size()));
+        it = this->icons.insert(handle, IconCache::pixmap(raw, this->decorationSize, QColor(), qGuiApp->devicePixelRatio(), IconCache::MemoryOnly));
+    }
+    return it.value();
+}
@@ -0,0 +1,125 @@
+#ifndef TOKENTABLEMODEL_HPP
+#define TOKENTABLEMODEL_HPP
+
+#include <QAbstractTableModel>
+#include <QHash>
+#include <QPixmap>
+#include <QSize>
+
+#include <TokenTable.hpp>
+#include <TokenDatabase.hpp>
+#include <CodePublisher.hpp>
+
+#include <ctime>
+#include <vector>
+
+/**
+ * Table model of the token database for the token view.
+ *
+ * Rows are fetched lazily in display order with canFetchMore()/fetchMore()
+ * into a TokenTable, so decoded keys and labels are stored once and without
+ * per token objects. Codes are only computed for the rows the view shows
+ * (setVisibleRows()): a CodePublisher keeps them current on a worker thread
+ * and data() reads the published snapshot.
+ *
+ * The code and countdown columns depend on the time set with setTime(),
+ * no dataChanged() is emitted for them when the time changes. Views repaint
+ * these columns themselves (see TokenView), which avoids signalling every
+ * row every second.
+ */
+class TokenTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        IconColumn = 0,
+        LabelColumn,
+        CodeColumn,
+        RemainingColumn,
+
+        ColumnCount
+    };
+
+    // rows read from the database per fetchMore()
+    static const std::size_t FetchSize = 256U;
+
+    explicit TokenTableModel(QObject *parent = nullptr);
+
+    // drops all fetched rows and starts over, call after the database changed
+    void reload();
+
+    // drops all rows without touching the database, call before it is reloaded
+    void release();
+
+    // case-insensitive label filter, the matching rows are selected by the
+    // database and fetched lazily like the unfiltered rows
+    void setFilter(const QString &filter);
+    inline const QString &filter() const
+    { return this->filterText; }
+
+    // time the codes are shown for
+    void setTime(const std::time_t &time);
+    inline const std::time_t &time() const
+    { return this->now; }
+
+    void setIconSize(const QSize &size);
+    inline const QSize &iconSize() const
+    { return this->decorationSize; }
+
+    // rows shown by the view, their codes are published
+    void setVisibleRows(const int &first, const int &last);
+
+    // published code of a token, empty when the token isn't visible
+    OTPToken::TokenString publishedCode(const OTPToken::sqliteTokenID &id) const;
+
+    // updates the counter of a token after a HOTP code was used
+    void setCounter(const OTPToken::sqliteTokenID &id, const OTPToken::CounterType &counter);
+
+    // database id of the token shown in a row
+    OTPToken::sqliteTokenID tokenId(const QModelIndex &index) const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+
+private:
+    void clearRows();
+    void fetch(const std::size_t &count);
+    void selectFilteredRows();
+
+    // the fetched rows of the unfiltered or the filtered list
+    inline const TokenTable &rows() const
+    { return this->filterText.isEmpty() ? this->table : this->filterTable; }
+    inline TokenTable &rows()
+    { return this->filterText.isEmpty() ? this->table : this->filterTable; }
+    std::size_t available() const;
+
+    OTPToken::TokenString code(const int &row) const;
+    const QPixmap &icon(const TokenTable::IconHandle &handle) const;
+
+    TokenTable table;
+    std::size_t total = 0;   // rows in the database
+    std::size_t fetched = 0; // rows of rows() announced to views
+
+    // ids of the tokens which match the filter in display order, fetched into filterTable
+    QString filterText;
+    TokenDatabase::DisplayOrder filterIds;
+    TokenTable filterTable;
+
+    // codes of the visible rows, snapshot row i is model row windowFirst + i
+    std::time_t now = 0;
+    CodePublisher publisher;
+    int windowFirst = 0;
+    int windowEnd = 0;
+
+    QSize decorationSize{32, 32};
+    mutable QHash<TokenTable::IconHandle, QPixmap> icons;
+    std::size_t warmedIcons = 0; // handles passed to IconCache::warm()
+};
+
+#endif // TOKENTABLEMODEL_HPP
@@ -0,0 +1,285 @@
+#include "IconCache.hpp"
+#include "zlibTool.hpp"
+
+#include "GuiConfig.hpp"
+
+#include <QBuffer>
+#include <QCache>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QImageReader>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QRunnable>
+#include <QSaveFile>
+#include <QThreadPool>
+
+#include <algorithm>
+#include <functional>
+
+namespace {
+    class Task : public QRunnable
+    {
+    public:
+        explicit Task(const std::function<void()> &function)
+            : function(function)
+        {
+        }
+
+        void run() override
+        {
+            function();
+        }
+
+    private:
+        std::function<void()> function;
+    };
+}
+
+// in-memory level, cost in kilobytes
+static QCache<QString, QPixmap> &memoryCache()
+{
+    static QCache<QString, QPixmap> cache(8 * 1024);
+    return cache;
+}
+
+// renders and disk writes, separate from the global pool so clear() can wait for them
+static QThreadPool &workers()
+{
+    static QThreadPool pool;
+    return pool;
+}
+
+// images rendered by warm() which weren't requested yet, outside of the LRU
+// cache so it's bounded on its own and only holds the last warmed size
+static QMutex warmedMutex;
+static QHash<QString, QImage> warmed;
+static int warmedCost = 0;
+static QSize warmedSize;
+static qreal warmedDpr = 0.0;
+static const int warmedLimit = 4 * 1024;
+
+// in kilobytes, same as the in-memory level
+static int imageCost(const QSize &size)
+{
+    return std::max(1, size.width() * size.height() * 4 / 1024);
+}
+
+static void writePng(const QString &path, const QImage &image)
+{
+    QDir().mkpath(gcfg::iconCache());
+
+    // concurrent readers never see partially written files
+    QSaveFile file(path);
+    if (file.open(QIODevice::WriteOnly) && image.save(&file, "PNG"))
+    {
+        file.commit();
+    }
+}
+
+QPixmap IconCache::pixmap(const QByteArray &data, const QSize &size, const QColor &color, qreal dpr, const Storage &storage)
+{
+    const auto id = key(data, size, color, dpr);
+
+    if (const auto cached = memoryCache().object(id))
+    {
+        return *cached;
+    }
+
+    QImage image;
+    {
+        QMutexLocker lock(&warmedMutex);
+        image = warmed.take(id);
+        if (!image.isNull())
+        {
+            warmedCost -= imageCost(image.size());
+        }
+    }
+
+    if (image.isNull() && storage == MemoryOnly)
+    {
+        image = render(data, size, color, dpr);
+    }
+    else if (image.isNull())
+    {
+        const auto path = file(id);
+        if (image.load(path, "PNG"))
+        {
+            image.setDevicePixelRatio(dpr);
+        }
+        else
+        {
+            image = render(data, size, color, dpr);
+            if (!image.isNull())
+            {
+                workers().start(new Task([path, image]{
+                    writePng(path, image);
+                }));
+            }
+        }
+    }
+
+    // failed renders are cached too, as null pixmaps
+    const auto pixmap = QPixmap::fromImage(image);
+    store(id, pixmap);
+    return pixmap;
+}
+
+void IconCache::warm(const QList<QByteArray> &data, const QSize &size, const QColor &color, qreal dpr, const Storage &storage)
+{
+    {
+        // images of a previous size or screen won't be requested anymore
+        QMutexLocker lock(&warmedMutex);
+        if (size != warmedSize || !qFuzzyCompare(dpr, warmedDpr))
+        {
+            warmed.clear();
+            warmedCost = 0;
+            warmedSize = size;
+            warmedDpr = dpr;
+        }
+    }
+
+    workers().start(new Task([data, size, color, dpr, storage]{
+        for (auto&& icon : data)
+        {
+            const auto id = key(icon, size, color, dpr);
+            const auto path = file(id);
+            if (storage == MemoryAndDisk && QFile::exists(path))
+            {
+                continue;
+            }
+
+            const auto image = render(icon, size, color, dpr);
+            if (image.isNull())
+            {
+                continue;
+            }
+            if (storage == MemoryAndDisk)
+            {
+                writePng(path, image);
+            }
+
+            // over the limit the remaining icons are rendered on request, tasks
+            // of a previous size don't fill the cache anymore
+            QMutexLocker lock(&warmedMutex);
+            const auto cost = imageCost(image.size());
+            if (size != warmedSize || !qFuzzyCompare(dpr, warmedDpr) ||
+                warmedCost + cost > warmedLimit || warmed.contains(id))
+            {
+                continue;
+            }
+            warmed.insert(id, image);
+            warmedCost += cost;
+        }
+    }));
+}
+
+void IconCache::setTheme(const QString &theme)
+{
+    // the format version drops caches of older versions, which also
+    // contained token icons
+    const auto current = QString("2;%1").arg(theme);
+
+    QFile marker(QDir(gcfg::iconCache()).filePath("theme"));
+    if (marker.open(QIODevice::ReadOnly) && QString::fromUtf8(marker.readAll()) == current)
+    {
+        return;
+    }
+    marker.close();
+
+    clear();
+
+    QDir().mkpath(gcfg::iconCache());
+    if (marker.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        marker.write(current.toUtf8());
+    }
+}
+
+void IconCache::setMemoryLimit(int kilobytes)
+{
+    memoryCache().setMaxCost(kilobytes);
+}
+
+void IconCache::clear()
+{
+    workers().waitForDone();
+
+    memoryCache().clear();
+    {
+        QMutexLocker lock(&warmedMutex);
+        warmed.clear();
+        warmedCost = 0;
+    }
+    QDir(gcfg::iconCache()).removeRecursively();
+}
+
+QString IconCache::key(const QByteArray &data, const QSize &size, const QColor &color, qreal dpr)
+{
+    return QString("%1-%2x%3-%4@%5").arg(
+        QString::fromLatin1(QCryptographicHash::hash(data, QCryptographicHash::Sha1).toHex()),
+        QString::number(size.width()),
+        QString::number(size.height()),
+        color.isValid() ? color.name(QColor::HexArgb).mid(1) : QString("none"),
+        QString::number(dpr));
+}
+
+QString IconCache::file(const QString &key)
+{
+    return gcfg::iconCache() + "/" + key + ".png";
+}
+
+QImage IconCache::render(const QByteArray &data, const QSize &size, const QColor &color, qreal dpr)
+{
+    auto bytes = data;
+
+    // svgz assets
+    if (bytes.size() > 2 && static_cast<unsigned char>(bytes.at(0)) == 0x1f && static_cast<unsigned char>(bytes.at(1)) == 0x8b)
+    {
+        bool ok = false;
+        const auto svg = zlibTool::uncompress(bytes.constData(), bytes.size(), &ok);
+        if (!ok)
+        {
+            return QImage();
+        }
+        bytes = QByteArray(svg.data(), static_cast<int>(svg.size()));
+    }
+
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::ReadOnly);
+    QImageReader reader(&buffer);
+
+    // vector images are rendered at the target resolution instead of being scaled
+    const auto natural = reader.size();
+    const auto logical = !size.isValid() ? natural :
+                         natural.isValid() ? natural.scaled(size, Qt::KeepAspectRatio) : size;
+    if (logical.isValid())
+    {
+        reader.setScaledSize(logical * dpr);
+    }
+
+    auto image = reader.read();
+    if (image.isNull())
+    {
+        return image;
+    }
+
+    if (color.isValid())
+    {
+        image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        QPainter painter(&image);
+        painter.setCompositionMode(QPainter::CompositionMode_SourceIn);
+        painter.fillRect(image.rect(), color);
+    }
+
+    image.setDevicePixelRatio(dpr);
+    return image;
+}
+
+void IconCache::store(const QString &key, const QPixmap &pixmap)
+{
+    memoryCache().insert(key, new QPixmap(pixmap), imageCost(pixmap.size()));
+}
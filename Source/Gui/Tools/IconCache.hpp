@@ -0,0 +1,65 @@
+#ifndef ICONCACHE_HPP
+#define ICONCACHE_HPP
+
+#include <QByteArray>
+#include <QColor>
+#include <QImage>
+#include <QList>
+#include <QPixmap>
+#include <QSize>
+#include <QString>
+
+/**
+ * Two level cache of rendered icons.
+ *
+ * Icons are keyed by the hash of their content, the logical size, the tint
+ * color and the device pixel ratio. Rendered pixmaps are kept in memory in
+ * a LRU cache. Bundled assets are also written as PNG to the disk cache in
+ * the config directory, so later starts skip decoding, SVG rendering and
+ * tinting. Token icons come from the encrypted database and are only kept
+ * in memory.
+ *
+ * Tinting fills all opaque pixels with the color, which matches recoloring
+ * every fill of the single color SVG assets without going through the DOM.
+ *
+ * Must be used from the GUI thread, warm() renders on a private thread pool.
+ */
+class IconCache final
+{
+    IconCache() = delete;
+
+public:
+    enum Storage {
+        MemoryOnly,    // token icons
+        MemoryAndDisk, // bundled assets
+    };
+
+    // renders image data (png, svg, svgz, ...) at the logical size, an invalid
+    // size keeps the natural size of the image, an invalid color doesn't tint
+    static QPixmap pixmap(const QByteArray &data, const QSize &size,
+                          const QColor &color = QColor(), qreal dpr = 1.0,
+                          const Storage &storage = MemoryOnly);
+
+    // renders the images on a background thread, following pixmap() calls
+    // with the same arguments don't render anymore
+    static void warm(const QList<QByteArray> &data, const QSize &size,
+                     const QColor &color = QColor(), qreal dpr = 1.0,
+                     const Storage &storage = MemoryOnly);
+
+    // both levels are dropped when the theme differs from the one the disk
+    // cache was written with
+    static void setTheme(const QString &theme);
+
+    // limit of the in-memory cache
+    static void setMemoryLimit(int kilobytes);
+
+    static void clear();
+
+private:
+    static QString key(const QByteArray &data, const QSize &size, const QColor &color, qreal dpr);
+    static QString file(const QString &key);
+    static QImage render(const QByteArray &data, const QSize &size, const QColor &color, qreal dpr);
+    static void store(const QString &key, const QPixmap &pixmap);
+};
+
+#endif // ICONCACHE_HPP
@@ -0,0 +1,64 @@
+#include "VaultLoader.hpp"
+
+#include <TokenDatabase.hpp>
+#include <SecureAllocator.hpp>
+
+static QString phaseStatus(const TokenDatabase::LoadPhase &phase)
+{
+    switch (phase)
+    {
+        case TokenDatabase::LoadReading:       return QObject::tr("Reading tokens...");
+        case TokenDatabase::LoadDecrypting:    return QObject::tr("Decrypting tokens...");
+        case TokenDatabase::LoadDeserializing: return QObject::tr("Loading tokens...");
+        case TokenDatabase::LoadMigrating:     return QObject::tr("Upgrading the database...");
+        case TokenDatabase::LoadValidating:    return QObject::tr("Validating the database...");
+    }
+    return QString();
+}
+
+VaultLoader::VaultLoader(QObject *parent)
+    : QObject(parent)
+{
+}
+
+VaultLoader::~VaultLoader()
+{
+    // the database can't be abandoned halfway through loading
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+}
+
+bool VaultLoader::load(std::string password)
+{
+    if (busy.exchange(true))
+    {
+        return false;
+    }
+
+    // the previous load already finished
+    if (worker.joinable())
+    {
+        worker.join();
+    }
+
+    worker = std::thread([this, password = std::move(password)]() mutable {
+        if (!password.empty())
+        {
+            emit progress(QObject::tr("Unlocking..."));
+            TokenDatabase::setPassword(password);
+            SecureArena::wipe(&password[0], password.size());
+            password.clear();
+        }
+
+        const auto status = TokenDatabase::loadTokens([this](const TokenDatabase::LoadPhase &phase) {
+            emit progress(phaseStatus(phase));
+        });
+
+        busy = false;
+        emit finished(static_cast<int>(status));
+    });
+
+    return true;
+}
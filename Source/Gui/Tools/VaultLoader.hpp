@@ -0,0 +1,45 @@
+#ifndef VAULTLOADER_HPP
+#define VAULTLOADER_HPP
+
+#include <QObject>
+#include <QString>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+/**
+ * Unlocks and loads the token database on a worker thread.
+ *
+ * Password hashing, key derivation, decryption, deserialization and schema
+ * validation all run on the worker, the GUI thread keeps painting. Progress
+ * and the result are delivered as queued signals on the GUI thread.
+ *
+ * The token database must not be used by other threads until finished()
+ * was received.
+ */
+class VaultLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit VaultLoader(QObject *parent = nullptr);
+    ~VaultLoader();
+
+    // starts loading, an empty password keeps the current one (reload),
+    // returns false when a load is still running
+    bool load(std::string password = {});
+
+    inline bool running() const
+    { return busy.load(); }
+
+signals:
+    void progress(const QString &status);
+    void finished(int status); // TokenDatabase::Error
+
+private:
+    std::thread worker;
+    std::atomic<bool> busy{false};
+};
+
+#endif // VAULTLOADER_HPP
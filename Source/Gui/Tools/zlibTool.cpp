@@ -2,27 +2,51 @@
 
 #include <zlib.h>
 
+#include <algorithm>
+#include <cstdint>
+
 const std::string zlibTool::uncompress(const std::string &data, bool *success)
 {
-    if (data.size() <= 4)
+    return uncompress(data.data(), static_cast<int>(data.size()), success);
+}
+
+const std::string zlibTool::uncompress(const char *data, int size, bool *success)
+{
+    if (size <= 4)
     {
         if (success) *success = false;
         return std::string();
     }
 
+    const auto input = reinterpret_cast<const unsigned char*>(data);
+    const auto length = static_cast<std::size_t>(size);
+
+    // inflate straight into the result, sized from the gzip trailer which
+    // stores the uncompressed size (modulo 2^32), or a guess for zlib streams;
+    // the trailer isn't trusted, the buffer grows when the data is larger
+    static const std::size_t maxInitialSize = 1024U * 1024U;
+    std::size_t expected = length * 4;
+    if (length >= 18 && input[0] == 0x1f && input[1] == 0x8b)
+    {
+        const auto trailer = input + length - 4;
+        expected = static_cast<std::size_t>(trailer[0]) |
+                   static_cast<std::size_t>(trailer[1]) << 8 |
+                   static_cast<std::size_t>(trailer[2]) << 16 |
+                   static_cast<std::size_t>(trailer[3]) << 24;
+    }
+
     std::string result;
+    result.resize(std::max<std::size_t>(std::min(expected, maxInitialSize), 1024U));
 
     int ret;
     z_stream strm;
-    static const int CHUNK_SIZE = 1024;
-    char out[CHUNK_SIZE];
 
     /* allocate inflate state */
     strm.zalloc = nullptr;
     strm.zfree = nullptr;
     strm.opaque = nullptr;
-    strm.avail_in = static_cast<uInt>(data.size());
-    strm.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    strm.avail_in = static_cast<uInt>(length);
+    strm.next_in = const_cast<Bytef*>(input);
 
     // gzip decoding
     ret = inflateInit2(&strm, 15 + 32);
@@ -34,8 +58,12 @@ const std::string zlibTool::uncompress(const std::string &data, bool *success)
 
     // run inflate()
     do {
-        strm.avail_out = CHUNK_SIZE;
-        strm.next_out = (Bytef*)(out);
+        if (strm.total_out == result.size())
+        {
+            result.resize(result.size() * 2);
+        }
+        strm.next_out = reinterpret_cast<Bytef*>(&result[strm.total_out]);
+        strm.avail_out = static_cast<uInt>(result.size() - strm.total_out);
 
         ret = inflate(&strm, Z_NO_FLUSH);
         if (ret == Z_STREAM_ERROR)
@@ -55,17 +83,12 @@ const std::string zlibTool::uncompress(const std::string &data, bool *success)
                 if (success) *success = false;
                 return std::string();
         }
+    } while (ret != Z_STREAM_END && strm.avail_out == 0);
 
-        result.append(out, CHUNK_SIZE - strm.avail_out);
-    } while (strm.avail_out == 0);
+    result.resize(strm.total_out);
 
     // clean up and return
     inflateEnd(&strm);
     if (success) *success = true;
     return result;
 }
-
-const std::string zlibTool::uncompress(const char *data, int size, bool *success)
-{
-    return uncompress(std::string(data, data + size), success);
-}
@@ -0,0 +1,129 @@
+#include "TokenView.hpp"
+
+#include <QHeaderView>
+#include <QDateTime>
+#include <QRegion>
+#include <QShowEvent>
+#include <QHideEvent>
+#include <QResizeEvent>
+#include <QScrollBar>
+
+#include <ctime>
+
+TokenView::TokenView(TokenTableModel *model, QWidget *parent)
+    : QTableView(parent),
+      tokens(model)
+{
+    this->setModel(model);
+
+    this->setSelectionBehavior(QAbstractItemView::SelectRows);
+    this->setSelectionMode(QAbstractItemView::SingleSelection);
+    this->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    this->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+    this->setShowGrid(false);
+    this->setWordWrap(false);
+    this->setCornerButtonEnabled(false);
+    this->setFrameShape(QFrame::NoFrame);
+    this->setIconSize(tokens->iconSize());
+
+    // fixed sizes, the headers never ask all rows for their size hints
+    const auto rowHeight = tokens->iconSize().height() + 8;
+    this->verticalHeader()->hide();
+    this->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    this->verticalHeader()->setMinimumSectionSize(rowHeight);
+    this->verticalHeader()->setDefaultSectionSize(rowHeight);
+
+    const auto codeWidth = this->fontMetrics().horizontalAdvance("00000000") + 16;
+    this->horizontalHeader()->hide();
+    this->horizontalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    this->horizontalHeader()->setSectionResizeMode(TokenTableModel::LabelColumn, QHeaderView::Stretch);
+    this->horizontalHeader()->resizeSection(TokenTableModel::IconColumn, tokens->iconSize().width() + 8);
+    this->horizontalHeader()->resizeSection(TokenTableModel::CodeColumn, codeWidth);
+    this->horizontalHeader()->resizeSection(TokenTableModel::RemainingColumn, this->fontMetrics().horizontalAdvance("000s") + 12);
+
+    // queued, the header updates its sections on the same signals
+    QObject::connect(this->verticalScrollBar(), &QScrollBar::valueChanged, this, &TokenView::updateVisibleRows);
+    QObject::connect(model, &QAbstractItemModel::modelReset, this, &TokenView::updateVisibleRows, Qt::QueuedConnection);
+    QObject::connect(model, &QAbstractItemModel::rowsInserted, this, &TokenView::updateVisibleRows, Qt::QueuedConnection);
+
+    ticker = std::make_shared<QTimer>();
+    ticker->setSingleShot(true);
+    ticker->setTimerType(Qt::PreciseTimer);
+    QObject::connect(ticker.get(), &QTimer::timeout, this, &TokenView::tick);
+}
+
+TokenView::~TokenView()
+{
+    ticker->stop();
+}
+
+QString TokenView::code(const QModelIndex &index) const
+{
+    return tokens->data(tokens->index(index.row(), TokenTableModel::CodeColumn)).toString();
+}
+
+void TokenView::showEvent(QShowEvent *event)
+{
+    // codes may have expired while hidden
+    tokens->setTime(std::time(nullptr));
+    this->updateVisibleRows();
+    this->scheduleTick();
+    QTableView::showEvent(event);
+}
+
+void TokenView::hideEvent(QHideEvent *event)
+{
+    ticker->stop();
+    QTableView::hideEvent(event);
+}
+
+void TokenView::resizeEvent(QResizeEvent *event)
+{
+    QTableView::resizeEvent(event);
+    this->updateVisibleRows();
+}
+
+void TokenView::updateVisibleRows()
+{
+    const auto first = this->rowAt(0);
+    if (first < 0)
+    {
+        tokens->setVisibleRows(0, -1);
+        return;
+    }
+
+    // the last row may only be partially visible
+    auto last = this->rowAt(this->viewport()->height() - 1);
+    if (last < 0)
+    {
+        last = tokens->rowCount() - 1;
+    }
+    tokens->setVisibleRows(first, last);
+}
+
+void TokenView::tick()
+{
+    tokens->setTime(std::time(nullptr));
+
+    // repaint the time dependent columns of the visible rows only,
+    // dataChanged() would invalidate the whole viewport
+    QRegion region;
+    for (auto&& column : {TokenTableModel::CodeColumn, TokenTableModel::RemainingColumn})
+    {
+        if (!this->isColumnHidden(column))
+        {
+            region += QRect(this->columnViewportPosition(column), 0,
+                            this->columnWidth(column), this->viewport()->height());
+        }
+    }
+    this->viewport()->update(region);
+
+    this->scheduleTick();
+}
+
+void TokenView::scheduleTick()
+{
+    // fire right after the next full second, when periods roll over
+    const auto ms = QDateTime::currentMSecsSinceEpoch() % 1000;
+    ticker->start(static_cast<int>(1000 - ms));
+}
@@ -0,0 +1,48 @@
+#ifndef TOKENVIEW_HPP
+#define TOKENVIEW_HPP
+
+#include <memory>
+
+#include <QTableView>
+#include <QTimer>
+
+#include <Models/TokenTableModel.hpp>
+
+/**
+ * Token list view with fixed row heights.
+ *
+ * The visible rows are announced to the model, which publishes the codes
+ * of just these rows (see TokenTableModel::setVisibleRows()). A timer
+ * aligned to the start of every second advances the time of the model and
+ * repaints just the code and countdown columns.
+ */
+class TokenView : public QTableView
+{
+    Q_OBJECT
+
+public:
+    explicit TokenView(TokenTableModel *model, QWidget *parent = nullptr);
+    ~TokenView();
+
+    inline TokenTableModel *tokenModel() const
+    { return this->tokens; }
+
+    // code shown in a row
+    QString code(const QModelIndex &index) const;
+
+protected:
+    void showEvent(QShowEvent *event);
+    void hideEvent(QHideEvent *event);
+    void resizeEvent(QResizeEvent *event);
+
+private:
+    void updateVisibleRows();
+    void tick();
+    void scheduleTick();
+
+private:
+    TokenTableModel *tokens = nullptr; // not owned
+    std::shared_ptr<QTimer> ticker;
+};
+
+#endif // TOKENVIEW_HPP
@@ -4,6 +4,14 @@
 
 #include <TokenDatabase.hpp>
 
+#include <QCursor>
+#include <QMessageBox>
+
+#include <algorithm>
+
+// tokens per page of the tray menu
+static const std::size_t trayTokensPerPage = 20U;
+
 MainWindow::MainWindow(QWidget *parent)
     : QRootWidget(parent)
 {
@@ -13,7 +21,25 @@ MainWindow::MainWindow(QWidget *parent)
     data.titleBar = GuiHelpers::make_titlebar(this, "");
 
     data.vbox->addWidget(data.titleBar.get());
-    data.vbox->addSpacerItem(new QSpacerItem(0, 10, QSizePolicy::Minimum, QSizePolicy::Expanding));
+
+    // token list
+    tokenFilter = std::make_shared<QLineEdit>();
+    tokenFilter->setFrame(false);
+    tokenFilter->setAutoFillBackground(true);
+    tokenFilter->setContentsMargins(3,0,3,0);
+    tokenFilter->setPlaceholderText(QObject::tr("Search"));
+    tokenFilter->setClearButtonEnabled(true);
+    data.innerVBox->addWidget(tokenFilter.get());
+
+    tokenModel = std::make_shared<TokenTableModel>();
+    tokenView = std::make_shared<TokenView>(tokenModel.get());
+    data.innerVBox->addWidget(tokenView.get());
+
+    QObject::connect(tokenFilter.get(), &QLineEdit::textChanged, this, [&](const QString &text) {
+        tokenModel->setFilter(text);
+    });
+
+    data.vbox->addLayout(data.innerVBox.get());
     this->setLayout(data.vbox.get());
 
     // create system tray icon
@@ -34,10 +60,12 @@ MainWindow::MainWindow(QWidget *parent)
 
         trayMenu->addSeparator();
 
-        traySeparatorBeforeTokens = std::make_shared<QAction>();
-        traySeparatorBeforeTokens->setSeparator(true);
-        trayMenu->addAction(traySeparatorBeforeTokens.get());
-        traySeparatorBeforeTokens->setVisible(false);
+        // token entries are created when the submenu opens, one page at a time
+        trayTokenMenu = std::make_shared<QMenu>(QObject::tr("Tokens"));
+        QObject::connect(trayTokenMenu.get(), &QMenu::aboutToShow, this, &MainWindow::populateTrayTokens);
+        trayMenu->addMenu(trayTokenMenu.get());
+
+        trayMenu->addSeparator();
 
         trayMenu->addAction(QString(QObject::tr("Quit %1")).arg(qApp->applicationDisplayName()), this, [&]{
             qApp->quit();
@@ -67,6 +95,11 @@ MainWindow::MainWindow(QWidget *parent)
     // Initialize Clipboard
     clipboard = QGuiApplication::clipboard();
 
+    // Copy code of the activated token
+    QObject::connect(tokenView.get(), &TokenView::activated, this, [&](const QModelIndex &index) {
+        copyTokenCode(tokenModel->tokenId(index));
+    });
+
     // Restore UI state
     const auto _geometry = saveGeometry();
     restoreGeometry(gcfg::settings()->value(gcfg::keyGeometryMainWindow(), _geometry).toByteArray());
@@ -75,6 +108,28 @@ MainWindow::MainWindow(QWidget *parent)
 MainWindow::~MainWindow()
 {
     clipboard = nullptr;
+
+    // the view refers to the model
+    tokenView.reset();
+    tokenModel.reset();
+}
+
+void MainWindow::updateTokenList()
+{
+    tokenModel->reload();
+}
+
+void MainWindow::setLoadingStatus(const QString &status)
+{
+    if (!loading && !status.isEmpty())
+    {
+        // the loader thread owns the database until it finished
+        tokenModel->release();
+    }
+
+    loading = !status.isEmpty();
+    tokenFilter->setEnabled(!loading);
+    data.titleBar->setWindowTitle(status);
 }
 
 void MainWindow::minimizeToTray()
@@ -106,6 +161,98 @@ void MainWindow::trayShowHideCallback()
     }
 }
 
+void MainWindow::populateTrayTokens()
+{
+    // actions added with addAction() are owned by the menu and deleted here,
+    // only the current page is ever kept in memory
+    trayTokenMenu->clear();
+
+    if (loading)
+    {
+        trayTokenMenu->addAction(QObject::tr("Loading..."))->setEnabled(false);
+        return;
+    }
+
+    const auto count = TokenDatabase::databaseConnected() ? static_cast<std::size_t>(TokenDatabase::tokenCount()) : 0U;
+    if (count == 0)
+    {
+        trayTokenMenu->addAction(QObject::tr("No tokens"))->setEnabled(false);
+        return;
+    }
+
+    const auto pages = (count + trayTokensPerPage - 1) / trayTokensPerPage;
+    trayTokenPage = std::min(trayTokenPage, pages - 1);
+    const auto offset = trayTokenPage * trayTokensPerPage;
+
+    // the menu closes on every triggered action, reopen it on the new page
+    const auto turnPage = [&](const std::size_t &page) {
+        trayTokenPage = page;
+        const auto pos = QCursor::pos();
+        QTimer::singleShot(0, this, [this, pos]{
+            trayTokenMenu->popup(pos);
+        });
+    };
+
+    if (pages > 1)
+    {
+        trayTokenMenu->addAction(QString(QObject::tr("%1-%2 of %3")).arg(offset + 1)
+                                 .arg(std::min(offset + trayTokensPerPage, count)).arg(count))->setEnabled(false);
+        if (trayTokenPage > 0)
+        {
+            trayTokenMenu->addAction(QObject::tr("Previous"), this, [=]{ turnPage(trayTokenPage - 1); });
+        }
+        trayTokenMenu->addSeparator();
+    }
+
+    // entries only keep the token id, codes are computed on activation
+    TokenDatabase::forEachToken([&](const OTPToken &token) {
+        const auto id = token.id();
+        trayTokenMenu->addAction(QString::fromUtf8(token.label().c_str()), this, [this, id]{
+            copyTokenCode(id);
+        });
+    }, offset, trayTokensPerPage);
+
+    if (trayTokenPage + 1 < pages)
+    {
+        trayTokenMenu->addSeparator();
+        trayTokenMenu->addAction(QObject::tr("Next"), this, [=]{ turnPage(trayTokenPage + 1); });
+    }
+}
+
+void MainWindow::copyTokenCode(const OTPToken::sqliteTokenID &id)
+{
+    // tokens visible in the list already have a published code,
+    // counter based codes are never published
+    auto code = tokenModel->publishedCode(id);
+    if (code.empty())
+    {
+        auto token = TokenDatabase::selectToken(id);
+        code = token.generateToken();
+
+        // HOTP codes are only valid once, the next copy must get the next code
+        if (!code.empty() && token.type() == OTPToken::HOTP)
+        {
+            token.increaseCounter();
+            auto status = TokenDatabase::updateToken(id, token);
+            if (status == TokenDatabase::Success)
+            {
+                status = TokenDatabase::saveTokens();
+            }
+            if (status != TokenDatabase::Success)
+            {
+                QMessageBox::critical(this, QObject::tr("Error"), QString::fromUtf8(TokenDatabase::getErrorMessage(status).c_str()));
+                return;
+            }
+            tokenModel->setCounter(id, token.counter());
+        }
+    }
+
+    if (!code.empty())
+    {
+        clipboard->setText(QString::fromUtf8(code.c_str()));
+    }
+}
+
 void MainWindow::showEvent(QShowEvent *event)
 {
     // Set system tray icon visible text
@@ -11,8 +11,11 @@
 
 #include <QShortcut>
 #include <QClipboard>
+#include <QLineEdit>
 
 #include <WidgetHelpers/QRootWidget.hpp>
+#include <WidgetHelpers/TokenView.hpp>
+#include <Models/TokenTableModel.hpp>
 
 class MainWindow : public QRootWidget
 {
@@ -24,8 +27,17 @@ public:
 
     void minimizeToTray();
 
+    // reloads the token list from the database
+    void updateTokenList();
+
+    // shows the status in the title bar while the database is (re)loaded,
+    // an empty status ends loading, the database isn't accessed in between
+    void setLoadingStatus(const QString &status);
+
 private:
     void trayShowHideCallback();
+    void populateTrayTokens();
+    void copyTokenCode(const OTPToken::sqliteTokenID &id);
 
 signals:
     void resized();
@@ -36,16 +48,19 @@ protected:
     void closeEvent(QCloseEvent *event);
 
 private:
-    std::shared_ptr<QTimer> masterTimer;
-    QList<std::shared_ptr<QTimer>> timers;
+    std::shared_ptr<QLineEdit> tokenFilter;
+    std::shared_ptr<TokenTableModel> tokenModel;
+    std::shared_ptr<TokenView> tokenView;
 
     std::shared_ptr<QSystemTrayIcon> trayIcon;
     std::shared_ptr<QMenu> trayMenu;
     std::shared_ptr<QAction> trayShowHide;
     QString trayShowText;
     QString trayHideText;
-    std::shared_ptr<QAction> traySeparatorBeforeTokens;
-    QList<std::shared_ptr<QAction>> trayTokens;
+    std::shared_ptr<QMenu> trayTokenMenu;
+    std::size_t trayTokenPage = 0;
+
+    bool loading = false;
 
     QClipboard *clipboard = nullptr;
 };
@@ -3,6 +3,7 @@
 #include <string>
 #include <cstdlib>
 #include <cstdio>
+#include <memory>
 
 #ifndef OS_WASM
 #include <Signals.hpp>
@@ -26,6 +27,7 @@ Q_IMPORT_PLUGIN(QWebpPlugin)
 #include <CommandLineOperation.hpp>
 
 #include <TokenDatabase.hpp>
+#include <Profiler.hpp>
 
 #include <QApplication>
 #include <QMessageBox>
@@ -33,6 +35,7 @@ Q_IMPORT_PLUGIN(QWebpPlugin)
 
 #include <Windows/MainWindow.hpp>
 #include <Windows/UserInputDialog.hpp>
+#include <Tools/VaultLoader.hpp>
 
 #ifdef OS_WASM
 
@@ -56,6 +59,9 @@ Q_DECLARE_METATYPE(QList<int>)
 // causes a SEGFAULT randomly on application quit/clean up
 MainWindow *mainWindow = nullptr;
 
+// owned by the application, loads the token database in the background
+VaultLoader *vaultLoader = nullptr;
+
 #ifdef QTKEYCHAIN_SUPPORT
 // QKeychain already handles raw pointers and deletes them
 QKeychain::ReadPasswordJob *receivePassword = nullptr;
@@ -129,17 +135,58 @@ int askPass(const QString &dialogNotice, const QString &error, std::string &pass
     return 0;
 }
 
+// prints the startup profile and writes the optional Chrome trace,
+// arguments: --profile [trace.json]
+static void finishProfile(const QStringList &args)
+{
+    // the first query after unlocking, as done when listing tokens
+    TokenDatabase::selectTokens();
+    Profiler::setEnabled(false);
+
+    std::cout << Profiler::report();
+
+    const auto pos = args.indexOf("--profile");
+    if (pos != -1 && pos + 1 < args.size() && !args.at(pos + 1).startsWith("--"))
+    {
+        const auto file = args.at(pos + 1).toUtf8().toStdString();
+        if (Profiler::writeChromeTrace(file))
+        {
+            std::cout << "Chrome trace written to " << file << std::endl;
+        }
+        else
+        {
+            std::cerr << "Unable to write the trace file: " << file << std::endl;
+        }
+    }
+}
+
+// keychainPassword: the password or the exported database key,
+// create: (re)write the keychain entry once the database is unlocked
 int start(OTPGenApplication *a, const std::string &keychainPassword, bool create = false)
 {
     std::string password;
 
-    // token database exists, ask for decryption and load tokens
-    if (QFileInfo(QString::fromUtf8(gcfg::database().c_str())).exists())
+    // --profile [trace.json]: time the unlock phases
+    const auto profile = a->arguments().contains("--profile");
+    Profiler::setEnabled(profile);
+
+    const auto exists = QFileInfo(QString::fromUtf8(gcfg::database().c_str())).exists();
+
+    // token database exists, ask for decryption, tokens are loaded in the background
+    if (exists)
     {
         // Release Build
 #ifndef OTPGEN_DEBUG
-        if (keychainPassword.empty())
+        // a stored key skips password hashing and key derivation,
+        // the loader keeps the imported key
+        const auto storedKey = TokenDatabase::isExportedKey(keychainPassword);
+        const auto keyImported = storedKey && TokenDatabase::importKey(keychainPassword) == TokenDatabase::Success;
+
+        if (!keyImported && (keychainPassword.empty() || storedKey))
         {
+            // stored keys are stale after the password was changed, replace them
+            create = create || storedKey;
+
             int res = askPass("Please enter the decryption password for your token database.",
                               "You didn't entered a password for decryption. Application will quit now.",
                               password, a);
@@ -149,31 +196,16 @@ int start(OTPGenApplication *a, const std::string &keychainPassword, bool create
                 return res;
             }
         }
-        else
+        else if (!keyImported)
         {
             password = keychainPassword;
-        }
-
-        TokenDatabase::setPassword(password);
 
-        const auto status = TokenDatabase::loadTokens();
-        if (status != TokenDatabase::Success)
-        {
-            QMessageBox::critical(nullptr, "Error", QString(TokenDatabase::getErrorMessage(status).c_str()));
-            return static_cast<int>(status) + 5;
+            // replace the stored password with the key
+            create = create || gcfg::keychainStoresKey();
         }
-
 #else
         // Development Build
-
-        TokenDatabase::setPassword("pwd123");
-        std::printf("main: loadTokens -> %i\n", TokenDatabase::loadTokens());
-        for (auto&& token : TokenDatabase::selectTokens())
-        {
-            std::cout << token << std::endl;
-        }
-
-        //std::printf("%i\n", TokenDatabase::changePassword("pwd123"));
+        password = "pwd123";
 #endif
     }
 
@@ -199,7 +231,11 @@ int start(OTPGenApplication *a, const std::string &keychainPassword, bool create
 #ifdef QTKEYCHAIN_SUPPORT
     if (create)
     {
-        storePassword->setTextData(QString::fromUtf8(password.c_str()));
+        // keys are exported once the database is unlocked
+        if (!gcfg::keychainStoresKey())
+        {
+            storePassword->setTextData(QString::fromUtf8(password.c_str()));
+        }
         QObject::connect(storePassword, &QKeychain::ReadPasswordJob::finished, a, [&]{
             auto error = storePassword->error();
 
@@ -208,24 +244,20 @@ int start(OTPGenApplication *a, const std::string &keychainPassword, bool create
                 QMessageBox::critical(nullptr, "Keychain Error", receivePassword->errorString());
             }
         });
-        storePassword->start();
     }
     else
     {
         // not automatically deleted when not used
         delete storePassword;
+        storePassword = nullptr;
     }
 #endif
 
-    password.clear();
-
-    // run command line operation if any
-    // FIXME: change how command line arguments are handled
-    const auto args = a->arguments();
-    exec_commandline_operation(qtargs_to_strvec(args));
-
-    // create main window
-    mainWindow = new MainWindow();
+    // create main window, shown while the token database is still loading
+    {
+        Profiler::Scope scope("MainWindow");
+        mainWindow = new MainWindow();
+    }
     QObject::connect(mainWindow, &MainWindow::closed, a, &OTPGenApplication::quit);
 
     if (!gcfg::startMinimizedToTray())
@@ -234,6 +266,94 @@ int start(OTPGenApplication *a, const std::string &keychainPassword, bool create
         mainWindow->activateWindow();
     }
 
+    // runs once the tokens are available
+    const auto ready = [a, profile]{
+#ifdef QTKEYCHAIN_SUPPORT
+        // only store passwords which unlocked the database
+        if (storePassword)
+        {
+            if (gcfg::keychainStoresKey())
+            {
+                const auto key = TokenDatabase::exportKey();
+                storePassword->setTextData(QString::fromUtf8(key.data(), static_cast<int>(key.size())));
+            }
+            storePassword->start();
+        }
+#endif
+
+        // run command line operation if any
+        // FIXME: change how command line arguments are handled
+        exec_commandline_operation(qtargs_to_strvec(a->arguments()));
+
+        if (profile)
+        {
+            finishProfile(a->arguments());
+        }
+    };
+
+    // password hashing, key derivation and decryption run on a worker thread,
+    // the database is only accessed by the GUI again after finished()
+    vaultLoader = new VaultLoader(a);
+    QObject::connect(vaultLoader, &VaultLoader::progress, mainWindow, &MainWindow::setLoadingStatus);
+
+    auto initial = std::make_shared<bool>(exists);
+    QObject::connect(vaultLoader, &VaultLoader::finished, mainWindow, [initial, ready](int status){
+        const auto first = *initial;
+        *initial = false;
+
+        mainWindow->setLoadingStatus(QString());
+
+#ifdef OTPGEN_DEBUG
+        std::printf("main: loadTokens -> %i\n", status);
+#endif
+
+        if (status != TokenDatabase::Success)
+        {
+            if (first)
+            {
+                const auto error = static_cast<TokenDatabase::Error>(status);
+                QMessageBox::critical(nullptr, "Error", QString(TokenDatabase::getErrorMessage(error).c_str()));
+                qApp->exit(status + 5);
+            }
+            else
+            {
+                std::printf("Failed to update the token database!\n");
+            }
+            return;
+        }
+
+#ifdef OTPGEN_DEBUG
+        for (auto&& token : TokenDatabase::selectTokens())
+        {
+            std::cout << token << std::endl;
+        }
+#endif
+
+        mainWindow->updateTokenList();
+
+        if (first)
+        {
+            ready();
+        }
+        else
+        {
+            std::printf("Updated!\n");
+        }
+    });
+
+    if (exists)
+    {
+        mainWindow->setLoadingStatus(QObject::tr("Unlocking..."));
+        vaultLoader->load(std::move(password));
+    }
+    else
+    {
+        mainWindow->updateTokenList();
+        ready();
+    }
+
+    password.clear();
+
     // process messages sent from additional instances
 #ifndef OS_WASM
     QObject::connect(a, &OTPGenApplication::messageReceived, a, [&](const QString &message, QObject *socket){
@@ -246,14 +366,13 @@ int start(OTPGenApplication *a, const std::string &keychainPassword, bool create
         else if (message.compare("reloadTokens", Qt::CaseInsensitive) == 0)
         {
             std::printf("Trying to reload the token database...\n");
-            if (TokenDatabase::loadTokens() == TokenDatabase::Success)
+            if (vaultLoader->load())
             {
-                std::printf("Updated!\n");
-                //mainWindow->updateTokenList();
+                mainWindow->setLoadingStatus(QObject::tr("Reloading..."));
             }
             else
             {
-                std::printf("Failed to update the token database!\n");
+                std::printf("The token database is still loading!\n");
             }
         }
     });
@@ -415,6 +534,9 @@ int main(int argc, char **argv)
 
     // clean up
     const auto ret = a.exec();
+
+    // wait for a running load before the database is closed
+    delete vaultLoader;
     delete mainWindow;
     TokenDatabase::closeDatabase();
     return ret;
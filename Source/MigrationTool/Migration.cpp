@@ -0,0 +1,211 @@
+#include "Migration.hpp"
+
+#include <OTPGen.hpp>
+#include <TokenTable.hpp>
+#include <Internal/ParallelFor.hpp>
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace {
+    // ASCII case folding, matches COLLATE NOCASE of the label column
+    static std::string foldLabel(const std::string &label)
+    {
+        std::string folded(label);
+        std::transform(folded.begin(), folded.end(), folded.begin(), [](unsigned char c) {
+            return (c >= 'A' && c <= 'Z') ? static_cast<char>(c + ('a' - 'A')) : static_cast<char>(c);
+        });
+        return folded;
+    }
+}
+
+OTPToken Migration::convert(OTPToken_Old &token)
+{
+    // type mapping changed
+    OTPToken::TokenType new_type = OTPToken::None;
+    switch (token.type())
+    {
+        case OTPToken_Old::None:  new_type = OTPToken::None; break;
+        case OTPToken_Old::TOTP:  new_type = OTPToken::TOTP; break;
+        case OTPToken_Old::HOTP:  new_type = OTPToken::HOTP; break;
+        case OTPToken_Old::Steam: new_type = OTPToken::Steam; break;
+        case OTPToken_Old::Authy: new_type = OTPToken::TOTP; break;
+    }
+
+    // algorithm mapping
+    OTPToken::ShaAlgorithm new_algo = OTPToken::Invalid;
+    switch (token.algorithm())
+    {
+        case OTPToken_Old::Invalid: new_algo = OTPToken::Invalid; break;
+        case OTPToken_Old::SHA1:    new_algo = OTPToken::SHA1; break;
+        case OTPToken_Old::SHA256:  new_algo = OTPToken::SHA256; break;
+        case OTPToken_Old::SHA512:  new_algo = OTPToken::SHA512; break;
+    }
+
+    OTPToken migrated(
+        new_type,
+        token.label(),
+        OTPToken::Icon(),
+        token.secret(),
+        token.digits(),
+        token.period(),
+        token.counter(),
+        new_algo
+    );
+
+    // icon format changed, the old buffer is freed right after the conversion
+    const auto old_icon = token.releaseIcon();
+    if (!old_icon.empty())
+    {
+        const auto data = reinterpret_cast<const unsigned char*>(old_icon.data());
+        migrated.setIcon(OTPToken::Icon(data, data + old_icon.size()));
+    }
+
+    return migrated;
+}
+
+TokenDatabase::Error Migration::migrate(std::ostream &log, ReferenceList *reference, const Progress &progress)
+{
+    auto &old_tokens = TokenStore_Old::i()->tokens();
+    auto total = old_tokens.size();
+
+    // progress is reported in 1% steps
+    const auto step = std::max<std::size_t>(1U, total / 100U);
+    const auto report = [&](const Stage &stage, const std::size_t &done) {
+        if (progress && (done % step == 0 || done == total))
+        {
+            progress(stage, done, total);
+        }
+    };
+
+    TokenDatabase::OTPTokenList tokens;
+    tokens.reserve(total);
+
+    if (reference)
+    {
+        reference->clear();
+        reference->reserve(total);
+    }
+
+    // the old store allowed labels which only differ in case, the database
+    // doesn't, a conflict would roll back the whole transaction
+    std::unordered_set<std::string> labels;
+    labels.reserve(total);
+    std::size_t done = 0;
+
+    for (auto&& token : old_tokens)
+    {
+        ++done;
+        if (!labels.insert(foldLabel(token->label())).second)
+        {
+            log << "failed to insert: " << token->label() << " (duplicate label)" << std::endl;
+            token.reset();
+            report(Converting, done);
+            continue;
+        }
+
+        if (reference)
+        {
+            reference->push_back({
+                token->type(),
+                token->label(),
+                SecureString(token->secret().begin(), token->secret().end()),
+                token->digits(),
+                token->period(),
+                token->counter(),
+                token->algorithm(),
+            });
+        }
+        tokens.emplace_back(convert(*token));
+
+        // release the old token, only one copy of the tokens is kept alive
+        token.reset();
+        report(Converting, done);
+    }
+
+    TokenStore_Old::TokenList().swap(old_tokens);
+    total = tokens.size();
+
+    // single transaction and display order write
+    return TokenDatabase::insertTokens(tokens, [&](const std::size_t &inserted) {
+        report(Inserting, inserted);
+    });
+}
+
+OTPToken::TokenString Migration::expectedCode(const Reference &token, const std::time_t &time)
+{
+    OTPToken::ShaAlgorithm algorithm = OTPToken::Invalid;
+    switch (token.algorithm)
+    {
+        case OTPToken_Old::Invalid: algorithm = OTPToken::Invalid; break;
+        case OTPToken_Old::SHA1:    algorithm = OTPToken::SHA1; break;
+        case OTPToken_Old::SHA256:  algorithm = OTPToken::SHA256; break;
+        case OTPToken_Old::SHA512:  algorithm = OTPToken::SHA512; break;
+    }
+
+    switch (token.type)
+    {
+        case OTPToken_Old::TOTP:
+        case OTPToken_Old::Authy:
+            // OTPGen divides by the period
+            if (token.period == 0)
+            {
+                return {};
+            }
+            return OTPGen::computeTOTP(time, token.secret, token.digits, token.period, algorithm);
+
+        case OTPToken_Old::HOTP:
+            return OTPGen::computeHOTP(token.secret, token.counter, token.digits, algorithm);
+
+        case OTPToken_Old::Steam:
+            return OTPGen::computeSteam(time, token.secret);
+
+        case OTPToken_Old::None:
+            break;
+    }
+
+    return {};
+}
+
+std::size_t Migration::verify(const ReferenceList &reference, const std::time_t &time, std::ostream &log)
+{
+    TokenTable migrated;
+    const auto status = TokenDatabase::selectTokenTable(migrated);
+    if (status != TokenDatabase::Success)
+    {
+        log << "verify: " << TokenDatabase::getErrorMessage(status) << std::endl;
+        return reference.size();
+    }
+
+    TokenTable::CodeList expected(reference.size()), actual;
+    ParallelFor::run(reference.size(), [&](const std::size_t &row) {
+        expected[row] = expectedCode(reference[row], time);
+    }, 0, 256);
+    migrated.generate(time, actual, 0);
+
+    std::size_t mismatches = 0;
+
+    // both follow the insertion order
+    const auto rows = std::min(reference.size(), migrated.size());
+    for (TokenTable::Index row = 0; row < rows; ++row)
+    {
+        if (reference[row].label != migrated.label(row))
+        {
+            log << "verify: label mismatch: " << reference[row].label << " != " << migrated.label(row) << std::endl;
+            ++mismatches;
+        }
+        else if (expected[row] != actual[row])
+        {
+            log << "verify: code mismatch: " << reference[row].label << std::endl;
+            ++mismatches;
+        }
+    }
+
+    if (reference.size() != migrated.size())
+    {
+        log << "verify: expected " << reference.size() << " tokens, got " << migrated.size() << std::endl;
+        mismatches += std::max(reference.size(), migrated.size()) - rows;
+    }
+
+    return mismatches;
+}
@@ -0,0 +1,65 @@
+#ifndef MIGRATION_HPP
+#define MIGRATION_HPP
+
+#include <OldFormat/TokenStore_Old.hpp>
+
+#include <TokenDatabase.hpp>
+
+#include <ctime>
+#include <functional>
+#include <ostream>
+#include <vector>
+
+/**
+ * Migrates the old token store into the SQLite-based token database.
+ *
+ * All tokens are inserted in a single transaction with one write of the
+ * display order (see TokenDatabase::insertTokens). Every old token is
+ * released as soon as it was converted and icons are moved out of it, so
+ * the tokens are never kept twice in memory.
+ */
+class Migration final
+{
+    Migration() = delete;
+
+public:
+    enum Stage {
+        Converting,
+        Inserting,
+    };
+
+    using Progress = std::function<void(const Stage &stage, const std::size_t &done, const std::size_t &total)>;
+
+    // fields of an old token, verify() computes the expected codes from
+    // them without going through convert()
+    struct Reference {
+        OTPToken_Old::TokenType type;
+        OTPToken_Old::Label label;
+        SecureString secret;
+        OTPToken_Old::DigitType digits;
+        OTPToken_Old::PeriodType period;
+        OTPToken_Old::CounterType counter;
+        OTPToken_Old::ShaAlgorithm algorithm;
+    };
+    using ReferenceList = std::vector<Reference>;
+
+    // converts a single token, the icon is moved out of the old token
+    static OTPToken convert(OTPToken_Old &token);
+
+    // migrates and empties the old store into the opened database, when a
+    // reference is given the old tokens are appended to it for verify();
+    // tokens whose label only differs in case from an earlier one are
+    // skipped and written to the log
+    static TokenDatabase::Error migrate(std::ostream &log, ReferenceList *reference = nullptr, const Progress &progress = {});
+
+    // compares labels and the codes generated at the given time between the
+    // reference and the database, returns the number of mismatching tokens,
+    // mismatches are written to the log
+    static std::size_t verify(const ReferenceList &reference, const std::time_t &time, std::ostream &log);
+
+private:
+    // code of the old token at the given time, computed with OTPGen
+    static OTPToken::TokenString expectedCode(const Reference &token, const std::time_t &time);
+};
+
+#endif // MIGRATION_HPP
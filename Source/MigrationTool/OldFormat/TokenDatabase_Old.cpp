@@ -4,6 +4,7 @@
 #include <fstream>
 #include <ostream>
 #include <sstream>
+#include <unordered_set>
 
 #include <cryptopp/cryptlib.h>
 #include <cryptopp/algparam.h>
@@ -224,6 +225,11 @@ TokenDatabase_Old::Error TokenDatabase_Old::loadTokens()
     }
 
     TokenStore_Old::i()->clear();
+    TokenStore_Old::i()->_tokens.reserve(data.data.size());
+
+    // same as addTokenUnsafe(), without searching the whole store for every token
+    std::unordered_set<OTPToken_Old::Label> labels;
+    labels.reserve(data.data.size());
 
     for (auto&& t : data.data)
     {
@@ -234,23 +240,31 @@ TokenDatabase_Old::Error TokenDatabase_Old::loadTokens()
         auto unmangledSecret = unmangleTokenSecret(t.secret);
         t.secret.clear();
 
+        TokenStore_Old::Token token;
         switch (t.type)
         {
             case OTPToken_Old::TOTP:
-                TokenStore_Old::i()->addTokenUnsafe(std::make_shared<TOTPToken_Old>(t.label, t.icon, unmangledSecret, t.digits, t.period, t.counter, t.algorithm));
+                token = std::make_shared<TOTPToken_Old>(t.label, t.icon, unmangledSecret, t.digits, t.period, t.counter, t.algorithm);
                 break;
             case OTPToken_Old::HOTP:
-                TokenStore_Old::i()->addTokenUnsafe(std::make_shared<HOTPToken_Old>(t.label, t.icon, unmangledSecret, t.digits, t.period, t.counter, t.algorithm));
+                token = std::make_shared<HOTPToken_Old>(t.label, t.icon, unmangledSecret, t.digits, t.period, t.counter, t.algorithm);
                 break;
             case OTPToken_Old::Steam:
-                TokenStore_Old::i()->addTokenUnsafe(std::make_shared<SteamToken_Old>(t.label, t.icon, unmangledSecret, t.digits, t.period, t.counter, t.algorithm));
+                token = std::make_shared<SteamToken_Old>(t.label, t.icon, unmangledSecret, t.digits, t.period, t.counter, t.algorithm);
                 break;
             case OTPToken_Old::Authy:
-                TokenStore_Old::i()->addTokenUnsafe(std::make_shared<AuthyToken_Old>(t.label, t.icon, unmangledSecret, t.digits, t.period, t.counter, t.algorithm));
+                token = std::make_shared<AuthyToken_Old>(t.label, t.icon, unmangledSecret, t.digits, t.period, t.counter, t.algorithm);
                 break;
         }
 
+        if (token && !token->label().empty() && labels.insert(token->label()).second)
+        {
+            TokenStore_Old::i()->_tokens.emplace_back(token);
+        }
+
+        // the archive copy isn't needed anymore
         unmangledSecret.clear();
+        OTPToken_Old::Icon().swap(t.icon);
     }
 
     data.data.clear();
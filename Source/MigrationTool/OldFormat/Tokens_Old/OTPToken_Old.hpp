@@ -4,6 +4,7 @@
 #include <string>
 #include <cstdint>
 #include <memory>
+#include <utility>
 
 class OTPToken_Old
 {
@@ -64,6 +65,9 @@ public:
     { this->_icon = icon; }
     const Icon &icon() const
     { return _icon; }
+    // moves the icon out of the token
+    inline Icon releaseIcon()
+    { return std::move(_icon); }
 
     // base-32 encoded secret
     inline void setSecret(const SecretType &secret)
@@ -1,4 +1,7 @@
 #include <iostream>
+#include <ctime>
+#include <string>
+#include <vector>
 
 #include <StdinEchoMode.hpp>
 
@@ -13,9 +16,13 @@
 ///
 #include <TokenDatabase.hpp>
 
+#include "Migration.hpp"
+
 void print_usage()
 {
-    std::cout << "Usage: otpgen-migratedb inputfile (outputfile=tokens.db)" << std::endl;
+    std::cout << "Usage: otpgen-migratedb [--dry-run] [--verify] inputfile (outputfile=tokens.db)" << std::endl;
+    std::cout << "  --dry-run  migrate in memory only and verify the result, nothing is written" << std::endl;
+    std::cout << "  --verify   reload the written database and compare the generated codes" << std::endl;
 }
 
 int load_old(const std::string &path)
@@ -57,8 +64,19 @@ int load_old(const std::string &path)
     return 0;
 }
 
-int init_new(const std::string &path)
+int init_new(const std::string &path, bool dry_run)
 {
+    // nothing is encrypted in a dry run
+    if (dry_run)
+    {
+        auto status = TokenDatabase::initializeTokens(false);
+        if (status != TokenDatabase::Success)
+        {
+            std::cerr << TokenDatabase::getErrorMessage(status) << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
     if (!TokenDatabase::setTokenDatabase(path))
     {
@@ -97,98 +115,107 @@ int init_new(const std::string &path)
     return 0;
 }
 
-void do_migration()
+int do_migration(bool dry_run, bool verify)
 {
-    for (auto&& token : TokenStore_Old::i()->tokens())
+    Migration::ReferenceList reference;
+
+    auto status = Migration::migrate(std::cerr, verify ? &reference : nullptr,
+        [](const Migration::Stage &stage, const std::size_t &done, const std::size_t &total) {
+            std::cout << "\r" << (stage == Migration::Converting ? "converting" : "inserting ")
+                      << ": " << done << "/" << total << std::flush;
+        });
+    std::cout << std::endl;
+
+    // the transaction was rolled back, nothing was migrated
+    if (status != TokenDatabase::Success)
     {
-        // type mapping changed
-        OTPToken::TokenType new_type;
-        switch (token->type())
-        {
-            case OTPToken_Old::None:  new_type = OTPToken::None; break;
-            case OTPToken_Old::TOTP:  new_type = OTPToken::TOTP; break;
-            case OTPToken_Old::HOTP:  new_type = OTPToken::HOTP; break;
-            case OTPToken_Old::Steam: new_type = OTPToken::Steam; break;
-            case OTPToken_Old::Authy: new_type = OTPToken::TOTP; break;
-        }
+        std::cerr << TokenDatabase::getErrorMessage(status) << std::endl;
+        return 1;
+    }
 
-        // algorithm mapping
-        OTPToken::ShaAlgorithm new_algo;
-        switch (token->algorithm())
+    if (!dry_run)
+    {
+        status = TokenDatabase::saveTokens();
+        if (status != TokenDatabase::Success)
         {
-            case OTPToken_Old::Invalid: new_algo = OTPToken::Invalid; break;
-            case OTPToken_Old::SHA1:    new_algo = OTPToken::SHA1; break;
-            case OTPToken_Old::SHA256:  new_algo = OTPToken::SHA256; break;
-            case OTPToken_Old::SHA512:  new_algo = OTPToken::SHA512; break;
+            std::cerr << TokenDatabase::getErrorMessage(status) << std::endl;
+            return 1;
         }
+    }
 
-        // icon format changed
-        const auto old_icon = reinterpret_cast<const unsigned char*>(token->icon().data());
-        OTPToken::Icon new_icon(old_icon, old_icon + token->icon().size());
-
-        // insert migrated token
-        auto status = TokenDatabase::insertToken(OTPToken(
-            new_type,
-            token->label(),
-            new_icon,
-            token->secret(),
-            token->digits(),
-            token->period(),
-            token->counter(),
-            new_algo
-        ));
-
-        // check for errors and inform user about failed/skipped tokens
+    if (!verify)
+    {
+        return 0;
+    }
+
+    // verify what was actually written
+    if (!dry_run)
+    {
+        TokenDatabase::closeDatabase();
+        status = TokenDatabase::loadTokens();
         if (status != TokenDatabase::Success)
         {
-            std::cerr << "failed to insert: " << token->label() << std::endl;
+            std::cerr << TokenDatabase::getErrorMessage(status) << std::endl;
+            return 1;
         }
     }
 
-    auto status = TokenDatabase::saveTokens();
-    if (status != TokenDatabase::Success)
-    {
-        std::cerr << TokenDatabase::getErrorMessage(status) << std::endl;
-    }
+    const auto mismatches = Migration::verify(reference, std::time(nullptr), std::cerr);
+    std::cout << "verified " << reference.size() << " tokens, " << mismatches << " mismatches" << std::endl;
+    return mismatches == 0 ? 0 : 1;
 }
 
 int main(int argc, char **argv)
 {
     std::cout << "OTPGen Migration Tool" << std::endl;
 
-    // check amount of command line arguments
-    if (argc < 2 || argc > 3)
+    // split options from files
+    bool dry_run = false;
+    bool verify = false;
+    std::vector<std::string> files;
+    for (auto i = 1; i < argc; ++i)
     {
-        print_usage();
-        return 1;
+        const std::string arg = argv[i];
+        if (arg == "--dry-run")
+        {
+            dry_run = true;
+        }
+        else if (arg == "--verify")
+        {
+            verify = true;
+        }
+        else
+        {
+            files.emplace_back(arg);
+        }
     }
 
-    // check if to use default outputfile "tokens.db"
-    bool default_ofile = false;
-    if (argc == 2)
+    // check amount of command line arguments
+    if (files.empty() || files.size() > 2)
     {
-        default_ofile = true;
+        print_usage();
+        return 1;
     }
 
     // load old database
-    auto ret = load_old(argv[1]);
+    auto ret = load_old(files.at(0));
     if (ret != 0)
     {
         return ret;
     }
 
-    // initialize new database
-    ret = init_new(default_ofile ? "./tokens.db" : argv[1]);
+    // initialize new database, use default outputfile "tokens.db" when not given
+    ret = init_new(files.size() == 1 ? "./tokens.db" : files.at(1), dry_run);
     if (ret != 0)
     {
         return ret;
     }
 
-    // migrate
-    do_migration();
+    // migrate, a dry run always verifies
+    ret = do_migration(dry_run, verify || dry_run);
 
     // close database
     TokenDatabase::closeDatabase();
 
-    return 0;
+    return ret;
 }
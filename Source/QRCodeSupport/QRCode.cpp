@@ -1,11 +1,22 @@
 #include "QRCode.hpp"
 
 #include <ImageReaderSource.h>
+#include <lodepng.h>
+#include <jpgd.h>
+
+#include <Internal/ParallelFor.hpp>
 
 #include <iostream>
 #include <vector>
 #include <exception>
 #include <fstream>
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <unordered_set>
 
 #include <zxing/common/Counted.h>
 #include <zxing/Binarizer.h>
@@ -14,6 +25,7 @@
 #include <zxing/ReaderException.h>
 #include <zxing/common/GlobalHistogramBinarizer.h>
 #include <zxing/common/HybridBinarizer.h>
+#include <zxing/common/GreyscaleLuminanceSource.h>
 #include <zxing/Exception.h>
 #include <zxing/common/IllegalArgumentException.h>
 #include <zxing/BinaryBitmap.h>
@@ -26,6 +38,9 @@
 #include <zxing/multi/GenericMultipleBarcodeReader.h>
 
 #include <QRCodeGenerator/QrCode.hpp>
+#include <QRCodeGenerator/QrSegment.hpp>
+
+#include <zlib.h>
 
 using namespace zxing;
 using namespace zxing::multi;
@@ -71,6 +86,104 @@ static int read_image(const Ref<LuminanceSource> &source, std::vector<Ref<Result
     return res;
 }
 
+namespace {
+    // luminance source reading straight from a caller-owned pixel buffer,
+    // rows are converted on request without copying the image first
+    class PixelBufferSource : public LuminanceSource
+    {
+    public:
+        PixelBufferSource(const std::uint8_t *pixels, int width, int height, int stride, QRCode::PixelFormat format)
+            : LuminanceSource(width, height), pixels(pixels), stride(stride), format(format)
+        {
+        }
+
+        ArrayRef<char> getRow(int y, ArrayRef<char> row) const override
+        {
+            if (!row || row->size() < getWidth())
+            {
+                row = ArrayRef<char>(getWidth());
+            }
+            convertRow(y, &row[0]);
+            return row;
+        }
+
+        ArrayRef<char> getMatrix() const override
+        {
+            ArrayRef<char> matrix(getWidth() * getHeight());
+            for (auto y = 0; y < getHeight(); ++y)
+            {
+                convertRow(y, &matrix[y * getWidth()]);
+            }
+            return matrix;
+        }
+
+    private:
+        const std::uint8_t *pixels;
+        const int stride;
+        const QRCode::PixelFormat format;
+
+        // same weights as ImageReaderSource
+        static inline char luminance(const int r, const int g, const int b)
+        {
+            return static_cast<char>((306 * r + 601 * g + 117 * b + 0x200) >> 10);
+        }
+
+        void convertRow(const int y, char *out) const
+        {
+            const auto *p = pixels + static_cast<std::ptrdiff_t>(y) * stride;
+            const auto width = getWidth();
+
+            switch (format)
+            {
+                case QRCode::Grey8:
+                    std::copy(p, p + width, reinterpret_cast<std::uint8_t*>(out));
+                    break;
+                case QRCode::RGB24:
+                    for (auto x = 0; x < width; ++x, p += 3) out[x] = luminance(p[0], p[1], p[2]);
+                    break;
+                case QRCode::RGBA32:
+                    for (auto x = 0; x < width; ++x, p += 4) out[x] = luminance(p[0], p[1], p[2]);
+                    break;
+                case QRCode::BGRA32:
+                    for (auto x = 0; x < width; ++x, p += 4) out[x] = luminance(p[2], p[1], p[0]);
+                    break;
+            }
+        }
+    };
+
+    static int bytesPerPixel(const QRCode::PixelFormat &format)
+    {
+        switch (format)
+        {
+            case QRCode::Grey8:  return 1;
+            case QRCode::RGB24:  return 3;
+            case QRCode::RGBA32: return 4;
+            case QRCode::BGRA32: return 4;
+        }
+        return 0;
+    }
+
+    // hybrid mode first, if that fails try without hybrid mode
+    static bool decodeSource(const Ref<LuminanceSource> &source, std::string &data)
+    {
+        std::vector<Ref<Result>> results;
+
+        if (read_image(source, results, true) != 0 &&
+            read_image(source, results, false) != 0)
+        {
+            return false;
+        }
+
+        // read data
+        for (auto&& res : results)
+        {
+            data += res->getText()->getText();
+        }
+
+        return true;
+    }
+}
+
 bool QRCode::decode(const std::string &filename, std::string &data)
 {
     if (filename.empty())
@@ -87,35 +200,246 @@ bool QRCode::decode(const std::string &filename, std::string &data)
         return false;
     }
 
-    std::vector<Ref<Result>> results;
+    return decodeSource(source, data);
+}
 
-    int gresult = 1;
-    int hresult = 1;
+bool QRCode::decode(const std::uint8_t *pixels, const int &width, const int &height, const int &stride,
+                    const PixelFormat &format, std::string &data)
+{
+    data.clear();
 
-    // try hybrid mode first
-    hresult = read_image(source, results, true);
+    if (!pixels || width <= 0 || height <= 0 || stride < width * bytesPerPixel(format))
+    {
+        return false;
+    }
+
+    Ref<LuminanceSource> source(new PixelBufferSource(pixels, width, height, stride, format));
+    return decodeSource(source, data);
+}
 
-    // if that failed try without hybrid mode
-    if (hresult != 0)
+bool QRCode::decodeEncoded(const std::uint8_t *buffer, const std::size_t &size, std::string &data)
+{
+    static const std::uint8_t pngSignature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    static const std::uint8_t jpegSignature[] = {0xFF, 0xD8, 0xFF};
+
+    data.clear();
+
+    if (!buffer)
+    {
+        return false;
+    }
+
+    // the decoded pixels are read in place by the luminance source
+    if (size >= sizeof(pngSignature) && std::equal(pngSignature, pngSignature + sizeof(pngSignature), buffer))
+    {
+        // lodepng's grey conversion only keeps the red channel, decode to RGBA instead
+        std::vector<unsigned char> rgba;
+        unsigned width = 0, height = 0;
+        if (lodepng::decode(rgba, width, height, buffer, size, LCT_RGBA, 8) != 0)
+        {
+            return false;
+        }
+
+        return decode(rgba.data(), static_cast<int>(width), static_cast<int>(height), static_cast<int>(width * 4), RGBA32, data);
+    }
+    else if (size >= sizeof(jpegSignature) && std::equal(jpegSignature, jpegSignature + sizeof(jpegSignature), buffer))
     {
-        gresult = read_image(source, results, false);
-        if (gresult != 0)
+        int width = 0, height = 0, comps = 0;
+        std::unique_ptr<unsigned char, decltype(&std::free)> grey(
+            jpgd::decompress_jpeg_image_from_memory(buffer, static_cast<int>(size), &width, &height, &comps, 1), &std::free);
+        if (!grey)
         {
             return false;
         }
+
+        return decode(grey.get(), width, height, width, Grey8, data);
+    }
+
+    return false;
+}
+
+namespace {
+    // images per batch round, bounds the number of decoded images kept in memory
+    static const std::size_t BATCH_BLOCK_SIZE = 64U;
+
+    // larger images are scaled down by halves until they fit, the
+    // smallest level is tried first and the original size last
+    static const int PYRAMID_MAX_SIZE = 1024;
+
+    // plain luminance plane, zxing's reference counting isn't thread-safe,
+    // so only this is shared between the workers
+    struct Greyscale {
+        std::vector<char> pixels;
+        int width = 0;
+        int height = 0;
+    };
+
+    static bool loadGreyscale(const std::string &file, Greyscale &target)
+    {
+        try {
+            const auto source = ImageReaderSource::create(file);
+            const auto matrix = source->getMatrix();
+            target.width = source->getWidth();
+            target.height = source->getHeight();
+            target.pixels.assign(&matrix[0], &matrix[0] + matrix->size());
+        } catch (...) {
+            return false;
+        }
+        return target.width > 0 && target.height > 0;
     }
 
-    // read data
-    for (auto&& res : results)
+    static Greyscale halve(const Greyscale &input)
     {
-//        for (auto&& val : res->getRawBytes()->values())
-//        {
-//            data += val;
-//        }
-        data += res->getText()->getText();
+        Greyscale output;
+        output.width = input.width / 2;
+        output.height = input.height / 2;
+        output.pixels.resize(static_cast<std::size_t>(output.width) * static_cast<std::size_t>(output.height));
+
+        const auto *src = reinterpret_cast<const unsigned char*>(input.pixels.data());
+        for (auto y = 0; y < output.height; ++y)
+        {
+            const auto *row1 = src + static_cast<std::size_t>(2 * y) * static_cast<std::size_t>(input.width);
+            const auto *row2 = row1 + input.width;
+            auto *dst = &output.pixels[static_cast<std::size_t>(y) * static_cast<std::size_t>(output.width)];
+            for (auto x = 0; x < output.width; ++x)
+            {
+                dst[x] = static_cast<char>((row1[2 * x] + row1[2 * x + 1] + row2[2 * x] + row2[2 * x + 1] + 2) >> 2);
+            }
+        }
+
+        return output;
     }
 
-    return true;
+    // smallest level first
+    static std::vector<Greyscale> buildPyramid(Greyscale &&image)
+    {
+        std::vector<Greyscale> levels;
+        levels.emplace_back(std::move(image));
+        while (std::max(levels.back().width, levels.back().height) > PYRAMID_MAX_SIZE)
+        {
+            levels.emplace_back(halve(levels.back()));
+        }
+        std::reverse(levels.begin(), levels.end());
+        return levels;
+    }
+
+    static bool decodeAll(const Greyscale &image, const bool &hybrid, std::vector<std::string> &codes)
+    {
+        try {
+            ArrayRef<char> pixels(static_cast<int>(image.pixels.size()));
+            std::copy(image.pixels.begin(), image.pixels.end(), &pixels[0]);
+            Ref<LuminanceSource> source(new GreyscaleLuminanceSource(pixels, image.width, image.height, 0, 0, image.width, image.height));
+
+            Ref<Binarizer> binarizer;
+            if (hybrid)
+            {
+                binarizer = new HybridBinarizer(source);
+            }
+            else
+            {
+                binarizer = new GlobalHistogramBinarizer(source);
+            }
+
+            DecodeHints hints(DecodeHints::QR_CODE_HINT);
+            hints.setTryHarder(true);
+            Ref<BinaryBitmap> binary(new BinaryBitmap(binarizer));
+
+            QRCodeMultiReader reader;
+            for (auto&& result : reader.decodeMultiple(binary, hints))
+            {
+                auto text = result->getText()->getText();
+                if (std::find(codes.begin(), codes.end(), text) == codes.end())
+                {
+                    codes.emplace_back(std::move(text));
+                }
+            }
+        } catch (...) {
+            return false;
+        }
+
+        return !codes.empty();
+    }
+
+    // raster formats only, exported SVG files can't be decoded
+    static bool isSupportedImage(const std::filesystem::path &path)
+    {
+        auto extension = path.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        return extension == ".png" || extension == ".jpg" || extension == ".jpe" || extension == ".jpeg";
+    }
+}
+
+QRCode::DecodeResults QRCode::decodeBatch(const std::vector<std::string> &files, const unsigned &threads)
+{
+    DecodeResults results(files.size());
+
+    for (std::size_t offset = 0; offset < files.size(); offset += BATCH_BLOCK_SIZE)
+    {
+        const auto count = std::min(BATCH_BLOCK_SIZE, files.size() - offset);
+
+        // load and scale the images
+        std::vector<std::vector<Greyscale>> pyramids(count);
+        ParallelFor::run(count, [&](const std::size_t &i) {
+            results[offset + i].file = files[offset + i];
+            Greyscale image;
+            if (loadGreyscale(files[offset + i], image))
+            {
+                pyramids[i] = buildPyramid(std::move(image));
+            }
+        }, threads, 1);
+
+        // both binarizers of an image run as separate tasks, the first one
+        // to succeed claims the image and the other one stops early
+        std::unique_ptr<std::atomic<bool>[]> solved(new std::atomic<bool>[count]);
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            solved[i] = false;
+        }
+
+        ParallelFor::run(count * 2, [&](const std::size_t &task) {
+            const auto i = task / 2;
+            const auto hybrid = (task % 2) == 0;
+
+            for (auto&& level : pyramids[i])
+            {
+                if (solved[i])
+                {
+                    return;
+                }
+
+                std::vector<std::string> codes;
+                if (decodeAll(level, hybrid, codes))
+                {
+                    if (!solved[i].exchange(true))
+                    {
+                        results[offset + i].codes = std::move(codes);
+                    }
+                    return;
+                }
+            }
+        }, threads, 1);
+    }
+
+    return results;
+}
+
+QRCode::DecodeResults QRCode::decodeDirectory(const std::string &directory, const unsigned &threads)
+{
+    std::vector<std::string> files;
+
+    std::error_code error;
+    for (std::filesystem::directory_iterator it(directory, error), end; !error && it != end; it.increment(error))
+    {
+        if (it->is_regular_file(error) && isSupportedImage(it->path()))
+        {
+            files.emplace_back(it->path().string());
+        }
+    }
+
+    std::sort(files.begin(), files.end());
+    return decodeBatch(files, threads);
 }
 
 bool QRCode::encode(const std::string &input, std::string &out)
@@ -130,3 +454,195 @@ bool QRCode::encode(const std::string &input, std::string &out)
     out = qr.toSvgString(3);
     return true;
 }
+
+namespace {
+    static void appendBigEndian(std::string &out, const std::uint32_t &value)
+    {
+        out.push_back(static_cast<char>((value >> 24) & 0xFF));
+        out.push_back(static_cast<char>((value >> 16) & 0xFF));
+        out.push_back(static_cast<char>((value >> 8) & 0xFF));
+        out.push_back(static_cast<char>(value & 0xFF));
+    }
+
+    static void appendChunk(std::string &out, const char type[4], const unsigned char *data, const std::size_t &size)
+    {
+        appendBigEndian(out, static_cast<std::uint32_t>(size));
+        const auto start = out.size();
+        out.append(type, 4);
+        out.append(reinterpret_cast<const char*>(data), size);
+        const auto crc = crc32(0L, reinterpret_cast<const Bytef*>(out.data() + start), static_cast<uInt>(size + 4));
+        appendBigEndian(out, static_cast<std::uint32_t>(crc));
+    }
+
+    // 1-bit greyscale PNG straight from the module matrix, no image library involved
+    static bool encodePNG(const qrcodegen::QrCode &qr, const int &scale, const int &border, std::string &out)
+    {
+        const auto modules = qr.getSize() + 2 * border;
+        const auto size = static_cast<std::size_t>(modules) * static_cast<std::size_t>(scale);
+        const auto stride = (size + 7) / 8;
+
+        // filter byte + packed pixels, white is 1
+        std::vector<unsigned char> raw((stride + 1) * size, 0);
+        std::vector<unsigned char> row(stride + 1, 0);
+        for (auto my = 0; my < modules; ++my)
+        {
+            std::fill(row.begin(), row.end(), 0);
+            for (std::size_t x = 0; x < size; ++x)
+            {
+                const auto mx = static_cast<int>(x / static_cast<std::size_t>(scale));
+                if (!qr.getModule(mx - border, my - border))
+                {
+                    row[1 + x / 8] |= static_cast<unsigned char>(0x80 >> (x % 8));
+                }
+            }
+            for (auto i = 0; i < scale; ++i)
+            {
+                std::copy(row.begin(), row.end(), raw.begin() + static_cast<std::ptrdiff_t>((static_cast<std::size_t>(my * scale + i)) * (stride + 1)));
+            }
+        }
+
+        auto compressedSize = compressBound(static_cast<uLong>(raw.size()));
+        std::vector<unsigned char> compressed(compressedSize);
+        if (compress2(compressed.data(), &compressedSize, raw.data(), static_cast<uLong>(raw.size()), Z_BEST_SPEED) != Z_OK)
+        {
+            return false;
+        }
+
+        static const unsigned char signature[] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        out.assign(reinterpret_cast<const char*>(signature), sizeof(signature));
+
+        std::string header;
+        appendBigEndian(header, static_cast<std::uint32_t>(size));
+        appendBigEndian(header, static_cast<std::uint32_t>(size));
+        header.push_back(1); // bit depth
+        header.push_back(0); // greyscale
+        header.push_back(0); // deflate
+        header.push_back(0); // adaptive filtering
+        header.push_back(0); // no interlace
+        appendChunk(out, "IHDR", reinterpret_cast<const unsigned char*>(header.data()), header.size());
+        appendChunk(out, "IDAT", compressed.data(), compressedSize);
+        appendChunk(out, "IEND", nullptr, 0);
+
+        return true;
+    }
+
+    // labels may contain characters which aren't allowed in file names
+    static std::string fileName(const std::string &label)
+    {
+        std::string name;
+        name.reserve(label.size());
+        for (unsigned char c : label)
+        {
+            if (c < 0x20 || c == '/' || c == '\\' || c == ':' || c == '*' || c == '?' || c == '"' || c == '<' || c == '>' || c == '|')
+            {
+                name.push_back('_');
+            }
+            else
+            {
+                name.push_back(static_cast<char>(c));
+            }
+        }
+        if (name.empty() || name == "." || name == "..")
+        {
+            name.insert(0, "token");
+        }
+        return name;
+    }
+}
+
+namespace {
+    // mask = -1 picks the mask with the lowest penalty score; that evaluates
+    // all eight masks and takes about 90% of the encoding time
+    static bool render(const std::string &input, const QRCode::ImageFormat &format, std::string &out,
+                       const int &scale, const int &border, const int &mask)
+    {
+        // empty data can't be and should not be encoded
+        if (input.empty() || scale < 1 || border < 0)
+        {
+            return false;
+        }
+
+        try {
+            const auto qr = qrcodegen::QrCode::encodeSegments(qrcodegen::QrSegment::makeSegments(input.c_str()),
+                                                              qrcodegen::QrCode::Ecc::QUARTILE, 1, 40, mask, true);
+            if (format == QRCode::SVG)
+            {
+                out = qr.toSvgString(border);
+                return true;
+            }
+            return encodePNG(qr, scale, border, out);
+        } catch (...) {
+            // input too long for a QR code
+            return false;
+        }
+    }
+
+    // every mask is valid and decodable, the bulk exporter skips the penalty evaluation
+    static const int BATCH_MASK = 2;
+}
+
+bool QRCode::encode(const std::string &input, const ImageFormat &format, std::string &out, const int &scale, const int &border)
+{
+    return render(input, format, out, scale, border, -1);
+}
+
+std::size_t QRCode::encodeBatch(const std::vector<EncodeItem> &items, const ImageFormat &format,
+                                const unsigned &threads, const int &scale, const int &border)
+{
+    std::atomic<std::size_t> written{0};
+
+    ParallelFor::run(items.size(), [&](const std::size_t &i) {
+        std::string image;
+        if (!render(items[i].text, format, image, scale, border, BATCH_MASK))
+        {
+            return;
+        }
+
+        std::ofstream stream(items[i].file, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+        if (stream.write(image.data(), static_cast<std::streamsize>(image.size())))
+        {
+            ++written;
+        }
+    }, threads, 16);
+
+    return written;
+}
+
+std::size_t QRCode::exportTokens(const std::string &directory, const ImageFormat &format,
+                                 const std::vector<ExportItem> &tokens, const unsigned &threads)
+{
+    const std::string extension = format == SVG ? ".svg" : ".png";
+
+    std::vector<EncodeItem> items;
+    items.reserve(tokens.size());
+    std::unordered_set<std::string> used;
+
+    // labels are unique case-insensitive, but may collide after replacing characters,
+    // file names are compared case-insensitive too
+    const auto unused = [&](const std::string &name) {
+        auto folded = name;
+        std::transform(folded.begin(), folded.end(), folded.begin(), [](unsigned char c) {
+            return static_cast<char>(std::tolower(c));
+        });
+        return used.emplace(std::move(folded)).second;
+    };
+
+    for (auto&& token : tokens)
+    {
+        const auto base = fileName(token.label);
+        auto name = base;
+        for (std::size_t n = 1; !unused(name); ++n)
+        {
+            // a label may already end with the suffix of another one
+            name = base + "-" + std::to_string(token.id);
+            if (n > 1)
+            {
+                name += "-" + std::to_string(n);
+            }
+        }
+
+        items.push_back({(std::filesystem::path(directory) / (name + extension)).string(), token.uri});
+    }
+
+    return encodeBatch(items, format, threads);
+}
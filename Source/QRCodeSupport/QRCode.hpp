@@ -1,7 +1,10 @@
 #ifndef QRCODE_HPP
 #define QRCODE_HPP
 
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 class QRCode
 {
@@ -11,8 +14,70 @@ public:
     // input from file, output to memory buffer
     static bool decode(const std::string &filename, std::string &data);
 
+    // memory layout of a pixel in raw image buffers
+    enum PixelFormat {
+        Grey8,  // 1 byte luminance
+        RGB24,  // R, G, B
+        RGBA32, // R, G, B, A
+        BGRA32, // B, G, R, A (QImage::Format_ARGB32 and Format_RGB32 on little-endian)
+    };
+
+    // input from raw pixels, stride is the number of bytes per row;
+    // the buffer is read in place and must stay valid during the call
+    static bool decode(const std::uint8_t *pixels, const int &width, const int &height, const int &stride,
+                       const PixelFormat &format, std::string &data);
+
+    // input from an encoded PNG or JPEG image in memory, the format is detected from its signature
+    static bool decodeEncoded(const std::uint8_t *buffer, const std::size_t &size, std::string &data);
+
+    struct DecodeResult {
+        std::string file;
+        std::vector<std::string> codes; // every QR code found in the image
+
+        inline bool success() const
+        { return !codes.empty(); }
+    };
+    using DecodeResults = std::vector<DecodeResult>;
+
+    // decodes the images on a thread pool, results are in input order;
+    // threads = 0 uses one worker per hardware thread
+    static DecodeResults decodeBatch(const std::vector<std::string> &files, const unsigned &threads = 0);
+
+    // decodes all png and jpeg images of the directory (not recursive), sorted by file name
+    static DecodeResults decodeDirectory(const std::string &directory, const unsigned &threads = 0);
+
     // input from memory buffer, output to memory buffer
     static bool encode(const std::string &input, std::string &out);
+
+    enum ImageFormat {
+        PNG,
+        SVG,
+    };
+
+    // input from memory buffer, output to an encoded image in memory;
+    // scale is the size of a module in pixels (PNG only), border the quiet zone in modules
+    static bool encode(const std::string &input, const ImageFormat &format, std::string &out,
+                       const int &scale = 4, const int &border = 3);
+
+    struct EncodeItem {
+        std::string file;
+        std::string text;
+    };
+
+    // renders and writes the images on a thread pool, returns the number of written files
+    static std::size_t encodeBatch(const std::vector<EncodeItem> &items, const ImageFormat &format,
+                                   const unsigned &threads = 0, const int &scale = 4, const int &border = 3);
+
+    struct ExportItem {
+        std::int64_t id; // appended to the file name when the label collides
+        std::string label;
+        std::string uri;
+    };
+
+    // writes the otpauth URI of every item as "<label>.png" or "<label>.svg" into
+    // the existing directory, returns the number of written files
+    static std::size_t exportTokens(const std::string &directory, const ImageFormat &format,
+                                    const std::vector<ExportItem> &tokens, const unsigned &threads = 0);
 };
 
 #endif // QRCODE_HPP
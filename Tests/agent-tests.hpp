@@ -0,0 +1,142 @@
+#ifndef AGENTTESTS_HPP
+#define AGENTTESTS_HPP
+
+#include <bandit/bandit.h>
+
+using namespace snowhouse;
+using namespace bandit;
+
+#include <Agent.hpp>
+#include <TokenDatabase.hpp>
+#include "token-database-fixture.hpp"
+
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+go_bandit([]{
+    describe("Agent Test", []{
+        it("[command line arguments]", [&]{
+            Agent::Command command;
+            AssertThat(Agent::commandFromArguments({"otpgen-cli", "--code", "label"}, command), Equals(true));
+            AssertThat(command, EqualsContainer(Agent::Command{"code", "label"}));
+            AssertThat(Agent::commandFromArguments({"otpgen-cli", "--move", "a", "3"}, command), Equals(true));
+            AssertThat(command, EqualsContainer(Agent::Command{"move", "a", "3"}));
+            AssertThat(Agent::commandFromArguments({"otpgen-cli", "--stop-agent"}, command), Equals(true));
+            AssertThat(command, EqualsContainer(Agent::Command{"stop"}));
+
+            AssertThat(Agent::commandFromArguments({"otpgen-cli"}, command), Equals(false));
+            AssertThat(Agent::commandFromArguments({"otpgen-cli", "--code"}, command), Equals(false));
+            AssertThat(Agent::commandFromArguments({"otpgen-cli", "--list", "extra"}, command), Equals(false));
+            AssertThat(Agent::commandFromArguments({"otpgen-cli", "--unknown"}, command), Equals(false));
+        });
+
+        it("[peer credentials]", [&]{
+            int pair[2];
+            AssertThat(::socketpair(AF_UNIX, SOCK_STREAM, 0, pair), Equals(0));
+            AssertThat(Agent::trustedPeer(pair[0]), Equals(true));
+            ::close(pair[0]);
+            ::close(pair[1]);
+
+            // not a socket
+            int pipes[2];
+            AssertThat(::pipe(pipes), Equals(0));
+            AssertThat(Agent::trustedPeer(pipes[0]), Equals(false));
+            ::close(pipes[0]);
+            ::close(pipes[1]);
+        });
+
+        it("[socket protocol]", [&]{
+            // the agent changes into the root directory
+            char cwd[PATH_MAX];
+            AssertThat(::getcwd(cwd, sizeof(cwd)) != nullptr, Equals(true));
+            const std::string socket = std::string(cwd) + "/agent-test.socket";
+            const auto path = createTestDatabase("agent", cwd);
+            AssertThat(TokenDatabase::insertTokens({
+                OTPToken(OTPToken::TOTP, "a", OTPToken::Icon(), "JBSWY3DPEHPK3PXP"),
+                OTPToken(OTPToken::HOTP, "h", OTPToken::Icon(), "JBSWY3DPEHPK3PXP"),
+                OTPToken(OTPToken::TOTP, "b", OTPToken::Icon(), "JBSWY3DPEHPK3PXP"),
+            }), Equals(TokenDatabase::Success));
+            AssertThat(TokenDatabase::saveTokens(), Equals(TokenDatabase::Success));
+
+            Agent::Response response;
+            AssertThat(Agent::request(socket, {"list"}, response), Equals(false));
+
+            // forks, the child serves until stopped
+            AssertThat(Agent::start(socket, 60), Equals(0));
+
+            AssertThat(Agent::request(socket, {"list"}, response), Equals(true));
+            AssertThat(response.success, Equals(true));
+            AssertThat(response.output, Equals("a\nh\nb\n"));
+
+            AssertThat(Agent::request(socket, {"code", "missing"}, response), Equals(true));
+            AssertThat(response.success, Equals(false));
+            AssertThat(Agent::request(socket, {"bogus"}, response), Equals(true));
+            AssertThat(response.success, Equals(false));
+
+            // fields can't contain the protocol separators
+            AssertThat(Agent::request(socket, {"code", "a\tb"}, response), Equals(false));
+
+            // every HOTP code is handed out once
+            OTPToken hotp(OTPToken::HOTP, "h", OTPToken::Icon(), "JBSWY3DPEHPK3PXP");
+            for (OTPToken::CounterType counter = 0; counter < 2; ++counter)
+            {
+                hotp.setCounter(counter);
+                AssertThat(Agent::request(socket, {"code", "h"}, response), Equals(true));
+                AssertThat(response.success, Equals(true));
+                AssertThat(response.output, Equals(hotp.generateToken() + "\n"));
+            }
+
+            // changes of other processes are picked up and not overwritten
+            AssertThat(TokenDatabase::loadTokens(), Equals(TokenDatabase::Success));
+            AssertThat(TokenDatabase::selectToken("h").counter(), Equals(2U));
+            AssertThat(TokenDatabase::insertToken(OTPToken(OTPToken::TOTP, "c", OTPToken::Icon(), "JBSWY3DPEHPK3PXP")), Equals(TokenDatabase::Success));
+            AssertThat(TokenDatabase::saveTokens(), Equals(TokenDatabase::Success));
+
+            AssertThat(Agent::request(socket, {"swap", "a", "b"}, response), Equals(true));
+            AssertThat(response.success, Equals(true));
+
+            AssertThat(TokenDatabase::loadTokens(), Equals(TokenDatabase::Success));
+            std::string labels;
+            TokenDatabase::forEachToken([&](const OTPToken &token) {
+                labels += token.label() + " ";
+            });
+            AssertThat(labels, Equals("b h a c "));
+
+            // same-size writes within the same second are picked up by reading commands
+            AssertThat(Agent::request(socket, {"list"}, response), Equals(true));
+            auto renamed = TokenDatabase::selectToken("c");
+            renamed.setLabel("d");
+            AssertThat(TokenDatabase::updateToken(renamed.id(), renamed), Equals(TokenDatabase::Success));
+            AssertThat(TokenDatabase::saveTokens(), Equals(TokenDatabase::Success));
+            AssertThat(Agent::request(socket, {"list"}, response), Equals(true));
+            AssertThat(response.output, Equals("b\nh\na\nd\n"));
+
+            // stopping works without a readable database
+            std::remove(path.c_str());
+            AssertThat(Agent::request(socket, {"list"}, response), Equals(true));
+            AssertThat(response.success, Equals(false));
+            AssertThat(Agent::request(socket, {"stop"}, response), Equals(true));
+            AssertThat(response.success, Equals(true));
+
+            // the agent removes its socket on exit
+            auto stopped = false;
+            for (auto i = 0; i < 100 && !stopped; ++i)
+            {
+                stopped = !Agent::request(socket, {"list"}, response);
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+            AssertThat(stopped, Equals(true));
+
+            TokenDatabase::closeDatabase();
+            std::remove(path.c_str());
+        });
+    });
+});
+
+#endif // AGENTTESTS_HPP
@@ -0,0 +1,135 @@
+#ifndef APPSUPPORTTESTS_HPP
+#define APPSUPPORTTESTS_HPP
+
+#include <bandit/bandit.h>
+
+using namespace snowhouse;
+using namespace bandit;
+
+#include <AppSupport.hpp>
+#include <TokenDatabase.hpp>
+#include "token-database-fixture.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
+static void writeTestFile(const std::string &file, const std::string &contents)
+{
+    std::ofstream out(file, std::ios::out | std::ios::binary | std::ios::trunc);
+    out << contents;
+}
+
+go_bandit([]{
+    describe("AppSupport Test", []{
+        it("[andOTP encrypted round trip]", [&]{
+            const std::string file = "andotp.appsupport-test.json.aes";
+
+            OTPToken totp(OTPToken::TOTP, "Escaped \"label\"", {}, "HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ");
+            OTPToken steam(OTPToken::Steam, "Steam", {}, "JBSWY3DPEHPK3PXP");
+            AssertThat(AppSupport::andOTP::exportTokens(file, {&totp, &steam}, AppSupport::andOTP::Encrypted, "secret"), Equals(true));
+
+            std::vector<OTPToken*> tokens;
+            AssertThat(AppSupport::andOTP::importTokens(file, tokens, AppSupport::andOTP::Encrypted, "wrong"), Equals(false));
+            AssertThat(AppSupport::andOTP::importTokens(file, tokens, AppSupport::andOTP::Encrypted, "secret"), Equals(true));
+            AssertThat(tokens.size(), Equals(2U));
+            AssertThat(tokens.at(0)->label(), Equals(totp.label()));
+            AssertThat(tokens.at(0)->secret(), Equals(totp.secret()));
+            AssertThat(tokens.at(1)->type(), Equals(OTPToken::Steam));
+
+            for (auto&& token : tokens) delete token;
+            std::remove(file.c_str());
+        });
+
+        it("[andOTP database export]", [&]{
+            const std::string file = "andotp.appsupport-test.json.aes";
+            const auto path = createTestDatabase("appsupport");
+            insertTestTokens(500, "HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ");
+            AssertThat(TokenDatabase::insertToken(OTPToken(OTPToken::HOTP, "hotp", OTPToken::Icon(), "JBSWY3DPEHPK3PXP", 8, 0, 42, OTPToken::SHA256)), Equals(TokenDatabase::Success));
+
+            AssertThat(AppSupport::andOTP::exportDatabase(file, AppSupport::andOTP::Encrypted, "secret"), Equals(true));
+            TokenDatabase::closeDatabase();
+
+            std::vector<OTPToken*> imported;
+            AssertThat(AppSupport::andOTP::importTokens(file, imported, AppSupport::andOTP::Encrypted, "secret"), Equals(true));
+            AssertThat(imported.size(), Equals(501U));
+            AssertThat(imported.at(7)->label(), Equals(std::string("token 7")));
+            AssertThat(imported.at(500)->counter(), Equals(42U));
+            AssertThat(imported.at(500)->digitLength(), Equals(8U));
+            AssertThat(imported.at(500)->algorithm(), Equals(OTPToken::SHA256));
+
+            for (auto&& token : imported) delete token;
+            std::remove(file.c_str());
+            std::remove(path.c_str());
+        });
+
+        it("[andOTP failed export]", [&]{
+            // the previous export stays intact when writing fails
+            const std::string file = "andotp.appsupport-test.json";
+            writeTestFile(file, "previous");
+            TokenDatabase::closeDatabase();
+            AssertThat(AppSupport::andOTP::exportDatabase(file, AppSupport::andOTP::PlainText), Equals(false));
+
+            std::ifstream in(file, std::ios::in | std::ios::binary);
+            const std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            AssertThat(contents, Equals("previous"));
+            AssertThat(std::ifstream(file + ".tmp").good(), Equals(false));
+
+            std::remove(file.c_str());
+        });
+
+        it("[otpauth list failed export]", [&]{
+            const std::string file = "otpauth.appsupport-test.txt";
+            writeTestFile(file, "previous");
+            TokenDatabase::closeDatabase();
+            AssertThat(AppSupport::otpauthList::exportDatabase(file), Equals(false));
+
+            std::ifstream in(file, std::ios::in | std::ios::binary);
+            const std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            AssertThat(contents, Equals("previous"));
+            AssertThat(std::ifstream(file + ".tmp").good(), Equals(false));
+
+            std::remove(file.c_str());
+        });
+
+        it("[andOTP page sized file]", [&]{
+            // files ending on a page boundary can't be null-terminated by the mapping
+            const std::string file = "andotp.appsupport-test.json";
+            std::string json = R"([{"secret":"JBSWY3DPEHPK3PXP","label":"Page","period":30,"digits":6,"type":"TOTP","algorithm":"SHA1"}])";
+            json.append(4096 - json.size(), ' ');
+            writeTestFile(file, json);
+
+            std::vector<OTPToken*> tokens;
+            AssertThat(AppSupport::andOTP::importTokens(file, tokens), Equals(true));
+            AssertThat(tokens.size(), Equals(1U));
+            AssertThat(tokens.at(0)->label(), Equals(std::string("Page")));
+
+            for (auto&& token : tokens) delete token;
+            std::remove(file.c_str());
+        });
+
+        it("[Authy XML]", [&]{
+            const std::string file = "authy.appsupport-test.xml";
+            writeTestFile(file,
+                "<?xml version='1.0' encoding='utf-8' standalone='yes' ?>\n"
+                "<map>\n"
+                "    <string name=\"com.authy.storage.tokens.authenticator.key\">"
+                "[{&quot;decryptedSecret&quot;:&quot;JBSWY3DPEHPK3PXP&quot;,&quot;digits&quot;:6,&quot;name&quot;:&quot;A &amp; B&quot;},"
+                "{&quot;decryptedSecret&quot;:&quot;HXDMVJECJJWSRB3H&quot;,&quot;digits&quot;:7,&quot;name&quot;:&quot;Second&quot;}]"
+                "</string>\n"
+                "</map>\n");
+
+            std::vector<OTPToken> tokens;
+            AssertThat(AppSupport::Authy::importNative(file, tokens, AppSupport::Authy::XML), Equals(false));
+            AssertThat(AppSupport::Authy::importTOTP(file, tokens, AppSupport::Authy::XML), Equals(true));
+            AssertThat(tokens.size(), Equals(2U));
+            AssertThat(tokens.at(0).label(), Equals(std::string("A & B")));
+            AssertThat(tokens.at(0).secret(), Equals(std::string("JBSWY3DPEHPK3PXP")));
+            AssertThat(tokens.at(1).digitLength(), Equals(7U));
+
+            std::remove(file.c_str());
+        });
+    });
+});
+
+#endif // APPSUPPORTTESTS_HPP
@@ -0,0 +1,77 @@
+#ifndef CODEPUBLISHERTESTS_HPP
+#define CODEPUBLISHERTESTS_HPP
+
+#include <bandit/bandit.h>
+
+using namespace snowhouse;
+using namespace bandit;
+
+#include <CodePublisher.hpp>
+#include <OTPGen.hpp>
+
+go_bandit([]{
+    describe("CodePublisher Test", []{
+        const auto makeTable = []{
+            TokenTable table;
+            table.append(OTPToken(OTPToken::TOTP, "totp", {}, "XYZA123456KDDK83D", 6, 30, 0, OTPToken::SHA1));
+            table.append(OTPToken(OTPToken::TOTP, "totp 7", {}, "XYZA123456KDDK83D28273", 7, 10, 0, OTPToken::SHA1));
+            table.append(OTPToken(OTPToken::HOTP, "hotp", {}, "XYZA123456KDDK83D", 6, 0, 12, OTPToken::SHA1));
+            return table;
+        };
+
+        it("[publish snapshot]", [&]{
+            CodePublisher publisher([]{ return std::time_t(1536573862); });
+            AssertThat(static_cast<bool>(publisher.read()), IsFalse());
+
+            publisher.setTable(makeTable());
+            const auto snapshot = publisher.read();
+
+            AssertThat(snapshot->size(), Equals(3U));
+            AssertThat(snapshot->codes.at(0), Equals(std::string("122810")));
+            AssertThat(snapshot->codes.at(1), Equals(std::string("8578249")));
+            AssertThat(snapshot->codes.at(2), Equals(std::string("534003")));
+            AssertThat(snapshot->remaining(0, 1536573862), Equals(8U));
+            AssertThat(snapshot->remaining(1, 1536573862), Equals(8U));
+            AssertThat(snapshot->remaining(2, 1536573862), Equals(0U));
+            AssertThat(snapshot->table->label(1), Equals(std::string_view("totp 7")));
+        });
+
+        it("[pinned snapshots are reclaimed later]", [&]{
+            CodePublisher publisher([]{ return std::time_t(1536573862); });
+            publisher.setTable(makeTable());
+
+            publisher.update(1536573871);
+
+            {
+                const auto pinned = publisher.read();
+                const auto version = pinned->version;
+
+                // the 10 second token rolls over, the 30 second token doesn't
+                publisher.update(1536573881);
+                AssertThat(publisher.read()->version, Equals(version + 1));
+                AssertThat(publisher.read()->codes.at(0), Equals(pinned->codes.at(0)));
+                AssertThat(publisher.read()->codes.at(1), !Equals(pinned->codes.at(1)));
+
+                // still readable after being replaced
+                AssertThat(pinned->time, Equals(1536573871));
+                AssertThat(pinned->codes.at(1), Equals(OTPGen::computeTOTP(1536573871, "XYZA123456KDDK83D28273", 7, 10, OTPToken::SHA1)));
+                AssertThat(publisher.pendingReclamation(), Equals(1U));
+            }
+
+            publisher.update(1536573882);
+            AssertThat(publisher.pendingReclamation(), Equals(0U));
+        });
+
+        it("[worker thread]", [&]{
+            CodePublisher publisher;
+            publisher.start();
+            publisher.setTable(makeTable());
+            AssertThat(publisher.running(), IsTrue());
+            AssertThat(publisher.read()->size(), Equals(3U));
+            publisher.stop();
+            AssertThat(publisher.running(), IsFalse());
+        });
+    });
+});
+
+#endif // CODEPUBLISHERTESTS_HPP
@@ -0,0 +1,114 @@
+#ifndef IMPORTSINKTESTS_HPP
+#define IMPORTSINKTESTS_HPP
+
+#include <bandit/bandit.h>
+
+using namespace snowhouse;
+using namespace bandit;
+
+#include <ImportSink.hpp>
+#include <TokenDatabase.hpp>
+#include "token-database-fixture.hpp"
+#include <AppSupport/otpauthList.hpp>
+
+#include <cstdio>
+#include <fstream>
+
+go_bandit([]{
+    describe("ImportSink Test", []{
+        it("[andOTP import]", [&]{
+            const std::string backup = "andotp.import-test.json";
+            {
+                std::ofstream out(backup);
+                out << R"([)"
+                    << R"({"secret":"hxdm vjec jjws rb3h","label":" First ","period":30,"digits":6,"type":"TOTP","algorithm":"SHA1"},)"
+                    << R"({"secret":"HXDMVJECJJWSRB3H","label":"Second","counter":5,"digits":8,"type":"HOTP","algorithm":"SHA256"},)"
+                    << R"({"secret":"","label":"Empty","period":30,"digits":6,"type":"TOTP","algorithm":"SHA1"},)"
+                    << R"({"secret":"HXDMVJECJJWSRB3H","label":"FIRST","period":30,"digits":6,"type":"TOTP","algorithm":"SHA1"},)"
+                    << R"({"secret":"JBSWY3DPEHPK3PXP","label":"second","period":30,"digits":6,"type":"TOTP","algorithm":"SHA1"},)"
+                    << R"({"secret":"JBSWY3DPEHPK3PXP","label":"Third","period":0,"digits":0,"type":"TOTP","algorithm":"SHA1"})"
+                    << R"(])";
+            }
+
+            const auto path = createTestDatabase("import");
+
+            ImportSink sink;
+            AssertThat(AppSupport::andOTP::importTokens(backup, sink), Equals(true));
+            AssertThat(sink.size(), Equals(6U));
+
+            std::size_t validated = 0, inserted = 0;
+            sink.setProgressCallback([&](const ImportSink::Phase &phase, std::size_t done, std::size_t) {
+                if (phase == ImportSink::Validating) validated = done;
+                if (phase == ImportSink::Inserting) inserted = done;
+            });
+
+            AssertThat(sink.commit(), Equals(TokenDatabase::Success));
+            AssertThat(sink.size(), Equals(0U));
+            AssertThat(validated, Equals(6U));
+            AssertThat(inserted, Equals(3U));
+
+            const auto &stats = sink.statistics();
+            AssertThat(stats.received, Equals(6U));
+            AssertThat(stats.imported, Equals(3U));
+            AssertThat(stats.invalid, Equals(1U));
+            AssertThat(stats.duplicates, Equals(1U));
+            AssertThat(stats.conflicts, Equals(1U));
+
+            const auto first = TokenDatabase::selectToken("First");
+            AssertThat(first.secret(), Equals(std::string("HXDMVJECJJWSRB3H")));
+            AssertThat(TokenDatabase::selectToken("Second").counter(), Equals(5U));
+            AssertThat(TokenDatabase::selectToken("Third").period(), Equals(30U));
+            AssertThat(TokenDatabase::displayOrder().size(), Equals(3U));
+            TokenDatabase::closeDatabase();
+
+            // committed and saved at once, a second import only finds duplicates
+            AssertThat(TokenDatabase::loadTokens(), Equals(TokenDatabase::Success));
+            AssertThat(TokenDatabase::tokenCount(), Equals(3));
+            AssertThat(AppSupport::andOTP::importTokens(backup, sink), Equals(true));
+            AssertThat(sink.commit(), Equals(TokenDatabase::Success));
+            AssertThat(sink.statistics().imported, Equals(0U));
+            AssertThat(sink.statistics().duplicates, Equals(4U));
+            AssertThat(TokenDatabase::tokenCount(), Equals(3));
+            TokenDatabase::closeDatabase();
+
+            std::remove(backup.c_str());
+            std::remove(path.c_str());
+        });
+
+        it("[otpauth list round trip]", [&]{
+            const std::string list = "otpauth.import-test.txt";
+            const auto path = createTestDatabase("import");
+            insertTestTokens(2000, "HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ");
+            AssertThat(TokenDatabase::insertToken(OTPToken(OTPToken::HOTP, "ACME & Co", OTPToken::Icon(), "JBSWY3DPEHPK3PXP", 8, 0, 0x100000000, OTPToken::SHA512)), Equals(TokenDatabase::Success));
+            AssertThat(AppSupport::otpauthList::exportDatabase(list), Equals(true));
+            TokenDatabase::closeDatabase();
+            std::remove(path.c_str());
+
+            {
+                std::ofstream out(list, std::ios::app);
+                out << "otpauth://hotp/no-counter?secret=JBSWY3DPEHPK3PXP\n";
+            }
+
+            AssertThat(TokenDatabase::initializeTokens(), Equals(TokenDatabase::Success));
+            ImportSink sink;
+            AssertThat(AppSupport::otpauthList::importTokens(list, sink), Equals(true));
+            AssertThat(sink.commit(false), Equals(TokenDatabase::Success));
+            AssertThat(sink.statistics().received, Equals(2002U));
+            AssertThat(sink.statistics().imported, Equals(2001U));
+            AssertThat(sink.statistics().invalid, Equals(1U));
+
+            const auto hotp = TokenDatabase::selectToken("ACME & Co");
+            AssertThat(hotp.type(), Equals(OTPToken::HOTP));
+            AssertThat(hotp.counter(), Equals(0x100000000U));
+            AssertThat(hotp.digitLength(), Equals(8U));
+            AssertThat(hotp.algorithm(), Equals(OTPToken::SHA512));
+            AssertThat(TokenDatabase::displayOrder().back(), Equals(hotp.id()));
+            TokenDatabase::closeDatabase();
+
+            std::remove(list.c_str());
+            std::remove(path.c_str());
+        });
+    });
+});
+
+#endif // IMPORTSINKTESTS_HPP
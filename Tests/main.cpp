@@ -14,6 +14,20 @@ using namespace bandit;
 #include "otpauth-tests.hpp"
 #include "steam-base-test.hpp"
 #include "otpgen-tests.hpp"
+#include "token-catalog-tests.hpp"
+#include "schema-migration-tests.hpp"
+#include "import-sink-tests.hpp"
+#include "profiler-tests.hpp"
+#include "statement-profiler-tests.hpp"
+#include "secure-allocator-tests.hpp"
+#include "token-table-tests.hpp"
+#include "code-publisher-tests.hpp"
+#include "appsupport-tests.hpp"
+#include "vault-key-tests.hpp"
+
+#ifdef OTPGEN_WITH_AGENT
+#include "agent-tests.hpp"
+#endif
 
 int main(int argc, char **argv)
 {
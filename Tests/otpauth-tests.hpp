@@ -7,6 +7,7 @@ using namespace snowhouse;
 using namespace bandit;
 
 #include <otpauthURI.hpp>
+#include <otpauthURIView.hpp>
 
 #include <OTPToken.hpp>
 
@@ -50,6 +51,55 @@ go_bandit([]{
             AssertThat(uri.label(), Equals(std::string("Label with space")));
             AssertThat(uri.to_s(), Equals(std::string("otpauth://hotp/Label%20with%20space?secret=HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ&digits=6&period=0&counter=0&algorithm=SHA1")));
         });
+
+        it("[percent encoding]", [&]{
+            OTPToken totp(OTPToken::TOTP, "M\xC3\xBCller & Co/100%");
+            totp.setSecret("HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ");
+            const auto uri = otpauthURI::fromOtpToken(&totp);
+            AssertThat(uri.to_s().substr(0, 50), Equals(std::string("otpauth://totp/M%C3%BCller%20%26%20Co%2F100%25?sec")));
+            AssertThat(uri.label(), Equals(totp.label()));
+
+            // malformed escapes are kept as-is
+            otpauthURI malformed("otpauth://totp/a%2x+b%?secret=JBSWY3DPEHPK3PXP");
+            AssertThat(malformed.valid(), Equals(true));
+            AssertThat(malformed.label(), Equals(std::string("a%2x b%")));
+        });
+
+        it("[parse many]", [&]{
+            const auto uris = otpauthURI::parseMany(
+                "otpauth://totp/first?secret=JBSWY3DPEHPK3PXP\r\n"
+                "\n"
+                "otpauth://hotp/missing-counter?secret=JBSWY3DPEHPK3PXP\n"
+                "otpauth://hotp/second?secret=JBSWY3DPEHPK3PXP&counter=5&secret=ignored", 2);
+            AssertThat(uris.size(), Equals(3U));
+            AssertThat(uris.at(0).valid(), Equals(true));
+            AssertThat(uris.at(0).label(), Equals(std::string("first")));
+            AssertThat(uris.at(1).valid(), Equals(false));
+            AssertThat(uris.at(2).valid(), Equals(true));
+            AssertThat(uris.at(2).counterNumber(), Equals(5U));
+            AssertThat(uris.at(2).secret(), Equals(std::string("JBSWY3DPEHPK3PXP")));
+        });
+
+        it("[many parameters]", [&]{
+            // parameters after the fixed array aren't dropped
+            std::string uri = "otpauth://totp/label?";
+            for (auto i = 0U; i < otpauthURIView::MaxParams; ++i)
+            {
+                uri += "x" + std::to_string(i) + "=" + std::to_string(i) + "&";
+            }
+            uri += "secret=JBSWY3DPEHPK3PXP&digits=8";
+
+            otpauthURIView view;
+            AssertThat(view.parse(uri), Equals(true));
+            AssertThat(view.paramCount(), Equals(otpauthURIView::MaxParams + 2));
+            AssertThat(view.paramAt(otpauthURIView::MaxParams + 1).key, Equals(std::string_view("digits")));
+            AssertThat(view.param("secret"), Equals(std::string_view("JBSWY3DPEHPK3PXP")));
+
+            otpauthURI parsed(uri);
+            AssertThat(parsed.valid(), Equals(true));
+            AssertThat(parsed.secret(), Equals(std::string("JBSWY3DPEHPK3PXP")));
+            AssertThat(parsed.digitsNumber(), Equals(8U));
+        });
     });
 });
 
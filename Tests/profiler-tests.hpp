@@ -0,0 +1,86 @@
+#ifndef PROFILERTESTS_HPP
+#define PROFILERTESTS_HPP
+
+#include <bandit/bandit.h>
+
+using namespace snowhouse;
+using namespace bandit;
+
+#include <Profiler.hpp>
+#include <TokenDatabase.hpp>
+#include "token-database-fixture.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+go_bandit([]{
+    describe("Profiler Test", []{
+        it("[unlock phases]", [&]{
+            const std::string trace = "profiler-test.trace.json";
+            const auto path = createTestDatabase("profiler");
+            TokenDatabase::closeDatabase();
+
+            // nothing is recorded while disabled
+            Profiler::setEnabled(false);
+            Profiler::clear();
+            AssertThat(TokenDatabase::loadTokens(), Equals(TokenDatabase::Success));
+            AssertThat(Profiler::phases().empty(), Equals(true));
+            TokenDatabase::closeDatabase();
+
+            // phases are reported in order
+            std::vector<TokenDatabase::LoadPhase> reported;
+            Profiler::setEnabled(true);
+            AssertThat(TokenDatabase::loadTokens([&](const TokenDatabase::LoadPhase &phase) {
+                reported.push_back(phase);
+            }), Equals(TokenDatabase::Success));
+            AssertThat(reported, EqualsContainer(std::vector<TokenDatabase::LoadPhase>{
+                TokenDatabase::LoadReading, TokenDatabase::LoadDecrypting, TokenDatabase::LoadDeserializing,
+                TokenDatabase::LoadMigrating, TokenDatabase::LoadValidating}));
+            TokenDatabase::selectTokens();
+            TokenDatabase::selectTokens();
+            Profiler::setEnabled(false);
+            TokenDatabase::closeDatabase();
+
+            const auto phases = Profiler::phases();
+            const auto find = [&](const std::string &name) {
+                return std::find_if(phases.begin(), phases.end(), [&](const Profiler::Phase &p) { return p.name == name; });
+            };
+
+            for (auto&& name : {"loadTokens", "readFile", "decrypt",
+                                "deserializeDatabase", "getDatabaseVersion", "selectTokens"})
+            {
+                AssertThat(find(name) != phases.end(), Equals(true));
+            }
+
+            // the key is derived by setPassword(), not on every unlock
+            AssertThat(find("key derivation") == phases.end(), Equals(true));
+            AssertThat(std::count_if(phases.begin(), phases.end(), [](const Profiler::Phase &p) {
+                return p.name == "selectTokens";
+            }), Equals(1));
+
+            // ordered by start, nested phases follow their parent
+            AssertThat(phases.front().name, Equals(std::string("loadTokens")));
+            AssertThat(find("readFile")->depth, Equals(find("loadTokens")->depth + 1));
+            AssertThat(find("decrypt")->depth, Equals(find("loadTokens")->depth + 1));
+            AssertThat(find("readFile")->bytes, IsGreaterThan(0U));
+            AssertThat(find("readFile")->bytes, Equals(find("decrypt")->bytes));
+            AssertThat(find("deserializeDatabase")->bytes, IsGreaterThan(0U));
+
+            AssertThat(Profiler::report(), Contains("decrypt"));
+
+            AssertThat(Profiler::writeChromeTrace(trace), Equals(true));
+            std::ifstream in(trace);
+            const std::string json((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            AssertThat(json, StartsWith("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+            AssertThat(json, Contains("\"name\":\"deserializeDatabase\",\"cat\":\"startup\",\"ph\":\"X\""));
+
+            std::remove(trace.c_str());
+            std::remove(path.c_str());
+        });
+    });
+});
+
+#endif // PROFILERTESTS_HPP
@@ -7,6 +7,16 @@ using namespace snowhouse;
 using namespace bandit;
 
 #include <QRCode.hpp>
+#include <TokenDatabase.hpp>
+#include "token-database-fixture.hpp"
+#include <otpauthURI.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <vector>
 
 go_bandit([]{
     describe("QRCode Test", []{
@@ -37,6 +47,100 @@ go_bandit([]{
             AssertThat(res, Equals(false));
             AssertThat(data, Equals(std::string()));
         });
+
+        it("[decode from memory]", [&]{
+            const auto decodeFile = [](const std::string &file, std::string &data) {
+                std::ifstream in(file, std::ios::binary);
+                const std::vector<std::uint8_t> buffer{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+                return QRCode::decodeEncoded(buffer.data(), buffer.size(), data);
+            };
+
+            std::string data;
+            AssertThat(decodeFile("QRCodes/valid.png", data), Equals(true));
+            AssertThat(data, Equals(std::string("otpauth://totp/Example:alice@google.com?secret=JBSWY3DPEHPK3PXP&issuer=Example")));
+            AssertThat(decodeFile("QRCodes/valid.jpg", data), Equals(true));
+            AssertThat(data, Equals(std::string("otpauth://totp/Example:alice@google.com?secret=JBSWY3DPEHPK3PXP&issuer=Example")));
+
+            const std::uint8_t garbage[] = {0x89, 'P', 'N', 'G', 0x00};
+            AssertThat(QRCode::decodeEncoded(garbage, sizeof(garbage), data), Equals(false));
+            AssertThat(data, Equals(std::string()));
+
+            // blank image and a stride smaller than a row
+            const std::vector<std::uint8_t> blank(64 * 64 * 4, 0xFF);
+            AssertThat(QRCode::decode(blank.data(), 64, 64, 64 * 4, QRCode::BGRA32, data), Equals(false));
+            AssertThat(QRCode::decode(blank.data(), 64, 64, 64, QRCode::RGB24, data), Equals(false));
+        });
+
+        it("[encode PNG]", [&]{
+            const std::string uri = "otpauth://totp/ACME%20Co:john.doe@email.com?secret=HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ";
+            std::string png;
+            AssertThat(QRCode::encode(uri, QRCode::PNG, png), Equals(true));
+            AssertThat(png.substr(1, 3), Equals(std::string("PNG")));
+
+            std::string data;
+            AssertThat(QRCode::decodeEncoded(reinterpret_cast<const std::uint8_t*>(png.data()), png.size(), data), Equals(true));
+            AssertThat(data, Equals(uri));
+
+            AssertThat(QRCode::encode(std::string(), QRCode::PNG, png), Equals(false));
+        });
+
+        it("[export tokens]", [&]{
+            const std::string directory = "qr-code-test-export";
+            std::filesystem::create_directory(directory);
+            const auto path = createTestDatabase("qr-code");
+
+            TokenDatabase::OTPTokenList tokens;
+            tokens.emplace_back(OTPToken::TOTP, "a/b", OTPToken::Icon(), "HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ");
+            tokens.emplace_back(OTPToken::TOTP, "a:b", OTPToken::Icon(), "JBSWY3DPEHPK3PXP");
+            tokens.emplace_back(OTPToken::HOTP, "hotp", OTPToken::Icon(), "JBSWY3DPEHPK3PXP", 6, 0, 1, OTPToken::SHA1);
+            tokens.emplace_back(OTPToken::TOTP, "A_B-2", OTPToken::Icon(), "JBSWY3DPEHPK3PXP");
+            AssertThat(TokenDatabase::insertTokens(tokens), Equals(TokenDatabase::Success));
+
+            const auto exportItems = [](const OTPToken::sqliteTypesID &type) {
+                std::vector<QRCode::ExportItem> items;
+                TokenDatabase::forEachToken([&](const OTPToken &token) {
+                    std::string uri;
+                    if (otpauthURI::write(token, uri))
+                    {
+                        items.push_back({token.id(), token.label(), uri});
+                    }
+                }, type);
+                return items;
+            };
+
+            AssertThat(QRCode::exportTokens(directory, QRCode::PNG, exportItems(OTPToken::None)), Equals(4U));
+            AssertThat(QRCode::exportTokens(directory, QRCode::SVG, exportItems(OTPToken::HOTP)), Equals(1U));
+            TokenDatabase::closeDatabase();
+
+            // the suffixed names are unique too, SVG exports are skipped by the decoder
+            AssertThat(std::filesystem::exists(directory + "/hotp.svg"), Equals(true));
+            const auto results = QRCode::decodeDirectory(directory);
+            AssertThat(results.size(), Equals(4U));
+            AssertThat(results.at(0).file, Equals(directory + "/A_B-2-4.png"));
+            AssertThat(results.at(1).file, Equals(directory + "/a_b-2.png"));
+            AssertThat(results.at(1).codes.at(0), Equals(std::string("otpauth://totp/a%3Ab?secret=JBSWY3DPEHPK3PXP&digits=6&period=30&algorithm=SHA1")));
+            AssertThat(results.at(2).file, Equals(directory + "/a_b.png"));
+            AssertThat(results.at(3).success(), Equals(true));
+
+            std::filesystem::remove_all(directory);
+            std::remove(path.c_str());
+        });
+
+        it("[batch decode]", [&]{
+            const auto results = QRCode::decodeBatch({"QRCodes/valid.png", "QRCodes/nosuchfile", "QRCodes/valid.jpg"}, 2);
+            AssertThat(results.size(), Equals(3U));
+            AssertThat(results.at(0).success(), Equals(true));
+            AssertThat(results.at(0).codes.size(), Equals(1U));
+            AssertThat(results.at(0).codes.at(0), Equals(std::string("otpauth://totp/Example:alice@google.com?secret=JBSWY3DPEHPK3PXP&issuer=Example")));
+            AssertThat(results.at(1).file, Equals(std::string("QRCodes/nosuchfile")));
+            AssertThat(results.at(1).success(), Equals(false));
+            AssertThat(results.at(2).codes, Equals(results.at(0).codes));
+
+            const auto directory = QRCode::decodeDirectory("QRCodes");
+            AssertThat(directory.size(), Equals(3U));
+            AssertThat(directory.at(0).file, Equals(std::string("QRCodes/invalid.png")));
+            AssertThat(directory.at(0).codes.at(0), Equals(std::string("test")));
+        });
     });
 });
 
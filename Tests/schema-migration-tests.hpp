@@ -0,0 +1,204 @@
+#ifndef SCHEMAMIGRATIONTESTS_HPP
+#define SCHEMAMIGRATIONTESTS_HPP
+
+#include <bandit/bandit.h>
+
+using namespace snowhouse;
+using namespace bandit;
+
+#include <Internal/SchemaMigration.hpp>
+#include <TokenDatabase.hpp>
+#include "token-database-fixture.hpp"
+
+#include <sqlite/sqlite3.h>
+#include <sqlite_modern_cpp.h>
+
+#include <cstdio>
+#include <memory>
+
+// synthetic vault at version 1 with the minimal config records
+static std::shared_ptr<sqlite::database> makeSyntheticVault(const SchemaMigration::Version &version)
+{
+    auto db = std::make_shared<sqlite::database>(":memory:");
+    (*db) << "create table config (id text PRIMARY KEY NOT NULL, data blob);";
+    (*db) << "insert into config values ('database', ?);" << std::vector<SchemaMigration::Version>{version};
+    (*db) << "create table tokens (id INTEGER PRIMARY KEY NOT NULL, label text NOT NULL);";
+    (*db) << "insert into tokens (label) values ('first'), ('second');";
+    return db;
+}
+
+static bool hasColumn(sqlite::database &db, const std::string &table, const std::string &column)
+{
+    int count = 0;
+    db << "select count(*) from pragma_table_info(?) where name = ?;" << table << column >> count;
+    return count == 1;
+}
+
+static const SchemaMigration::StepList syntheticSteps = {
+    {1, 2, "add note column", [](sqlite::database &db) {
+        db << "alter table tokens add column note text;";
+        db << "update tokens set note = label || '!';";
+        return true;
+    }},
+    {2, 3, "index labels", [](sqlite::database &db) {
+        db << "create index tokens_label on tokens (label);";
+        return true;
+    }},
+};
+
+// tokens table as created by 0x0f000005 with BLOB serialized numbers
+static std::shared_ptr<sqlite::database> makeVersion5Vault()
+{
+    auto db = makeSyntheticVault(0x0f000005);
+    (*db) << "drop table tokens;";
+    (*db) << "create table types (id int(1) PRIMARY KEY NOT NULL, name text);";
+    (*db) << "create table algorithms (id int(1) PRIMARY KEY NOT NULL, name text);";
+    (*db) << "create table tokens (id INTEGER PRIMARY KEY NOT NULL, type int(1) NOT NULL, "
+             "label text NOT NULL UNIQUE COLLATE NOCASE, icon blob, secret text NOT NULL, "
+             "digits blob, period blob, counter blob, algorithm int(1) NOT NULL);";
+    (*db) << "insert into tokens values (?, ?, ?, ?, ?, ?, ?, ?, ?);"
+          << 1 << 1 << "totp" << std::vector<std::uint8_t>{1, 2, 3} << "secret"
+          << std::vector<std::uint8_t>{8} << std::vector<std::uint32_t>{45}
+          << std::vector<std::uint32_t>{0} << 2;
+    (*db) << "insert into tokens values (?, ?, ?, ?, ?, ?, ?, ?, ?);"
+          << 2 << 2 << "hotp" << std::vector<std::uint8_t>{} << "secret"
+          << std::vector<std::uint8_t>{6} << std::vector<std::uint32_t>{}
+          << std::vector<std::uint32_t>{0xFFFFFFFF} << 1;
+    return db;
+}
+
+go_bandit([]{
+    describe("SchemaMigration Test", []{
+        it("[upgrade synthetic vault]", [&]{
+            auto db = makeSyntheticVault(1);
+            SchemaMigration::Version version = 1;
+
+            const auto res = SchemaMigration::migrate(*db, version, syntheticSteps, 3);
+            AssertThat(res, Equals(SchemaMigration::Migrated));
+            AssertThat(version, Equals(3U));
+
+            SchemaMigration::Version stored = 0;
+            AssertThat(SchemaMigration::readVersion(*db, stored), Equals(true));
+            AssertThat(stored, Equals(3U));
+
+            AssertThat(hasColumn(*db, "tokens", "note"), Equals(true));
+            std::string note;
+            (*db) << "select note from tokens where label = 'second';" >> note;
+            AssertThat(note, Equals(std::string("second!")));
+
+            SchemaMigration::Fingerprint fingerprint;
+            AssertThat(SchemaMigration::readFingerprint(*db, fingerprint), Equals(true));
+            AssertThat(fingerprint == SchemaMigration::fingerprint(*db), Equals(true));
+        });
+
+        it("[partial upgrade]", [&]{
+            auto db = makeSyntheticVault(2);
+            SchemaMigration::Version version = 2;
+
+            const auto res = SchemaMigration::migrate(*db, version, syntheticSteps, 3);
+            AssertThat(res, Equals(SchemaMigration::Migrated));
+            AssertThat(version, Equals(3U));
+            AssertThat(hasColumn(*db, "tokens", "note"), Equals(false));
+        });
+
+        it("[failed step rolls back]", [&]{
+            auto db = makeSyntheticVault(1);
+            SchemaMigration::Version version = 1;
+
+            auto steps = syntheticSteps;
+            steps.at(1).apply = [](sqlite::database &db) {
+                db << "create index tokens_label on no_such_table (label);";
+                return true;
+            };
+
+            const auto res = SchemaMigration::migrate(*db, version, steps, 3);
+            AssertThat(res, Equals(SchemaMigration::Failed));
+            AssertThat(version, Equals(1U));
+
+            SchemaMigration::Version stored = 0;
+            SchemaMigration::readVersion(*db, stored);
+            AssertThat(stored, Equals(1U));
+            AssertThat(hasColumn(*db, "tokens", "note"), Equals(false));
+        });
+
+        it("[no upgrade path]", [&]{
+            auto db = makeSyntheticVault(1);
+            SchemaMigration::Version version = 1;
+
+            const SchemaMigration::StepList steps = {syntheticSteps.at(1)};
+            AssertThat(SchemaMigration::migrate(*db, version, steps, 3), Equals(SchemaMigration::NoPath));
+            AssertThat(version, Equals(1U));
+        });
+
+        it("[newer vault]", [&]{
+            auto db = makeSyntheticVault(4);
+            SchemaMigration::Version version = 4;
+            AssertThat(SchemaMigration::migrate(*db, version, syntheticSteps, 3), Equals(SchemaMigration::TooNew));
+        });
+
+        it("[fingerprint tracks schema]", [&]{
+            auto db = makeSyntheticVault(1);
+            const auto before = SchemaMigration::fingerprint(*db);
+            (*db) << "insert into tokens (label) values ('third');";
+            AssertThat(before == SchemaMigration::fingerprint(*db), Equals(true));
+            (*db) << "create index tokens_label on tokens (label);";
+            AssertThat(before == SchemaMigration::fingerprint(*db), Equals(false));
+        });
+
+        it("[integer columns]", [&]{
+            auto db = makeVersion5Vault();
+            SchemaMigration::Version version = 0x0f000005;
+
+            AssertThat(SchemaMigration::migrate(*db, version), Equals(SchemaMigration::Migrated));
+            AssertThat(version, Equals(SchemaMigration::CurrentVersion));
+
+            std::string type;
+            (*db) << "select lower(type) from pragma_table_info('tokens') where name = 'counter';" >> type;
+            AssertThat(type, Equals(std::string("integer")));
+
+            (*db) << "select digits, period, counter, icon from tokens where label = 'totp';"
+                  >> [](int digits, int period, std::uint64_t counter, const std::vector<std::uint8_t> &icon)
+            {
+                AssertThat(digits, Equals(8));
+                AssertThat(period, Equals(45));
+                AssertThat(counter, Equals(0U));
+                AssertThat(icon.size(), Equals(3U));
+            };
+
+            (*db) << "select digits, period, counter from tokens where label = 'hotp';"
+                  >> [](int digits, int period, std::uint64_t counter)
+            {
+                AssertThat(digits, Equals(6));
+                AssertThat(period, Equals(0));
+                AssertThat(counter, Equals(0xFFFFFFFFU));
+            };
+        });
+
+        it("[reload current vault]", [&]{
+            const auto path = createTestDatabase("migration");
+            TokenDatabase::closeDatabase();
+
+            // reloaded databases must be able to grow
+            AssertThat(TokenDatabase::loadTokens(), Equals(TokenDatabase::Success));
+            for (auto i = 0; i < 50; ++i)
+            {
+                OTPToken token(OTPToken::TOTP, "token " + std::to_string(i), OTPToken::Icon(1024, 0xFF), "ABCDEFGH");
+                AssertThat(TokenDatabase::insertToken(token), Equals(TokenDatabase::Success));
+            }
+            OTPToken hotp(OTPToken::HOTP, "hotp", {}, "ABCDEFGH", 6, 0, 0x100000000ULL, OTPToken::SHA1);
+            AssertThat(TokenDatabase::insertToken(hotp), Equals(TokenDatabase::Success));
+            AssertThat(TokenDatabase::saveTokens(), Equals(TokenDatabase::Success));
+            TokenDatabase::closeDatabase();
+
+            AssertThat(TokenDatabase::loadTokens(), Equals(TokenDatabase::Success));
+            AssertThat(TokenDatabase::tokenCount(), Equals(51));
+            AssertThat(TokenDatabase::selectToken("hotp").counter(), Equals(0x100000000ULL));
+            AssertThat(TokenDatabase::selectToken("token 7").period(), Equals(30U));
+            TokenDatabase::closeDatabase();
+
+            std::remove(path.c_str());
+        });
+    });
+});
+
+#endif // SCHEMAMIGRATIONTESTS_HPP
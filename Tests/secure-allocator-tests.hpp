@@ -0,0 +1,58 @@
+#ifndef SECUREALLOCATORTESTS_HPP
+#define SECUREALLOCATORTESTS_HPP
+
+#include <bandit/bandit.h>
+
+using namespace snowhouse;
+using namespace bandit;
+
+#include <SecureAllocator.hpp>
+#include <OTPToken.hpp>
+
+#include <algorithm>
+
+go_bandit([]{
+    describe("SecureAllocator Test", []{
+        it("[zero on free]", [&]{
+            const auto before = SecureArena::statistics();
+
+            // small blocks are reused through the free lists, freed blocks are
+            // zeroed apart from the free list link at the start
+            auto small = static_cast<unsigned char*>(SecureArena::allocate(100));
+            std::fill(small, small + 100, 0xAB);
+            AssertThat(SecureArena::statistics().used, Equals(before.used + 128U));
+            SecureArena::deallocate(small, 100);
+            AssertThat(std::all_of(small + sizeof(void*), small + 128, [](unsigned char c) { return c == 0U; }), Equals(true));
+            AssertThat(SecureArena::allocate(120), Equals(static_cast<void*>(small)));
+            SecureArena::deallocate(small, 120);
+
+            // large buffers are mapped separately and released on free
+            const std::size_t large_size = 3 * SecureArena::SlabSize;
+            auto large = static_cast<unsigned char*>(SecureArena::allocate(large_size));
+            std::fill(large, large + large_size, 0xCD);
+            AssertThat(SecureArena::statistics().capacity, IsGreaterThanOrEqualTo(before.capacity + large_size));
+            SecureArena::deallocate(large, large_size);
+
+            const auto after = SecureArena::statistics();
+            AssertThat(after.used, Equals(before.used));
+            AssertThat(after.slabs, IsGreaterThanOrEqualTo(1U));
+        });
+
+        it("[secure strings]", [&]{
+            SecureString secret("HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ");
+            AssertThat(secret == std::string("HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ"), Equals(true));
+            AssertThat(std::string("HXDMVJECJJWSRB3H") != secret, Equals(true));
+
+            SecureBuffer buffer(secret.begin(), secret.end());
+            AssertThat(buffer.size(), Equals(secret.size()));
+
+            OTPToken token(OTPToken::TOTP, "label", OTPToken::Icon(), std::string("HXDMVJECJJWSRB3HWIZR4IFUGFTMXBOZ"));
+            const auto copy = token;
+            AssertThat(copy.secret(), Equals(secret));
+            AssertThat(copy.secret().data() != token.secret().data(), Equals(true));
+            AssertThat(copy.generateToken(), Equals(token.generateToken()));
+        });
+    });
+});
+
+#endif // SECUREALLOCATORTESTS_HPP
@@ -0,0 +1,62 @@
+#ifndef STATEMENTPROFILERTESTS_HPP
+#define STATEMENTPROFILERTESTS_HPP
+
+#include <bandit/bandit.h>
+
+using namespace snowhouse;
+using namespace bandit;
+
+#include <Internal/StatementProfiler.hpp>
+#include <TokenDatabase.hpp>
+#include "token-database-fixture.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+go_bandit([]{
+    describe("StatementProfiler Test", []{
+        it("[normalize]", [&]{
+            AssertThat(StatementProfiler::normalize("SELECT * FROM 'tokens'  WHERE label like 'it''s' escape '\\' ;"),
+                       Equals(std::string("select * from ? where label like ? escape ?")));
+            AssertThat(StatementProfiler::normalize("select * from \"tokens\" where id = ?1 and t2 = 42.5"),
+                       Equals(std::string("select * from \"tokens\" where id = ? and t2 = ?")));
+            AssertThat(StatementProfiler::normalize("order by case id when 3 then 0 when 1 then 1 when 2 then 2 end;"),
+                       Equals(std::string("order by case id when ? then ? ... end")));
+            AssertThat(StatementProfiler::normalize("insert into t (a, b) values (1, x'00ff', 'c');"),
+                       Equals(std::string("insert into t (a, b) values (?, ...)")));
+        });
+
+        it("[token database statements]", [&]{
+            const auto path = createTestDatabase("statement-profiler");
+            insertTestTokens(20);
+
+            TokenDatabase::setStatementProfiling(true);
+            AssertThat(TokenDatabase::statementProfiling(), Equals(true));
+            for (auto i = 0; i < 3; ++i)
+            {
+                AssertThat(TokenDatabase::selectTokens().size(), Equals(20U));
+                AssertThat(TokenDatabase::forEachToken([](const OTPToken &) {}), Equals(TokenDatabase::Success));
+            }
+
+            const auto stats = StatementProfiler::statistics();
+            const auto byId = std::find_if(stats.begin(), stats.end(), [](const StatementProfiler::Statistics &s) {
+                return s.statement == "select * from ? where id = ?";
+            });
+            AssertThat(byId != stats.end(), Equals(true));
+            AssertThat(byId->calls, Equals(60U));
+            AssertThat(byId->rows, Equals(60U));
+            AssertThat(byId->p99, IsGreaterThanOrEqualTo(byId->p50));
+
+            const auto profile = TokenDatabase::statementProfile();
+            AssertThat(profile, Contains("SQL statement profile"));
+            AssertThat(profile, Contains("when ? then ? ..."));
+            AssertThat(profile, Contains("USING INTEGER PRIMARY KEY"));
+
+            TokenDatabase::setStatementProfiling(false);
+            TokenDatabase::closeDatabase();
+            std::remove(path.c_str());
+        });
+    });
+});
+
+#endif // STATEMENTPROFILERTESTS_HPP
@@ -0,0 +1,67 @@
+#ifndef TOKENCATALOGTESTS_HPP
+#define TOKENCATALOGTESTS_HPP
+
+#include <bandit/bandit.h>
+
+using namespace snowhouse;
+using namespace bandit;
+
+#include <TokenCatalog.hpp>
+
+#include <OTPToken.hpp>
+#include <TokenDatabase.hpp>
+
+#include <atomic>
+#include <thread>
+
+go_bandit([]{
+    describe("TokenCatalog Test", []{
+        it("[built-in names]", [&]{
+            AssertThat(std::string(TokenCatalog::typeName(OTPToken::TOTP)), Equals(std::string("TOTP")));
+            AssertThat(std::string(TokenCatalog::typeName(OTPToken::Steam)), Equals(std::string("Steam")));
+            AssertThat(std::string(TokenCatalog::algorithmName(OTPToken::SHA512)), Equals(std::string("SHA512")));
+        });
+
+        it("[reverse lookup]", [&]{
+            AssertThat(TokenCatalog::typeId("HOTP"), Equals(OTPToken::sqliteTypesID(OTPToken::HOTP)));
+            AssertThat(TokenCatalog::algorithmId("SHA256"), Equals(OTPToken::sqliteAlgorithmsID(OTPToken::SHA256)));
+        });
+
+        it("[unknown values]", [&]{
+            AssertThat(TokenCatalog::typeName(OTPToken::None).empty(), Equals(true));
+            AssertThat(TokenCatalog::typeName(100).empty(), Equals(true));
+            AssertThat(TokenCatalog::typeName(-1).empty(), Equals(true));
+            AssertThat(TokenCatalog::algorithmId("MD5"), Equals(OTPToken::sqliteAlgorithmsID(OTPToken::Invalid)));
+        });
+
+        it("[token names]", [&]{
+            OTPToken token(OTPToken::Steam, "label");
+            AssertThat(std::string(token.typeName()), Equals(std::string("Steam")));
+            AssertThat(std::string(token.algorithmName()), Equals(std::string("SHA1")));
+        });
+
+        it("[reload while reading]", [&]{
+            // closeDatabase() restores the built-in catalog
+            std::atomic<bool> done{false};
+            std::size_t mismatches = 0;
+            std::thread reader([&]{
+                while (!done)
+                {
+                    mismatches += TokenCatalog::typeName(OTPToken::HOTP) != "HOTP";
+                    mismatches += TokenCatalog::algorithmId("SHA512") != OTPToken::SHA512;
+                }
+            });
+
+            for (auto i = 0; i < 2000; ++i)
+            {
+                TokenDatabase::closeDatabase();
+            }
+            done = true;
+            reader.join();
+
+            AssertThat(mismatches, Equals(0U));
+        });
+    });
+});
+
+#endif // TOKENCATALOGTESTS_HPP
@@ -0,0 +1,36 @@
+#ifndef TOKENDATABASEFIXTURE_HPP
+#define TOKENDATABASEFIXTURE_HPP
+
+#include <bandit/bandit.h>
+
+using namespace snowhouse;
+using namespace bandit;
+
+#include <TokenDatabase.hpp>
+
+#include <cstddef>
+#include <string>
+
+// creates and opens the empty vault "tokens.<name>-test.db" with the password
+// "<name>-test", returns its path; the caller removes the file
+inline std::string createTestDatabase(const std::string &name, const std::string &directory = std::string())
+{
+    const auto path = (directory.empty() ? std::string() : directory + "/") + "tokens." + name + "-test.db";
+    TokenDatabase::setPassword(name + "-test");
+    TokenDatabase::setTokenDatabase(path);
+    AssertThat(TokenDatabase::initializeTokens(), Equals(TokenDatabase::Success));
+    return path;
+}
+
+// inserts the TOTP tokens "token 0" to "token <count - 1>" into the open vault
+inline void insertTestTokens(std::size_t count, const std::string &secret = "JBSWY3DPEHPK3PXP")
+{
+    TokenDatabase::OTPTokenList tokens;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        tokens.emplace_back(OTPToken::TOTP, "token " + std::to_string(i), OTPToken::Icon(), secret);
+    }
+    AssertThat(TokenDatabase::insertTokens(tokens), Equals(TokenDatabase::Success));
+}
+
+#endif // TOKENDATABASEFIXTURE_HPP
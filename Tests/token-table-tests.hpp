@@ -0,0 +1,127 @@
+#ifndef TOKENTABLETESTS_HPP
+#define TOKENTABLETESTS_HPP
+
+#include <bandit/bandit.h>
+
+using namespace snowhouse;
+using namespace bandit;
+
+#include <TokenTable.hpp>
+#include <TokenDatabase.hpp>
+#include "token-database-fixture.hpp"
+
+#include <cstdio>
+
+go_bandit([]{
+    describe("TokenTable Test", []{
+        const OTPToken::Icon icon{0x89, 0x50, 0x4e, 0x47};
+
+        const auto makeTable = [&]{
+            TokenTable table;
+            table.append(OTPToken(OTPToken::TOTP, "totp", icon, "XYZA123456KDDK83D", 6, 30, 0, OTPToken::SHA1));
+            table.append(OTPToken(OTPToken::TOTP, "totp 7", icon, "XYZA123456KDDK83D28273", 7, 10, 0, OTPToken::SHA1));
+            table.append(OTPToken(OTPToken::HOTP, "hotp", {}, "XYZA123456KDDK83D", 6, 0, 12, OTPToken::SHA1));
+            table.append(OTPToken(OTPToken::Steam, "steam", {}, "ABC30WAY33X57CCBU3EAXGDDMX35S39M", 5, 30, 0, OTPToken::SHA1));
+            table.append(OTPToken(OTPToken::TOTP, "invalid", {}, "!!!", 6, 30, 0, OTPToken::SHA1));
+            return table;
+        };
+
+        it("[generate all rows]", [&]{
+            const auto table = makeTable();
+            TokenTable::CodeList codes;
+            table.generate(1536573862, codes);
+
+            AssertThat(codes.size(), Equals(5U));
+            AssertThat(codes.at(0), Equals(std::string("122810")));
+            AssertThat(codes.at(1), Equals(std::string("8578249")));
+            AssertThat(codes.at(2), Equals(std::string("534003")));
+            AssertThat(codes.at(3), Equals(std::string("GQTTM")));
+            AssertThat(codes.at(4), IsEmpty());
+            AssertThat(table.hasKey(4), IsFalse());
+
+            // parallel sweep produces the same codes
+            TokenTable::CodeList parallel;
+            table.generate(1536573862, parallel, 0);
+            AssertThat(parallel, EqualsContainer(codes));
+        });
+
+        it("[labels and icons]", [&]{
+            const auto table = makeTable();
+
+            AssertThat(table.label(1), Equals(std::string_view("totp 7")));
+            AssertThat(table.find("steam"), Equals(3U));
+            AssertThat(table.find("missing"), Equals(table.size()));
+            AssertThat(table.generate(table.find("hotp"), 0), Equals(std::string("534003")));
+
+            // equal icons share one handle
+            AssertThat(table.iconCount(), Equals(1U));
+            AssertThat(table.iconHandle(0), Equals(table.iconHandle(1)));
+            AssertThat(table.iconHandle(2), Equals(TokenTable::NoIcon));
+            AssertThat(table.icon(table.iconHandle(0)), EqualsContainer(icon));
+            AssertThat(table.remainingValidity(0, 1536573862), Equals(8U));
+        });
+
+        it("[copy rows]", [&]{
+            const auto table = makeTable();
+
+            // a window of rows generates the same codes
+            TokenTable window;
+            window.append(table, 3);
+            window.append(table, 0);
+            window.append(table, 1);
+            AssertThat(window.size(), Equals(3U));
+            AssertThat(window.label(0), Equals(std::string_view("steam")));
+            AssertThat(window.generate(0, 1536573862), Equals(table.generate(3, 1536573862)));
+            AssertThat(window.generate(1, 1536573862), Equals(table.generate(0, 1536573862)));
+            AssertThat(window.id(2), Equals(table.id(1)));
+
+            AssertThat(window.iconCount(), Equals(1U));
+            AssertThat(window.iconHandle(0), Equals(TokenTable::NoIcon));
+            AssertThat(window.iconHandle(1), Equals(window.iconHandle(2)));
+            AssertThat(window.icon(window.iconHandle(1)), EqualsContainer(icon));
+        });
+
+        it("[paged cursor]", [&]{
+            const auto path = createTestDatabase("token-table");
+            insertTestTokens(10);
+            AssertThat(TokenDatabase::swapTokens("token 0", "token 9"), Equals(TokenDatabase::Success));
+
+            // pages follow the display order
+            TokenTable table;
+            for (std::size_t offset = 0; offset < 12; offset += 4)
+            {
+                AssertThat(TokenDatabase::forEachToken([&](const OTPToken &token) {
+                    table.append(token);
+                }, offset, 4), Equals(TokenDatabase::Success));
+            }
+
+            AssertThat(table.size(), Equals(10U));
+            AssertThat(table.label(0), Equals(std::string_view("token 9")));
+            AssertThat(table.label(4), Equals(std::string_view("token 4")));
+            AssertThat(table.label(9), Equals(std::string_view("token 0")));
+
+            // label filter, matches are returned in display order
+            TokenDatabase::DisplayOrder ids;
+            AssertThat(TokenDatabase::insertToken(OTPToken(OTPToken::TOTP, "Token 10%", OTPToken::Icon(), "JBSWY3DPEHPK3PXP")), Equals(TokenDatabase::Success));
+            AssertThat(TokenDatabase::selectTokenIds(ids, "KEN 9"), Equals(TokenDatabase::Success));
+            AssertThat(ids.size(), Equals(1U));
+            AssertThat(TokenDatabase::selectTokenIds(ids, "0"), Equals(TokenDatabase::Success));
+            AssertThat(ids.size(), Equals(2U));
+            AssertThat(TokenDatabase::selectTokenIds(ids, "%"), Equals(TokenDatabase::Success));
+            AssertThat(ids.size(), Equals(1U));
+            AssertThat(TokenDatabase::selectTokenIds(ids, "token"), Equals(TokenDatabase::Success));
+            AssertThat(ids.size(), Equals(11U));
+
+            std::vector<std::string> labels;
+            AssertThat(TokenDatabase::forEachToken([&](const OTPToken &token) {
+                labels.emplace_back(token.label());
+            }, TokenDatabase::DisplayOrder(ids.cbegin(), ids.cbegin() + 3)), Equals(TokenDatabase::Success));
+            AssertThat(labels, EqualsContainer(std::vector<std::string>{"token 9", "token 1", "token 2"}));
+
+            TokenDatabase::closeDatabase();
+            std::remove(path.c_str());
+        });
+    });
+});
+
+#endif // TOKENTABLETESTS_HPP
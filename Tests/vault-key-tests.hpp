@@ -0,0 +1,55 @@
+#ifndef VAULTKEYTESTS_HPP
+#define VAULTKEYTESTS_HPP
+
+#include <bandit/bandit.h>
+
+using namespace snowhouse;
+using namespace bandit;
+
+#include <TokenDatabase.hpp>
+#include "token-database-fixture.hpp"
+
+#include <cstdio>
+#include <string>
+
+go_bandit([]{
+    describe("Vault Key Test", []{
+        it("[export and import]", [&]{
+            const auto path = createTestDatabase("vault-key");
+            AssertThat(TokenDatabase::insertToken(OTPToken(OTPToken::TOTP, "vault", OTPToken::Icon(), "JBSWY3DPEHPK3PXP")), Equals(TokenDatabase::Success));
+            AssertThat(TokenDatabase::saveTokens(), Equals(TokenDatabase::Success));
+            TokenDatabase::closeDatabase();
+
+            const auto exported = TokenDatabase::exportKey();
+            const std::string key(exported.begin(), exported.end());
+            AssertThat(TokenDatabase::isExportedKey(key), Equals(true));
+            AssertThat(TokenDatabase::isExportedKey("vault-key-test"), Equals(false));
+
+            // unlocks without the password
+            TokenDatabase::setPassword("wrong password");
+            AssertThat(TokenDatabase::importKey(key), Equals(TokenDatabase::Success));
+            AssertThat(TokenDatabase::loadTokens(), Equals(TokenDatabase::Success));
+            AssertThat(TokenDatabase::tokenCount(), Equals(1));
+
+            // saving keeps the fingerprint
+            AssertThat(TokenDatabase::saveTokens(), Equals(TokenDatabase::Success));
+            AssertThat(TokenDatabase::importKey(key), Equals(TokenDatabase::Success));
+
+            // unknown versions and other databases are rejected
+            AssertThat(TokenDatabase::isExportedKey("otpgen-key:1:" + key.substr(13)), Equals(true));
+            AssertThat(TokenDatabase::importKey("otpgen-key:1:" + key.substr(13)), Equals(TokenDatabase::InvalidKey));
+            AssertThat(TokenDatabase::importKey("otpgen-key:3:" + key.substr(13)), Equals(TokenDatabase::InvalidKey));
+            AssertThat(TokenDatabase::importKey("otpgen-key:2:00:abc"), Equals(TokenDatabase::InvalidKey));
+            AssertThat(TokenDatabase::importKey(key.substr(0, key.size() - 2)), Equals(TokenDatabase::InvalidKey));
+
+            // a new password invalidates the key
+            AssertThat(TokenDatabase::changePassword("new password"), Equals(TokenDatabase::Success));
+            AssertThat(TokenDatabase::importKey(key), Equals(TokenDatabase::InvalidKey));
+            TokenDatabase::closeDatabase();
+
+            std::remove(path.c_str());
+        });
+    });
+});
+
+#endif // VAULTKEYTESTS_HPP